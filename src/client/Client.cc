@@ -393,6 +393,7 @@ Client::~Client()
 
   if (upkeeper.joinable())
     upkeeper.join();
+  stop_async_create_workers();
 
   // It is necessary to hold client_lock, because any inode destruction
   // may call into ObjectCacher, which asserts that it's lock (which is
@@ -583,6 +584,14 @@ void Client::_finish_init()
     plb.add_time_avg(l_c_wrlat, "wrlat", "Latency of a file data write operation");
     plb.add_time_avg(l_c_read, "rdlat", "Latency of a file data read operation");
     plb.add_time_avg(l_c_fsync, "fsync", "Latency of a file sync operation");
+    plb.add_u64_counter(l_c_readahead_bytes, "readahead_bytes",
+                        "Bytes requested by readahead", NULL, 0, unit_t(UNIT_BYTES));
+    plb.add_u64_counter(l_c_readahead_hit, "readahead_hit",
+                        "Bytes read that readahead had already requested",
+                        NULL, 0, unit_t(UNIT_BYTES));
+    plb.add_u64_counter(l_c_readahead_waste, "readahead_waste",
+                        "Bytes requested by readahead and never read",
+                        NULL, 0, unit_t(UNIT_BYTES));
     logger.reset(plb.create_perf_counters());
     cct->get_perfcounters_collection()->add(logger.get());
   }
@@ -646,6 +655,7 @@ void Client::shutdown()
 
     _close_sessions();
   }
+  stop_async_create_workers();
   cct->_conf.remove_observer(this);
 
   cct->get_admin_socket()->unregister_commands(&m_command_hook);
@@ -1688,13 +1698,10 @@ int Client::verify_reply_trace(int r, MetaSession *session,
 
      decode(ocres, extra_bl);
      created_ino = ocres.created_ino;
-     /*
-      * The userland cephfs client doesn't have a way to do an async create
-      * (yet), so just discard delegated_inos for now. Eventually we should
-      * store them and use them in create calls, even if they are synchronous,
-      * if only for testing purposes.
-      */
+     // keep the delegated inos for async creates (see _async_create())
      ldout(cct, 10) << "delegated_inos: " << ocres.delegated_inos << dendl;
+     for (auto p = ocres.delegated_inos.begin(); p != ocres.delegated_inos.end(); ++p)
+       session->delegated_inos.union_insert(p.get_start(), p.get_len());
     } else {
      // u64 containing number of created ino
      decode(created_ino, extra_bl);
@@ -1783,6 +1790,19 @@ int Client::make_request(MetaRequest *request,
 {
   int r = 0;
 
+  // anything but the create itself has to wait for a file created
+  // asynchronously to exist on the mds
+  if (num_async_creates && !(request->head.flags & CEPH_MDS_FLAG_ASYNC)) {
+    if (request->get_op() != CEPH_MDS_OP_CREATE)
+      wait_async_create(request->inode());
+    wait_async_create(request->old_inode());
+    wait_async_create(request->other_inode());
+    if (request->dentry())
+      wait_async_create(request->dentry()->inode.get());
+    if (request->old_dentry())
+      wait_async_create(request->old_dentry()->inode.get());
+  }
+
   // assign a unique tid
   ceph_tid_t tid = ++last_tid;
   request->set_tid(tid);
@@ -1916,6 +1936,13 @@ int Client::make_request(MetaRequest *request,
   ldout(cct, 20) << "lat " << lat << dendl;
   logger->tinc(l_c_lat, lat);
   logger->tinc(l_c_reply, lat);
+  {
+    Inode *in = request->inode();
+    if (!in && request->dentry())
+      in = request->dentry()->dir->parent_inode;
+    if (auto h = get_latency_histograms(in); h)
+      h->metadata.add(lat);
+  }
 
   put_request(request);
   return r;
@@ -2937,6 +2964,9 @@ void Client::send_reconnect(MetaSession *session)
 
   session->release.reset();
 
+  // the mds takes back the inos it delegated to us
+  session->delegated_inos.clear();
+
   // reset my cap seq number
   session->seq = 0;
   //connect to the mds' offload targets
@@ -2955,6 +2985,9 @@ void Client::send_reconnect(MetaSession *session)
        p != inode_map.end();
        ++p) {
     Inode *in = p->second;
+    // the mds learns about these from the replayed create
+    if (in->flags & I_ASYNC_CREATE)
+      continue;
     auto it = in->caps.find(mds);
     if (it != in->caps.end()) {
       if (allow_multi &&
@@ -3708,7 +3741,15 @@ static int adjust_caps_used_for_lazyio(int used, int issued, int implemented)
  */
 void Client::check_caps(Inode *in, unsigned flags)
 {
+  if (in->flags & I_ASYNC_CREATE) {
+    // the mds doesn't know the inode yet; _async_create_finish() checks again
+    ldout(cct, 10) << __func__ << " on " << *in << " deferred, create in flight" << dendl;
+    return;
+  }
+
   unsigned wanted = in->caps_wanted();
+  if (_async_create_wanted(in))
+    wanted |= CEPH_CAP_FILE_EXCL | CEPH_CAP_DIR_CREATE;
   unsigned used = get_caps_used(in);
   unsigned cap_used;
 
@@ -3846,7 +3887,7 @@ void Client::check_caps(Inode *in, unsigned flags)
 }
 
 
-void Client::queue_cap_snap(Inode *in, SnapContext& old_snapc)
+void Client::queue_cap_snap(Inode *in, const SnapContext& old_snapc)
 {
   int used = get_caps_used(in);
   int dirty = in->caps_dirty();
@@ -4883,7 +4924,7 @@ void Client::update_snap_trace(const bufferlist& bl, SnapRealm **realm_ret, bool
   SnapRealm *first_realm = NULL;
   ldout(cct, 10) << __func__ << " len " << bl.length() << dendl;
 
-  map<SnapRealm*, SnapContext> dirty_realms;
+  map<SnapRealm*, SnapContextRef> dirty_realms;
 
   auto p = bl.cbegin();
   while (!p.end()) {
@@ -4913,7 +4954,7 @@ void Client::update_snap_trace(const bufferlist& bl, SnapRealm **realm_ret, bool
 
 	  if (dirty_realms.count(realm) == 0) {
 	    realm->nref++;
-	    dirty_realms[realm] = realm->get_snap_context();
+	    dirty_realms[realm] = realm->get_snap_context_ref();
 	  }
 	}
       }
@@ -4948,10 +4989,10 @@ void Client::update_snap_trace(const bufferlist& bl, SnapRealm **realm_ret, bool
 
   for (auto &[realm, snapc] : dirty_realms) {
     // if there are new snaps ?
-    if (has_new_snaps(snapc, realm->get_snap_context())) {
+    if (has_new_snaps(*snapc, realm->get_snap_context())) {
       ldout(cct, 10) << " flushing caps on " << *realm << dendl;
       for (auto&& in : realm->inodes_with_caps) {
-	queue_cap_snap(in, snapc);
+	queue_cap_snap(in, *snapc);
       }
     } else {
       ldout(cct, 10) << " no new snap on " << *realm << dendl;
@@ -4978,7 +5019,7 @@ void Client::handle_snap(const MConstRef<MClientSnap>& m)
 
   got_mds_push(session);
 
-  map<Inode*, SnapContext> to_move;
+  map<Inode*, SnapContextRef> to_move;
   SnapRealm *realm = 0;
 
   if (m->head.op == CEPH_SNAP_OP_SPLIT) {
@@ -5006,7 +5047,7 @@ void Client::handle_snap(const MConstRef<MClientSnap>& m)
 
 
 	in->snaprealm_item.remove_myself();
-	to_move[in] = in->snaprealm->get_snap_context();
+	to_move[in] = in->snaprealm->get_snap_context_ref();
 	put_snap_realm(in->snaprealm);
       }
     }
@@ -5031,8 +5072,8 @@ void Client::handle_snap(const MConstRef<MClientSnap>& m)
       realm->inodes_with_caps.push_back(&in->snaprealm_item);
       realm->nref++;
       // queue for snap writeback
-      if (has_new_snaps(p->second, realm->get_snap_context()))
-	queue_cap_snap(in, p->second);
+      if (has_new_snaps(*p->second, realm->get_snap_context()))
+	queue_cap_snap(in, *p->second);
     }
     put_snap_realm(realm);
   }
@@ -5541,6 +5582,10 @@ void Client::handle_cap_grant(MetaSession *session, Inode *in, Cap *cap, const M
     else if (revoked & ceph_deleg_caps_for_type(CEPH_DELEGATION_WR))
       in->recall_deleg(true);
 
+    // the next create in here is synchronous and picks up the layout again
+    if (in->is_dir() && (revoked & CEPH_CAP_DIR_CREATE))
+      in->cached_layout = file_layout_t();
+
     used = adjust_caps_used_for_lazyio(used, cap->issued, cap->implemented);
     if ((used & revoked & (CEPH_CAP_FILE_BUFFER | CEPH_CAP_FILE_LAZYIO)) &&
 	!_flush(in, new C_Client_FlushComplete(this, in))) {
@@ -6392,11 +6437,20 @@ void Client::_unmount(bool abort)
     _abort_mds_sessions(-CEPHFS_ENOTCONN);
 
     objecter->op_cancel_writes(-CEPHFS_ENOTCONN);
+
+    while (!async_create_queue.empty()) {
+      async_create_t ac = std::move(async_create_queue.front());
+      async_create_queue.pop_front();
+      put_request(ac.req);
+      _async_create_finish(ac, -CEPHFS_ENOTCONN);
+    }
   } else {
     // flush the mdlog for pending requests, if any
     flush_mdlog_sync();
   }
 
+  wait_async_creates();
+
   mount_cond.wait(lock, [this] {
     if (!mds_requests.empty()) {
       ldout(cct, 10) << "waiting on " << mds_requests.size() << " requests"
@@ -6712,9 +6766,54 @@ void Client::collect_and_send_global_metrics() {
   }
   message.push_back(metric);
 
+  // latency histograms, only what was seen since the last report
+  if (!latency_subtrees.empty()) {
+    std::map<std::string, LatencyHistograms> subtrees;
+    for (auto &[ino, sub] : latency_subtrees)
+      subtrees[sub.first].merge(sub.second);
+    latency_subtrees.clear();
+    metric = ClientMetricMessage(LatencyHistogramsPayload(std::move(subtrees)));
+    message.push_back(metric);
+  }
+
   session->con->send_message2(make_message<MClientMetrics>(std::move(message)));
 }
 
+/*
+ * Ops are accounted to the nearest export-pinned or quota-limited
+ * directory above them, the usual way a file system is carved up between
+ * users and MDS ranks, and otherwise to the mount's root.
+ */
+LatencyHistograms *Client::get_latency_histograms(Inode *in)
+{
+  if (!root)
+    return nullptr;
+
+  Inode *sub = root.get();
+  for (Inode *cur = in; cur && cur != root.get() && cur != root_ancestor; ) {
+    if (cur->is_dir() && (cur->dir_pin >= 0 || cur->quota.is_enable())) {
+      sub = cur;
+      break;
+    }
+    if (cur->dentries.empty())
+      break;
+    cur = cur->get_first_parent()->dir->parent_inode;
+  }
+
+  auto it = latency_subtrees.find(sub->ino);
+  if (it == latency_subtrees.end()) {
+    if (sub != root.get() &&
+	latency_subtrees.size() >= cct->_conf.get_val<uint64_t>("client_metrics_latency_max_subtrees"))
+      return get_latency_histograms(root.get());
+    filepath path;
+    sub->make_long_path(path);
+    std::string s = path.get_ino() == CEPH_INO_ROOT ?
+      "/" + path.get_path() : stringify(path);
+    it = latency_subtrees.emplace(sub->ino, std::make_pair(s, LatencyHistograms())).first;
+  }
+  return &it->second.second;
+}
+
 void Client::renew_caps()
 {
   ldout(cct, 10) << "renew_caps()" << dendl;
@@ -8619,6 +8718,10 @@ int Client::_readdir_get_frag(dir_result_t *dirp)
   req->set_inode(diri.get());
   req->head.args.readdir.frag = fg;
   req->head.args.readdir.flags = CEPH_READDIR_REPLY_BITFLAGS;
+  req->head.args.readdir.max_entries =
+    cct->_conf.get_val<uint64_t>("client_readdir_max_entries");
+  req->head.args.readdir.max_bytes =
+    cct->_conf.get_val<Option::size_t>("client_readdir_max_bytes");
   if (dirp->last_name.length()) {
     req->path2.set_path(dirp->last_name);
   } else if (dirp->hash_order()) {
@@ -8922,21 +9025,7 @@ int Client::readdir_r_cb(dir_result_t *d, add_dirent_cb_t cb, void *p,
       continue;
     }
 
-    if (diri->shared_gen == dirp->start_shared_gen &&
-	diri->dir_release_count == dirp->release_count) {
-      if (diri->dir_ordered_count == dirp->ordered_count) {
-	ldout(cct, 10) << " marking (I_COMPLETE|I_DIR_ORDERED) on " << *diri << dendl;
-	if (diri->dir) {
-	  ceph_assert(diri->dir->readdir_cache.size() >= dirp->cache_index);
-	  diri->dir->readdir_cache.resize(dirp->cache_index);
-	}
-	diri->flags |= I_COMPLETE | I_DIR_ORDERED;
-      } else {
-	ldout(cct, 10) << " marking I_COMPLETE on " << *diri << dendl;
-	diri->flags |= I_COMPLETE;
-      }
-    }
-
+    _readdir_mark_complete(dirp);
     dirp->set_end();
     return 0;
   }
@@ -8944,6 +9033,31 @@ int Client::readdir_r_cb(dir_result_t *d, add_dirent_cb_t cb, void *p,
   return 0;
 }
 
+/*
+ * The rightmost frag of dirp has been read to the end: mark the
+ * directory complete if nothing was dropped from it since the read
+ * began.
+ */
+void Client::_readdir_mark_complete(dir_result_t *dirp)
+{
+  Inode *diri = dirp->inode.get();
+  if (diri->shared_gen != dirp->start_shared_gen ||
+      diri->dir_release_count != dirp->release_count)
+    return;
+
+  if (diri->dir_ordered_count == dirp->ordered_count) {
+    ldout(cct, 10) << " marking (I_COMPLETE|I_DIR_ORDERED) on " << *diri << dendl;
+    if (diri->dir) {
+      ceph_assert(diri->dir->readdir_cache.size() >= dirp->cache_index);
+      diri->dir->readdir_cache.resize(dirp->cache_index);
+    }
+    diri->flags |= I_COMPLETE | I_DIR_ORDERED;
+  } else {
+    ldout(cct, 10) << " marking I_COMPLETE on " << *diri << dendl;
+    diri->flags |= I_COMPLETE;
+  }
+}
+
 
 int Client::readdir_r(dir_result_t *d, struct dirent *de)
 {  
@@ -9028,6 +9142,44 @@ int Client::readdirplus_r(dir_result_t *d, struct dirent *de,
   return 0;
 }
 
+struct many_readdir {
+  struct dirent *des;
+  struct ceph_statx *stxs;
+  unsigned count;
+  unsigned filled;
+};
+
+static int _readdir_many_dirent_cb(void *p, struct dirent *de,
+				   struct ceph_statx *stx, off_t off,
+				   Inode *in)
+{
+  many_readdir *c = static_cast<many_readdir *>(p);
+
+  c->des[c->filled] = *de;
+  if (c->stxs)
+    c->stxs[c->filled] = *stx;
+  // stop once the caller's arrays are full
+  return ++c->filled == c->count ? 1 : 0;
+}
+
+int Client::readdirplus_many(dir_result_t *d, struct dirent *des,
+			     struct ceph_statx *stxs, unsigned count,
+			     unsigned want, unsigned flags)
+{
+  if (count == 0)
+    return -CEPHFS_EINVAL;
+
+  many_readdir mr;
+  mr.des = des;
+  mr.stxs = stxs;
+  mr.count = count;
+  mr.filled = 0;
+
+  int r = readdir_r_cb(d, _readdir_many_dirent_cb, (void *)&mr, want, flags);
+  if (r < 0 && mr.filled == 0)
+    return r;
+  return mr.filled;
+}
 
 /* getdents */
 struct getdents_result {
@@ -9415,6 +9567,12 @@ Fh *Client::_create_fh(Inode *in, int flags, int cmode, const UserPerm& perms)
   alignments.push_back(in->layout.stripe_unit);
   f->readahead.set_alignments(alignments);
 
+  f->read_pattern.set_max_streams(conf.get_val<uint64_t>("client_readahead_max_streams"));
+  f->read_pattern.set_min_bytes(conf->client_readahead_min);
+  f->read_pattern.set_max_bytes(max_readahead == Readahead::NO_LIMIT ?
+                                in->layout.get_period() : max_readahead);
+  f->read_pattern.set_alignment(in->layout.get_period());
+
   return f;
 }
 
@@ -9439,6 +9597,8 @@ int Client::_release_fh(Fh *f)
 
   _release_filelocks(f);
 
+  logger->inc(l_c_readahead_waste, f->read_pattern.reset());
+
   // Finally, read any async err (i.e. from flushes)
   int err = f->take_async_err();
   if (err != 0) {
@@ -9952,6 +10112,8 @@ success:
   lat = ceph_clock_now();
   lat -= start;
   logger->tinc(l_c_read, lat);
+  if (auto h = get_latency_histograms(in); h)
+    h->read.add(lat);
 
 done:
   // done!
@@ -10028,28 +10190,50 @@ int Client::_read_async(Fh *f, uint64_t off, uint64_t len, bufferlist *bl)
     put_cap_ref(in, CEPH_CAP_FILE_CACHE);
   }
 
+  if (uint64_t used = f->read_pattern.consume(off, len))
+    logger->inc(l_c_readahead_hit, used);
+
   if(f->readahead.get_min_readahead_size() > 0) {
-    pair<uint64_t, uint64_t> readahead_extent = f->readahead.update(off, len, in->size);
-    if (readahead_extent.second > 0) {
-      ldout(cct, 20) << "readahead " << readahead_extent.first << "~" << readahead_extent.second
-		     << " (caller wants " << off << "~" << len << ")" << dendl;
-      Context *onfinish2 = new C_Readahead(this, f);
-      int r2 = objectcacher->file_read(&in->oset, &in->layout, in->snapid,
-				       readahead_extent.first, readahead_extent.second,
-				       NULL, 0, onfinish2);
-      if (r2 == 0) {
-	ldout(cct, 20) << "readahead initiated, c " << onfinish2 << dendl;
-	get_cap_ref(in, CEPH_CAP_FILE_RD | CEPH_CAP_FILE_CACHE);
-      } else {
-	ldout(cct, 20) << "readahead was no-op, already cached" << dendl;
-	delete onfinish2;
+    vector<pair<uint64_t, uint64_t>> extents;
+    if (conf.get_val<uint64_t>("client_readahead_max_streams") > 0) {
+      extents = f->read_pattern.update(off, len, in->size);
+      logger->inc(l_c_readahead_waste, f->read_pattern.take_wasted());
+    } else {
+      auto readahead_extent = f->readahead.update(off, len, in->size);
+      if (readahead_extent.second > 0) {
+        f->read_pattern.note_prefetch(readahead_extent.first, readahead_extent.second);
+        extents.push_back(readahead_extent);
       }
     }
+    // issue them all before waiting on any, so extents in different
+    // objects are read from their OSDs in parallel
+    for (const auto& [ra_off, ra_len] : extents)
+      _readahead(f, ra_off, ra_len, off, len);
   }
 
   return r;
 }
 
+void Client::_readahead(Fh *f, uint64_t off, uint64_t len,
+                        uint64_t want_off, uint64_t want_len)
+{
+  Inode *in = f->inode.get();
+
+  ldout(cct, 20) << "readahead " << off << "~" << len
+                 << " (caller wants " << want_off << "~" << want_len << ")" << dendl;
+  logger->inc(l_c_readahead_bytes, len);
+  Context *onfinish = new C_Readahead(this, f);
+  int r = objectcacher->file_read(&in->oset, &in->layout, in->snapid,
+                                  off, len, NULL, 0, onfinish);
+  if (r == 0) {
+    ldout(cct, 20) << "readahead initiated, c " << onfinish << dendl;
+    get_cap_ref(in, CEPH_CAP_FILE_RD | CEPH_CAP_FILE_CACHE);
+  } else {
+    ldout(cct, 20) << "readahead was no-op, already cached" << dendl;
+    delete onfinish;
+  }
+}
+
 int Client::_read_sync(Fh *f, uint64_t off, uint64_t len, bufferlist *bl,
 		       bool *checkeof)
 {
@@ -10134,6 +10318,11 @@ int Client::write(int fd, const char *buf, loff_t size, loff_t offset)
   tout(cct) << size << std::endl;
   tout(cct) << offset << std::endl;
 
+  /* We can't return bytes written larger than INT_MAX, clamp size to that */
+  size = std::min(size, (loff_t)INT_MAX);
+  struct iovec iov = { const_cast<char*>(buf), (size_t)size };
+  bufferlist bl = copy_write_data(&iov, 1, size);
+
   std::scoped_lock lock(client_lock);
   Fh *fh = get_filehandle(fd);
   if (!fh)
@@ -10142,9 +10331,7 @@ int Client::write(int fd, const char *buf, loff_t size, loff_t offset)
   if (fh->flags & O_PATH)
     return -CEPHFS_EBADF;
 #endif
-  /* We can't return bytes written larger than INT_MAX, clamp size to that */
-  size = std::min(size, (loff_t)INT_MAX);
-  int r = _write(fh, offset, size, buf, NULL, false);
+  int r = _write(fh, offset, std::move(bl));
   ldout(cct, 3) << "write(" << fd << ", \"...\", " << size << ", " << offset << ") = " << r << dendl;
   return r;
 }
@@ -10156,16 +10343,9 @@ int Client::pwritev(int fd, const struct iovec *iov, int iovcnt, int64_t offset)
   return _preadv_pwritev(fd, iov, iovcnt, offset, true);
 }
 
-int64_t Client::_preadv_pwritev_locked(Fh *fh, const struct iovec *iov,
-                                       unsigned iovcnt, int64_t offset,
-                                       bool write, bool clamp_to_int)
+loff_t Client::iov_length(const struct iovec *iov, unsigned iovcnt,
+                          bool clamp_to_int)
 {
-    ceph_assert(ceph_mutex_is_locked_by_me(client_lock));
-
-#if defined(__linux__) && defined(O_PATH)
-    if (fh->flags & O_PATH)
-        return -CEPHFS_EBADF;
-#endif
     loff_t totallen = 0;
     for (unsigned i = 0; i < iovcnt; i++) {
         totallen += iov[i].iov_len;
@@ -10179,8 +10359,29 @@ int64_t Client::_preadv_pwritev_locked(Fh *fh, const struct iovec *iov,
     if (clamp_to_int) {
       totallen = std::min(totallen, (loff_t)INT_MAX);
     }
+    return totallen;
+}
+
+/*
+ * For writes, data is the caller's iovecs already run through
+ * copy_write_data(); callers copy before taking client_lock so that fh
+ * is never used across a dropped lock.
+ */
+int64_t Client::_preadv_pwritev_locked(Fh *fh, const struct iovec *iov,
+                                       unsigned iovcnt, int64_t offset,
+                                       bool write, bool clamp_to_int,
+                                       bufferlist&& data)
+{
+    ceph_assert(ceph_mutex_is_locked_by_me(client_lock));
+
+#if defined(__linux__) && defined(O_PATH)
+    if (fh->flags & O_PATH)
+        return -CEPHFS_EBADF;
+#endif
+    loff_t totallen = iov_length(iov, iovcnt, clamp_to_int);
     if (write) {
-        int64_t w = _write(fh, offset, totallen, NULL, iov, iovcnt);
+        ceph_assert(data.length() == (uint64_t)totallen);
+        int64_t w = _write(fh, offset, std::move(data));
         ldout(cct, 3) << "pwritev(" << fh << ", \"...\", " << totallen << ", " << offset << ") = " << w << dendl;
         return w;
     } else {
@@ -10216,18 +10417,47 @@ int Client::_preadv_pwritev(int fd, const struct iovec *iov, unsigned iovcnt, in
     tout(cct) << fd << std::endl;
     tout(cct) << offset << std::endl;
 
+    bufferlist bl;
+    if (write)
+      bl = copy_write_data(iov, iovcnt, iov_length(iov, iovcnt, true));
+
     std::scoped_lock cl(client_lock);
     Fh *fh = get_filehandle(fd);
     if (!fh)
       return -CEPHFS_EBADF;
-    return _preadv_pwritev_locked(fh, iov, iovcnt, offset, write, true);
+    return _preadv_pwritev_locked(fh, iov, iovcnt, offset, write, true,
+                                  std::move(bl));
+}
+
+/*
+ * Copy up to len bytes of the caller's data into one fresh buffer, since
+ * the write may be resubmitted or completed asynchronously.  Callers do
+ * this without client_lock held: for large writes the copy is most of the
+ * CPU time spent in the client and it touches no client state.
+ */
+bufferlist Client::copy_write_data(const struct iovec *iov, unsigned iovcnt,
+                                   uint64_t len)
+{
+  bufferlist bl;
+  if (len == 0)
+    return bl;
+  bufferptr bp = buffer::create(len);
+  uint64_t off = 0;
+  for (unsigned i = 0; i < iovcnt && off < len; i++) {
+    uint64_t n = std::min<uint64_t>(iov[i].iov_len, len - off);
+    bp.copy_in(off, n, (const char *)iov[i].iov_base);
+    off += n;
+  }
+  bp.set_length(off);
+  bl.push_back(std::move(bp));
+  return bl;
 }
 
-int64_t Client::_write(Fh *f, int64_t offset, uint64_t size, const char *buf,
-	                const struct iovec *iov, int iovcnt)
+int64_t Client::_write(Fh *f, int64_t offset, bufferlist&& bl)
 {
   ceph_assert(ceph_mutex_is_locked_by_me(client_lock));
 
+  uint64_t size = bl.length();
   uint64_t fpos = 0;
 
   if ((uint64_t)(offset+size) > mdsmap->get_max_filesize()) //too large!
@@ -10286,19 +10516,6 @@ int64_t Client::_write(Fh *f, int64_t offset, uint64_t size, const char *buf,
     ceph_assert(in->inline_version > 0);
   }
 
-  // copy into fresh buffer (since our write may be resub, async)
-  bufferlist bl;
-  if (buf) {
-    if (size > 0)
-      bl.append(buf, size);
-  } else if (iov){
-    for (int i = 0; i < iovcnt; i++) {
-      if (iov[i].iov_len > 0) {
-        bl.append((const char *)iov[i].iov_base, iov[i].iov_len);
-      }
-    }
-  }
-
   utime_t lat;
   uint64_t totalwritten;
   int want, have;
@@ -10367,7 +10584,7 @@ int64_t Client::_write(Fh *f, int64_t offset, uint64_t size, const char *buf,
 
     // async, caching, non-blocking.
     r = objectcacher->file_write(&in->oset, &in->layout,
-				 in->snaprealm->get_snap_context(),
+				 in->snaprealm->get_snap_context_ref(),
 				 offset, size, bl, ceph::real_clock::now(),
 				 0);
     put_cap_ref(in, CEPH_CAP_FILE_BUFFER);
@@ -10407,6 +10624,8 @@ success:
   lat = ceph_clock_now();
   lat -= start;
   logger->tinc(l_c_wrlat, lat);
+  if (auto h = get_latency_histograms(in); h)
+    h->write.add(lat);
 
   if (fpos) {
     lock_fh_pos(f);
@@ -10552,6 +10771,10 @@ int Client::_fsync(Inode *in, bool syncdataonly)
   utime_t start = ceph_clock_now(); 
 
   ldout(cct, 8) << "_fsync on " << *in << " " << (syncdataonly ? "(dataonly)":"(data+metadata)") << dendl;
+
+  // the file has to exist on the mds before its caps can be flushed
+  if (!syncdataonly)
+    wait_async_create(in);
   
   if (cct->_conf->client_oc) {
     object_cacher_completion.reset(new C_SaferCond("Client::_fsync::lock"));
@@ -10705,6 +10928,124 @@ int Client::statxat(int dirfd, const char *relpath,
   return r;
 }
 
+/*
+ * Whether _lookup() would be answered from the cache, i.e. the dentry
+ * is valid (or known not to exist) and the inode has the caps for mask.
+ */
+bool Client::_lookup_is_cached(Inode *dir, const string& dname, int mask)
+{
+  mask &= CEPH_CAP_ANY_SHARED | CEPH_STAT_RSTAT;
+  bool dir_shared = dir->caps_issued_mask(CEPH_CAP_FILE_SHARED, true);
+
+  if (!dir->dir || !dir->dir->dentries.count(dname))
+    return dir_shared && (dir->flags & I_COMPLETE);
+
+  Dentry *dn = dir->dir->dentries[dname];
+  if (dn->inode && !dn->inode->caps_issued_mask(mask, true))
+    return false;
+  if (_dentry_valid(dn))
+    return true;
+  return dir_shared && (dn->cap_shared_gen == dir->shared_gen ||
+			(!dn->inode && (dir->flags & I_COMPLETE)));
+}
+
+/*
+ * Read a whole directory from the MDS into the cache, without
+ * returning the entries to anyone.
+ */
+int Client::_readdir_fill_cache(Inode *diri, const UserPerm& perms)
+{
+  dir_result_t *dirp;
+  int r = _opendir(diri, &dirp, perms);
+  if (r < 0)
+    return r;
+
+  while (!dirp->at_end()) {
+    r = _readdir_get_frag(dirp);
+    if (r < 0)
+      break;
+    if (dirp->next_offset > 2) {
+      // more of this frag
+      _readdir_drop_dirp_buffer(dirp);
+      continue;
+    }
+    if (dirp->buffer_frag.is_rightmost())
+      _readdir_mark_complete(dirp);
+    _readdir_next_frag(dirp);
+    _readdir_drop_dirp_buffer(dirp);
+  }
+
+  _closedir(dirp);
+  return r;
+}
+
+int Client::statx_many(const char *relpath, const char * const *names,
+		       unsigned count, struct ceph_statx *stxs, int *rets,
+		       const UserPerm& perms, unsigned int want,
+		       unsigned int flags)
+{
+  RWRef_t mref_reader(mount_state, CLIENT_MOUNTING);
+  if (!mref_reader.is_state_satisfied())
+    return -CEPHFS_ENOTCONN;
+
+  ldout(cct, 3) << __func__ << " enter (relpath " << relpath << " count "
+		<< count << " want " << hex << want << dec << ")" << dendl;
+  tout(cct) << __func__ << " flags " << hex << flags << " want " << want << dec << std::endl;
+  tout(cct) << relpath << std::endl;
+
+  unsigned mask = statx_to_mask(flags, want);
+  bool follow = !(flags & AT_SYMLINK_NOFOLLOW);
+
+  std::scoped_lock lock(client_lock);
+
+  filepath path(relpath);
+  InodeRef diri;
+  int r = path_walk(path, &diri, perms, true, CEPH_CAP_FILE_SHARED);
+  if (r < 0)
+    return r;
+  if (!diri->is_dir())
+    return -CEPHFS_ENOTDIR;
+
+  // One readdir request returns up to client_readdir_max_entries inodes,
+  // with caps; read the directory if that takes fewer requests than
+  // looking up the names that are not cached one by one.
+  unsigned misses = 0;
+  for (unsigned i = 0; i < count; i++) {
+    if (!_lookup_is_cached(diri.get(), names[i], mask))
+      misses++;
+  }
+  if (misses > 1) {
+    uint64_t per_req = std::max<uint64_t>(1,
+      cct->_conf.get_val<uint64_t>("client_readdir_max_entries"));
+    uint64_t reqs = diri->dirstat.size() / per_req + 1;
+    ldout(cct, 10) << __func__ << " " << misses << " uncached, dir size "
+		   << diri->dirstat.size() << dendl;
+    if (reqs < misses) {
+      r = _readdir_fill_cache(diri.get(), perms);
+      if (r < 0)
+	ldout(cct, 10) << __func__ << " readdir failed " << r
+		       << ", looking up individually" << dendl;
+    }
+  }
+
+  for (unsigned i = 0; i < count; i++) {
+    InodeRef in;
+    rets[i] = _lookup(diri.get(), names[i], mask, &in, perms);
+    if (rets[i] == 0 && follow && in->is_symlink()) {
+      filepath p(relpath);
+      p.push_dentry(names[i]);
+      rets[i] = path_walk(p, &in, perms, true, mask);
+    }
+    if (rets[i] == 0)
+      rets[i] = _getattr(in, mask, perms);
+    if (rets[i] == 0)
+      fill_statx(in, mask, &stxs[i]);
+  }
+
+  ldout(cct, 3) << __func__ << " exit (relpath " << relpath << ")" << dendl;
+  return 0;
+}
+
 // not written yet, but i want to link!
 
 int Client::chdir(const char *relpath, std::string &new_cwd,
@@ -11325,6 +11666,7 @@ int Client::_sync_fs()
   }
 
   // flush caps
+  wait_async_creates();
   flush_caps_sync();
   ceph_tid_t flush_tid = last_flush_tid;
 
@@ -13195,9 +13537,29 @@ int Client::_create(Inode *dir, const char *name, int flags, mode_t mode,
     goto fail;
   req->set_dentry(de);
 
-  res = make_request(req, perms, inp, created);
-  if (res < 0) {
-    goto reply_error;
+  if (MetaSession *session = (stripe_unit || stripe_count || object_size ||
+			      pool_id >= 0 || xattrs_bl.length()) ?
+			     nullptr : _async_create_session(dir, de)) {
+    _async_create(dir, de, req, session, mode, inp, perms);
+    if (created)
+      *created = true;
+  } else {
+    bool did_create = false;
+    res = make_request(req, perms, inp, &did_create);
+    if (created)
+      *created = did_create;
+    if (res < 0) {
+      goto reply_error;
+    }
+    // files created here from now on can be created asynchronously
+    // with the same layout
+    if (did_create && !stripe_unit && !stripe_count && !object_size &&
+	pool_id < 0 && cct->_conf.get_val<bool>("client_async_create")) {
+      bool was_wanted = _async_create_wanted(dir);
+      dir->cached_layout = (*inp)->layout;
+      if (!was_wanted && _async_create_wanted(dir))
+	check_caps(dir, 0);
+    }
   }
 
   /* If the caller passed a value in fhp, do the open */
@@ -13221,6 +13583,184 @@ int Client::_create(Inode *dir, const char *name, int flags, mode_t mode,
   return res;
 }
 
+bool Client::_async_create_wanted(Inode *dir)
+{
+  return dir->is_dir() && dir->snapid == CEPH_NOSNAP &&
+    dir->cached_layout.is_valid() &&
+    cct->_conf.get_val<bool>("client_async_create");
+}
+
+/*
+ * Can a file named by the (negative) dentry dn be created without waiting
+ * for the mds?  That takes Fx and DIR_CREATE on the dir, which tell us no
+ * one else can create or look up names in it, a dentry we know to be
+ * negative and an inode number delegated by the dir's auth mds.
+ */
+MetaSession *Client::_async_create_session(Inode *dir, Dentry *dn)
+{
+  if (!_async_create_wanted(dir) || !dir->auth_cap)
+    return nullptr;
+  if (!dir->auth_cap->session->mds_features.test(CEPHFS_FEATURE_DELEG_INO))
+    return nullptr;
+  if (!dir->caps_issued_mask(CEPH_CAP_FILE_EXCL | CEPH_CAP_DIR_CREATE))
+    return nullptr;
+  if (dn->inode ||
+      (!(dir->flags & I_COMPLETE) && dn->cap_shared_gen != dir->shared_gen))
+    return nullptr;
+  // don't queue up more than the workers can get through quickly
+  if (num_async_creates >=
+      2 * cct->_conf.get_val<uint64_t>("client_async_create_max_inflight"))
+    return nullptr;
+
+  MetaSession *session = dir->auth_cap->session;
+  if (session->state != MetaSession::STATE_OPEN ||
+      session->delegated_inos.empty())
+    return nullptr;
+  return session;
+}
+
+void Client::_async_create(Inode *dir, Dentry *dn, MetaRequest *req,
+			   MetaSession *session, mode_t mode, InodeRef *inp,
+			   const UserPerm& perms)
+{
+  inodeno_t ino = session->delegated_inos.range_start();
+  session->delegated_inos.erase(ino);
+
+  // make up what the mds will reply with, including the auth cap it will
+  // issue to the creator; until the mds has the file, only we know of it
+  InodeStat st;
+  st.vino = vinodeno_t(ino, CEPH_NOSNAP);
+  st.layout = dir->cached_layout;
+  st.mode = mode;
+  st.uid = perms.uid();
+  st.gid = (dir->mode & S_ISGID) ? dir->gid : perms.gid();
+  st.nlink = 1;
+  st.ctime = st.btime = st.mtime = st.atime = ceph_clock_now();
+  st.truncate_seq = 1;
+  st.truncate_size = -1ull;
+  st.max_size = st.layout.stripe_unit;
+  st.inline_version = CEPH_INLINE_NONE;
+  st.dir_pin = MDS_RANK_NONE;
+  st.cap.caps = st.cap.wanted = CEPH_CAP_PIN | CEPH_CAP_ANY_SHARED |
+    CEPH_CAP_AUTH_EXCL | CEPH_CAP_XATTR_EXCL |
+    CEPH_CAP_ANY_FILE_RD | CEPH_CAP_ANY_FILE_WR;
+  st.cap.cap_id = 0;
+  st.cap.seq = 0;
+  st.cap.mseq = 0;
+  st.cap.realm = dir->snaprealm->ino;
+  st.cap.flags = CEPH_CAP_FLAG_AUTH;
+
+  InodeRef in = add_update_inode(&st, utime_t(), session, perms);
+  in->flags |= I_ASYNC_CREATE;
+  dir->async_creates++;
+  num_async_creates++;
+
+  // keep the dir complete; only its order changes
+  link(dn->dir, dn->name, in.get(), dn);
+  dn->cap_shared_gen = dir->shared_gen;
+  clear_dir_complete_and_ordered(dir, false);
+
+  ldout(cct, 10) << __func__ << " " << *in << " in " << *dir
+		 << ", " << num_async_creates << " in flight" << dendl;
+
+  req->head.ino = ino;
+  req->head.flags = req->head.flags | CEPH_MDS_FLAG_ASYNC;
+  async_create_queue.push_back(async_create_t{req, in, dir, perms});
+
+  auto max = cct->_conf.get_val<uint64_t>("client_async_create_max_inflight");
+  if (async_create_workers.size() < max &&
+      async_create_workers.size() < async_create_queue.size() + 1 &&
+      !async_create_stopping) {
+    async_create_workers.emplace_back([this] { async_create_entry(); });
+  }
+  async_create_cond.notify_one();
+
+  *inp = in;
+}
+
+void Client::_async_create_finish(async_create_t& ac, int r)
+{
+  Inode *in = ac.in.get();
+  Inode *dir = ac.dir.get();
+
+  in->flags &= ~I_ASYNC_CREATE;
+  dir->async_creates--;
+  num_async_creates--;
+
+  if (r == 0 && (in->dentries.empty() || !in->auth_cap || !in->auth_cap->cap_id)) {
+    // the mds created the file under another ino
+    r = -CEPHFS_ESTALE;
+  }
+
+  if (r < 0) {
+    lderr(cct) << "async create of " << *in << " in " << *dir << " failed: "
+	       << cpp_strerror(r) << dendl;
+    while (!in->dentries.empty())
+      unlink(in->get_first_parent(), true, false);
+    clear_dir_complete_and_ordered(dir, true);
+    if (in->caps_dirty()) {
+      in->mark_caps_clean();
+      put_inode(in);
+    }
+    if (in->auth_cap)
+      remove_cap(in->auth_cap, false);
+    in->nlink = 0;
+    in->set_async_err(r);
+    objectcacher->purge_set(&in->oset);
+  } else {
+    ldout(cct, 10) << __func__ << " " << *in << dendl;
+    check_caps(in, in->caps_dirty() ? CHECK_CAPS_NODELAY : 0);
+  }
+
+  signal_cond_list(waiting_for_async_create);
+}
+
+void Client::async_create_entry()
+{
+  std::unique_lock cl(client_lock);
+  while (true) {
+    async_create_cond.wait(cl, [this] {
+      return async_create_stopping || !async_create_queue.empty();
+    });
+    if (async_create_queue.empty())
+      break;
+
+    async_create_t ac = std::move(async_create_queue.front());
+    async_create_queue.pop_front();
+    int r = make_request(ac.req, ac.perms);
+    _async_create_finish(ac, r);
+  }
+}
+
+void Client::wait_async_create(Inode *in)
+{
+  while (in && ((in->flags & I_ASYNC_CREATE) || in->async_creates)) {
+    ldout(cct, 10) << __func__ << " on " << *in << dendl;
+    wait_on_list(waiting_for_async_create);
+  }
+}
+
+void Client::wait_async_creates()
+{
+  while (num_async_creates) {
+    ldout(cct, 10) << __func__ << " " << num_async_creates << " in flight" << dendl;
+    wait_on_list(waiting_for_async_create);
+  }
+}
+
+void Client::stop_async_create_workers()
+{
+  std::vector<std::thread> workers;
+  {
+    std::scoped_lock l{client_lock};
+    async_create_stopping = true;
+    async_create_cond.notify_all();
+    workers.swap(async_create_workers);
+  }
+  for (auto& t : workers)
+    t.join();
+}
+
 int Client::_mkdir(Inode *dir, const char *name, mode_t mode, const UserPerm& perm,
 		   InodeRef *inp, const std::map<std::string, std::string> &metadata,
                    std::string alternate_name)
@@ -14367,9 +14907,11 @@ int Client::ll_write(Fh *fh, loff_t off, loff_t len, const char *data)
 
   /* We can't return bytes written larger than INT_MAX, clamp len to that */
   len = std::min(len, (loff_t)INT_MAX);
+  struct iovec iov = { const_cast<char*>(data), (size_t)len };
+  bufferlist bl = copy_write_data(&iov, 1, len);
   std::scoped_lock lock(client_lock);
 
-  int r = _write(fh, off, len, data, NULL, 0);
+  int r = _write(fh, off, std::move(bl));
   ldout(cct, 3) << "ll_write " << fh << " " << off << "~" << len << " = " << r
 		<< dendl;
   return r;
@@ -14381,8 +14923,10 @@ int64_t Client::ll_writev(struct Fh *fh, const struct iovec *iov, int iovcnt, in
   if (!mref_reader.is_state_satisfied())
     return -CEPHFS_ENOTCONN;
 
+  bufferlist bl = copy_write_data(iov, iovcnt, iov_length(iov, iovcnt, false));
   std::scoped_lock cl(client_lock);
-  return _preadv_pwritev_locked(fh, iov, iovcnt, off, true, false);
+  return _preadv_pwritev_locked(fh, iov, iovcnt, off, true, false,
+                                std::move(bl));
 }
 
 int64_t Client::ll_readv(struct Fh *fh, const struct iovec *iov, int iovcnt, int64_t off)
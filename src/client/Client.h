@@ -42,12 +42,14 @@
 #include "MetaSession.h"
 #include "UserPerm.h"
 
+#include <deque>
 #include <fstream>
 #include <map>
 #include <memory>
 #include <set>
 #include <string>
 #include <thread>
+#include <vector>
 
 using std::set;
 using std::map;
@@ -77,6 +79,9 @@ enum {
   l_c_wrlat,
   l_c_read,
   l_c_fsync,
+  l_c_readahead_bytes,
+  l_c_readahead_hit,
+  l_c_readahead_waste,
   l_c_last,
 };
 
@@ -350,6 +355,14 @@ public:
   struct dirent * readdir(dir_result_t *d);
   int readdir_r(dir_result_t *dirp, struct dirent *de);
   int readdirplus_r(dir_result_t *dirp, struct dirent *de, struct ceph_statx *stx, unsigned want, unsigned flags, Inode **out);
+  /**
+   * Like readdirplus_r, but fill up to @a count entries at once.
+   * Returns the number of entries filled in, 0 at the end of the
+   * directory, or -errno.
+   */
+  int readdirplus_many(dir_result_t *dirp, struct dirent *des,
+		       struct ceph_statx *stxs, unsigned count,
+		       unsigned want, unsigned flags);
 
   int getdir(const char *relpath, std::list<std::string>& names,
 	     const UserPerm& perms);  // get the whole dir at once.
@@ -477,6 +490,15 @@ public:
   int statxat(int dirfd, const char *relpath,
               struct ceph_statx *stx, const UserPerm& perms,
               unsigned int want, unsigned int flags);
+  /**
+   * statx for @a count names in the directory @a relpath. When enough
+   * of them are not cached, the directory is read instead of looking
+   * each one up, since readdir replies carry the inodes and caps of
+   * many entries at once. The result for each name goes to @a rets.
+   */
+  int statx_many(const char *relpath, const char * const *names,
+		 unsigned count, struct ceph_statx *stxs, int *rets,
+		 const UserPerm& perms, unsigned int want, unsigned int flags);
   int fallocate(int fd, int mode, loff_t offset, loff_t length);
 
   // full path xattr ops
@@ -739,7 +761,7 @@ public:
   void put_cap_ref(Inode *in, int cap);
   void wait_sync_caps(Inode *in, ceph_tid_t want);
   void wait_sync_caps(ceph_tid_t want);
-  void queue_cap_snap(Inode *in, SnapContext &old_snapc);
+  void queue_cap_snap(Inode *in, const SnapContext &old_snapc);
   void finish_cap_snap(Inode *in, CapSnap &capsnap, int used);
 
   void _schedule_invalidate_dentry_callback(Dentry *dn, bool del);
@@ -1270,6 +1292,8 @@ private:
   void _readdir_rechoose_frag(dir_result_t *dirp);
   int _readdir_get_frag(dir_result_t *dirp);
   int _readdir_cache_cb(dir_result_t *dirp, add_dirent_cb_t cb, void *p, int caps, bool getref);
+  void _readdir_mark_complete(dir_result_t *dirp);
+  int _readdir_fill_cache(Inode *diri, const UserPerm& perms);
   void _closedir(dir_result_t *dirp);
 
   // other helpers
@@ -1288,8 +1312,11 @@ private:
 
   int _read_sync(Fh *f, uint64_t off, uint64_t len, bufferlist *bl, bool *checkeof);
   int _read_async(Fh *f, uint64_t off, uint64_t len, bufferlist *bl);
+  void _readahead(Fh *f, uint64_t off, uint64_t len,
+                  uint64_t want_off, uint64_t want_len);
 
   bool _dentry_valid(const Dentry *dn);
+  bool _lookup_is_cached(Inode *dir, const std::string& dname, int mask);
 
   // internal interface
   //   call these with client_lock held!
@@ -1349,14 +1376,33 @@ private:
 	      Fh **fhp, int stripe_unit, int stripe_count, int object_size,
 	      const char *data_pool, bool *created, const UserPerm &perms,
               std::string alternate_name);
+  struct async_create_t {
+    MetaRequest *req;
+    InodeRef in;
+    InodeRef dir;
+    UserPerm perms;
+  };
+  bool _async_create_wanted(Inode *dir);
+  MetaSession *_async_create_session(Inode *dir, Dentry *dn);
+  void _async_create(Inode *dir, Dentry *dn, MetaRequest *req, MetaSession *session,
+		     mode_t mode, InodeRef *inp, const UserPerm& perms);
+  void _async_create_finish(async_create_t& ac, int r);
+  void async_create_entry();
+  void wait_async_create(Inode *in);
+  void wait_async_creates();
+  void stop_async_create_workers();
 
   loff_t _lseek(Fh *fh, loff_t offset, int whence);
   int64_t _read(Fh *fh, int64_t offset, uint64_t size, bufferlist *bl);
-  int64_t _write(Fh *fh, int64_t offset, uint64_t size, const char *buf,
-          const struct iovec *iov, int iovcnt);
+  static bufferlist copy_write_data(const struct iovec *iov, unsigned iovcnt,
+                                    uint64_t len);
+  int64_t _write(Fh *fh, int64_t offset, bufferlist&& bl);
+  static loff_t iov_length(const struct iovec *iov, unsigned iovcnt,
+                           bool clamp_to_int);
   int64_t _preadv_pwritev_locked(Fh *fh, const struct iovec *iov,
                                  unsigned iovcnt, int64_t offset,
-                                 bool write, bool clamp_to_int);
+                                 bool write, bool clamp_to_int,
+                                 bufferlist&& data = bufferlist());
   int _preadv_pwritev(int fd, const struct iovec *iov, unsigned iovcnt,
                       int64_t offset, bool write);
   int _flush(Fh *fh);
@@ -1447,6 +1493,7 @@ private:
 
   void collect_and_send_metrics();
   void collect_and_send_global_metrics();
+  LatencyHistograms *get_latency_histograms(Inode *in);
 
   uint32_t deleg_timeout = 0;
 
@@ -1519,6 +1566,15 @@ private:
   ceph_tid_t oldest_tid = 0; // oldest incomplete mds request, excluding setfilelock requests
   map<ceph_tid_t, MetaRequest*> mds_requests;
 
+  // async creates, sent by a few worker threads since make_request()
+  // blocks until the reply
+  std::deque<async_create_t> async_create_queue;
+  std::vector<std::thread> async_create_workers;
+  ceph::condition_variable async_create_cond;
+  std::list<ceph::condition_variable*> waiting_for_async_create;
+  unsigned num_async_creates = 0;  // queued or in flight
+  bool async_create_stopping = false;
+
   // cap flushing
   ceph_tid_t last_flush_tid = 1;
 
@@ -1558,6 +1614,10 @@ private:
   uint64_t pinned_icaps = 0;
   uint64_t opened_inodes = 0;
 
+  // latencies since the last metrics report, per subtree root: its path
+  // and histograms
+  std::map<inodeno_t, std::pair<std::string, LatencyHistograms>> latency_subtrees;
+
   ceph::spinlock delay_i_lock;
   std::map<Inode*,int> delay_i_release;
 };
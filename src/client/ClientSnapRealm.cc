@@ -1,6 +1,9 @@
 // -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
 // vim: ts=8 sw=2 smarttab
 
+#include <algorithm>
+#include <iterator>
+
 #include "ClientSnapRealm.h"
 #include "common/Formatter.h"
 
@@ -9,33 +12,51 @@ using std::vector;
 
 void SnapRealm::build_snap_context()
 {
-  set<snapid_t> snaps;
+  SnapContextRef psnapc;
+  if (pparent)
+    psnapc = pparent->get_snap_context_ref();
+
   snapid_t max_seq = seq;
+  if (psnapc && psnapc->seq > max_seq)
+    max_seq = psnapc->seq;
 
-  // start with prior_parents?
-  for (unsigned i=0; i<prior_parent_snaps.size(); i++)
-    snaps.insert(prior_parent_snaps[i]);
-
-  // current parent's snaps
-  if (pparent) {
-    const SnapContext& psnapc = pparent->get_snap_context();
-    for (unsigned i=0; i<psnapc.snaps.size(); i++)
-      if (psnapc.snaps[i] >= parent_since)
-	snaps.insert(psnapc.snaps[i]);
-    if (psnapc.seq > max_seq)
-      max_seq = psnapc.seq;
+  // a realm with no snaps of its own that has been under its parent since
+  // before any of the parent's snaps sees exactly the parent's context
+  if (psnapc && my_snaps.empty() && prior_parent_snaps.empty() &&
+      max_seq == psnapc->seq &&
+      (psnapc->snaps.empty() || psnapc->snaps.back() >= parent_since)) {
+    cached_snap_context = psnapc;
+    cache_valid = true;
+    return;
   }
 
-  // my snaps
-  for (unsigned i=0; i<my_snaps.size(); i++)
-    snaps.insert(my_snaps[i]);
+  // everything below is kept sorted newest first, the order a SnapContext
+  // wants, so the parent's snaps are merged in rather than re-sorted
+  vector<snapid_t> mine;
+  mine.reserve(prior_parent_snaps.size() + my_snaps.size());
+  mine.insert(mine.end(), prior_parent_snaps.begin(), prior_parent_snaps.end());
+  mine.insert(mine.end(), my_snaps.begin(), my_snaps.end());
+  std::sort(mine.begin(), mine.end(), std::greater<snapid_t>());
+
+  auto snapc = std::make_shared<SnapContext>();
+  snapc->seq = max_seq;
+  if (psnapc) {
+    auto pend = std::upper_bound(psnapc->snaps.begin(), psnapc->snaps.end(),
+				 parent_since, std::greater<snapid_t>());
+    snapc->snaps.reserve(mine.size() + (pend - psnapc->snaps.begin()));
+    std::merge(mine.begin(), mine.end(), psnapc->snaps.begin(), pend,
+	       std::back_inserter(snapc->snaps), std::greater<snapid_t>());
+  } else {
+    snapc->snaps = std::move(mine);
+  }
+  snapc->snaps.erase(std::unique(snapc->snaps.begin(), snapc->snaps.end()),
+		     snapc->snaps.end());
 
-  // ok!
-  cached_snap_context.seq = max_seq;
-  cached_snap_context.snaps.resize(0);
-  cached_snap_context.snaps.reserve(snaps.size());
-  for (set<snapid_t>::reverse_iterator p = snaps.rbegin(); p != snaps.rend(); ++p)
-    cached_snap_context.snaps.push_back(*p);
+  if (!cached_snap_context ||
+      cached_snap_context->seq != snapc->seq ||
+      cached_snap_context->snaps != snapc->snaps)
+    cached_snap_context = std::move(snapc);
+  cache_valid = true;
 }
 
 void SnapRealm::dump(Formatter *f) const
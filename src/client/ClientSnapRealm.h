@@ -25,7 +25,11 @@ struct SnapRealm {
   std::set<SnapRealm*> pchildren;
 
 private:
-  SnapContext cached_snap_context;  // my_snaps + parent snaps + past_parent_snaps
+  // my_snaps + parent snaps + past_parent_snaps.  Immutable once built:
+  // the object cacher and cap snaps hold on to it, so a rebuild that comes
+  // out the same keeps the old one rather than handing out a new copy.
+  SnapContextRef cached_snap_context;
+  bool cache_valid = false;
   friend std::ostream& operator<<(std::ostream& out, const SnapRealm& r);
 
 public:
@@ -37,24 +41,31 @@ public:
 
   void build_snap_context();
   void invalidate_cache() {
-    cached_snap_context.clear();
+    cache_valid = false;
   }
 
-  const SnapContext& get_snap_context() {
-    if (cached_snap_context.seq == 0)
+  const SnapContextRef& get_snap_context_ref() {
+    if (!cache_valid)
       build_snap_context();
     return cached_snap_context;
   }
+  const SnapContext& get_snap_context() {
+    return *get_snap_context_ref();
+  }
 
   void dump(Formatter *f) const;
 };
 
 inline std::ostream& operator<<(std::ostream& out, const SnapRealm& r) {
-  return out << "snaprealm(" << r.ino << " nref=" << r.nref << " c=" << r.created << " seq=" << r.seq
-	     << " parent=" << r.parent
-	     << " my_snaps=" << r.my_snaps
-	     << " cached_snapc=" << r.cached_snap_context
-	     << ")";
+  out << "snaprealm(" << r.ino << " nref=" << r.nref << " c=" << r.created << " seq=" << r.seq
+      << " parent=" << r.parent
+      << " my_snaps=" << r.my_snaps
+      << " cached_snapc=";
+  if (r.cache_valid)
+    out << *r.cached_snap_context;
+  else
+    out << "(invalid)";
+  return out << ")";
 }
 
 #endif
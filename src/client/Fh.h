@@ -4,6 +4,7 @@
 #include "common/Readahead.h"
 #include "include/types.h"
 #include "InodeRef.h"
+#include "ReadPattern.h"
 #include "UserPerm.h"
 #include "mds/flock.h"
 
@@ -26,6 +27,7 @@ struct Fh {
   UserPerm actor_perms; // perms I opened the file with
 
   Readahead readahead;
+  ReadPattern read_pattern;  // strided/interleaved readahead, hit accounting
 
   // file lock
   std::unique_ptr<ceph_lock_state_t> fcntl_locks;
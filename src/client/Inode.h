@@ -113,6 +113,7 @@ struct CapSnap {
 #define I_KICK_FLUSH		(1 << 3)
 #define I_CAP_DROPPED		(1 << 4)
 #define I_ERROR_FILELOCK	(1 << 5)
+#define I_ASYNC_CREATE		(1 << 6)
 
 struct Inode : RefCountedObject {
   Client *client;
@@ -198,6 +199,8 @@ struct Inode : RefCountedObject {
   uint64_t dir_ordered_count = 1;
   bool dir_hashed = false;
   bool dir_replicated = false;
+  file_layout_t cached_layout;    // layout of the last file created in here
+  int async_creates = 0;          // creates in flight in this dir
 
   // per-mds caps
   std::map<mds_rank_t, Cap> caps;            // mds -> Cap
@@ -32,6 +32,7 @@ void MetaSession::dump(Formatter *f, bool cap_dump) const
   f->dump_stream("last_cap_renew_request") << last_cap_renew_request;
   f->dump_unsigned("cap_renew_seq", cap_renew_seq);
   f->dump_int("num_caps", caps.size());
+  f->dump_unsigned("num_delegated_inos", delegated_inos.size());
   if (cap_dump) {
     f->open_array_section("caps");
     for (const auto& cap : caps) {
@@ -4,6 +4,7 @@
 #ifndef CEPH_CLIENT_METASESSION_H
 #define CEPH_CLIENT_METASESSION_H
 
+#include "include/interval_set.h"
 #include "include/types.h"
 #include "include/utime.h"
 #include "include/xlist.h"
@@ -54,6 +55,9 @@ struct MetaSession {
   xlist<MetaRequest*> unsafe_requests;
   std::set<ceph_tid_t> flushing_caps_tids;
 
+  // inode numbers the mds lets us create files with asynchronously
+  interval_set<inodeno_t> delegated_inos;
+
   ceph::ref_t<MClientCapRelease> release;
 
   MetaSession(mds_rank_t mds_num, ConnectionRef con, const entity_addrvec_t& addrs)
@@ -0,0 +1,228 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#ifndef CEPH_CLIENT_READPATTERN_H
+#define CEPH_CLIENT_READPATTERN_H
+
+#include <algorithm>
+#include <vector>
+
+#include "include/interval_set.h"
+
+/*
+ * Per file handle read pattern detector.
+ *
+ * Readahead (common/Readahead.h) follows a single sequential stream and
+ * starts over on any other access.  This keeps a few streams per handle,
+ * each with its own stride, so it also recognises fixed-stride record
+ * reads and several sequential or strided streams interleaved on one
+ * handle.  A sequential stream is prefetched for as soon as it is seen;
+ * a strided one has to repeat its stride `stride_trigger` times first:
+ *
+ *  - a sequential stream (stride == read length) gets a contiguous window
+ *    that doubles on every hit up to max_bytes, with the end rounded to
+ *    the alignment unit (object or stripe) so whole objects are fetched;
+ *  - a strided stream gets the next few records, one extent each, so they
+ *    are fetched from their OSDs in parallel.  The number of records also
+ *    doubles on every hit, up to what fits in max_bytes.
+ *
+ * It also remembers what has been prefetched and not yet read, so the
+ * caller can account readahead hits and waste.  Not thread safe; the
+ * client calls it under client_lock.
+ */
+class ReadPattern {
+public:
+  typedef std::pair<uint64_t, uint64_t> extent_t;
+
+  void set_max_streams(unsigned n) {
+    max_streams = std::max(1u, n);
+    if (streams.size() > max_streams)
+      streams.resize(max_streams);
+  }
+  void set_stride_trigger(unsigned t) { stride_trigger = std::max(1u, t); }
+  void set_min_bytes(uint64_t b) { min_bytes = b; }
+  void set_max_bytes(uint64_t b) { max_bytes = b; }
+  void set_alignment(uint64_t a) { alignment = a; }
+
+  /**
+   * Record a read and return the extents to prefetch, which may be none.
+   * Extents never pass `limit` and never overlap what this stream has
+   * already prefetched.
+   */
+  std::vector<extent_t> update(uint64_t off, uint64_t len, uint64_t limit) {
+    std::vector<extent_t> r;
+    if (len == 0)
+      return r;
+    ++clock;
+
+    stream_t *s = match(off);
+    if (!s) {
+      s = victim();
+      *s = stream_t();
+      s->last_off = off;
+      s->len = len;
+      s->last_use = clock;
+      return r;
+    }
+    s->len = len;
+    s->last_off = off;
+    s->last_use = clock;
+    if (s->sequential)
+      s->stride = len;
+    if (s->hits < (s->sequential ? 1 : stride_trigger) || max_bytes == 0)
+      return r;
+
+    uint64_t from = std::max(s->ra_pos, off + len);
+    if (s->sequential) {
+      if (s->window == 0)
+	s->window = std::max(min_bytes, len);
+      else
+	s->window = std::min(max_bytes, s->window * 2);
+      uint64_t end = std::min(limit, off + len + s->window);
+      if (alignment && end < limit) {
+	uint64_t aligned = end - end % alignment;
+	end = aligned > from ? aligned : std::min(limit, aligned + alignment);
+      }
+      if (end > from)
+	r.emplace_back(from, end - from);
+      s->ra_pos = std::max(s->ra_pos, end);
+    } else {
+      uint64_t depth = std::clamp<uint64_t>(max_bytes / len, 1, MAX_STRIDE_DEPTH);
+      s->window = s->window ? std::min(depth, s->window * 2) : std::min<uint64_t>(depth, 2);
+      uint64_t next = off + s->stride;
+      for (uint64_t i = 0; i < s->window && next < limit; i++, next += s->stride) {
+	if (next + len <= s->ra_pos)
+	  continue;
+	r.emplace_back(next, std::min(len, limit - next));
+      }
+      if (!r.empty())
+	s->ra_pos = r.back().first + r.back().second;
+    }
+
+    for (const auto& [o, l] : r)
+      unread.union_insert(o, l);
+    // bound the bookkeeping by giving up on the lowest-offset extents;
+    // readers move forward, so those are the ones left furthest behind
+    while (unread.num_intervals() > MAX_UNREAD_EXTENTS) {
+      auto p = unread.begin();
+      wasted += p.get_len();
+      unread.erase(p);
+    }
+    return r;
+  }
+
+  /**
+   * Remember an extent prefetched by someone else (the plain sequential
+   * Readahead) so hits and waste are accounted the same way.
+   */
+  void note_prefetch(uint64_t off, uint64_t len) {
+    if (len)
+      unread.union_insert(off, len);
+  }
+
+  /// bytes of [off, off+len) that were prefetched and not read before
+  uint64_t consume(uint64_t off, uint64_t len) {
+    if (len == 0 || !unread.intersects(off, len))
+      return 0;
+    interval_set<uint64_t> rd, hit;
+    rd.insert(off, len);
+    hit.intersection_of(rd, unread);
+    unread.subtract(hit);
+    return hit.size();
+  }
+
+  /// prefetched bytes given up on since the last call
+  uint64_t take_wasted() {
+    uint64_t w = wasted;
+    wasted = 0;
+    return w;
+  }
+
+  /// forget everything, returning the prefetched bytes never read
+  uint64_t reset() {
+    uint64_t w = take_wasted() + unread.size();
+    unread.clear();
+    streams.clear();
+    return w;
+  }
+
+private:
+  // past this many unread extents the lowest-offset ones count as wasted
+  static const unsigned MAX_UNREAD_EXTENTS = 256;
+  static const unsigned MAX_STRIDE_DEPTH = 64;
+
+  struct stream_t {
+    uint64_t last_off = 0;
+    uint64_t len = 0;
+    uint64_t stride = 0;    // 0 until a second read is seen
+    bool sequential = false;  // each read starts where the last one ended
+    unsigned hits = 0;      // reads that matched the stride
+    uint64_t window = 0;    // readahead window, bytes or strided records
+    uint64_t ra_pos = 0;    // end of what has been prefetched
+    uint64_t last_use = 0;
+  };
+
+  stream_t *match(uint64_t off) {
+    // an established stride wins over a new one
+    for (auto& s : streams) {
+      if (s.stride && off == s.last_off + (s.sequential ? s.len : s.stride)) {
+	s.hits++;
+	return &s;
+      }
+    }
+    // otherwise the closest stream behind us, within the prefetch range.
+    // If it had settled on a stride, the reader has just broken it: start
+    // the stream over from its last read instead of going on predicting
+    // the old stride
+    stream_t *best = nullptr;
+    uint64_t reach = std::max(max_bytes, min_bytes);
+    for (auto& s : streams) {
+      if (off <= s.last_off || off - s.last_off > reach)
+	continue;
+      if (!best || s.last_off > best->last_off)
+	best = &s;
+    }
+    if (best) {
+      if (best->stride) {
+	stream_t s;
+	s.last_off = best->last_off;
+	s.len = best->len;
+	*best = s;
+      }
+      best->stride = off - best->last_off;
+      best->sequential = best->stride == best->len;
+      best->hits = 1;
+    }
+    return best;
+  }
+
+  stream_t *victim() {
+    if (streams.size() < max_streams)
+      return &streams.emplace_back();
+    return &*std::min_element(
+      streams.begin(), streams.end(),
+      [](const stream_t& a, const stream_t& b) { return a.last_use < b.last_use; });
+  }
+
+  unsigned max_streams = 4;
+  unsigned stride_trigger = 2;
+  uint64_t min_bytes = 0;
+  uint64_t max_bytes = 0;
+  uint64_t alignment = 0;
+  uint64_t clock = 0;
+  std::vector<stream_t> streams;
+
+  interval_set<uint64_t> unread;
+  uint64_t wasted = 0;
+};
+
+#endif
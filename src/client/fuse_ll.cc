@@ -33,6 +33,7 @@
 #include "ioctl.h"
 #include "common/config.h"
 #include "include/ceph_assert.h"
+#include "include/stat.h"
 #include "include/cephfs/ceph_ll_client.h"
 #include "include/ceph_fuse.h"
 
@@ -799,6 +800,8 @@ struct readdir_context {
   size_t size;
   size_t pos; /* in buf */
   uint64_t snap;
+  double timeout; /* readdirplus attr/entry timeout */
+  std::vector<Inode*> refs; /* readdirplus lookup refs handed out in buf */
 };
 
 /*
@@ -850,6 +853,87 @@ static void fuse_ll_readdir(fuse_req_t req, fuse_ino_t ino, size_t size,
   delete[] rc.buf;
 }
 
+#if FUSE_VERSION >= FUSE_MAKE_VERSION(3, 0)
+/*
+ * return 0 on success, -1 if out of space
+ */
+static int fuse_ll_add_direntplus(void *p, struct dirent *de,
+				  struct ceph_statx *stx, off_t next_off,
+				  Inode *in)
+{
+  struct readdir_context *c = (struct readdir_context *)p;
+  CephFuse::Handle *cfuse = (CephFuse::Handle *)fuse_req_userdata(c->req);
+
+  struct fuse_entry_param fe;
+  memset(&fe, 0, sizeof(fe));
+  fe.ino = cfuse->make_fake_ino(stx->stx_ino, stx->stx_dev);
+  fe.attr.st_ino = fe.ino;
+  fe.attr.st_mode = stx->stx_mode;
+  fe.attr.st_nlink = stx->stx_nlink;
+  fe.attr.st_uid = stx->stx_uid;
+  fe.attr.st_gid = stx->stx_gid;
+  fe.attr.st_rdev = new_encode_dev(stx->stx_rdev);
+  fe.attr.st_size = stx->stx_size;
+  fe.attr.st_blksize = stx->stx_blksize;
+  fe.attr.st_blocks = stx->stx_blocks;
+  stat_set_atime_sec(&fe.attr, stx->stx_atime.tv_sec);
+  stat_set_atime_nsec(&fe.attr, stx->stx_atime.tv_nsec);
+  stat_set_mtime_sec(&fe.attr, stx->stx_mtime.tv_sec);
+  stat_set_mtime_nsec(&fe.attr, stx->stx_mtime.tv_nsec);
+  stat_set_ctime_sec(&fe.attr, stx->stx_ctime.tv_sec);
+  stat_set_ctime_nsec(&fe.attr, stx->stx_ctime.tv_nsec);
+  fe.attr_timeout = c->timeout;
+  fe.entry_timeout = c->timeout;
+
+  size_t room = c->size - c->pos;
+  size_t entrysize = fuse_add_direntry_plus(c->req, c->buf + c->pos, room,
+					    de->d_name, &fe, next_off);
+  // the kernel takes a lookup reference on every entry it is handed,
+  // except . and ..
+  bool dot = !strcmp(de->d_name, ".") || !strcmp(de->d_name, "..");
+  if (entrysize > room || dot)
+    cfuse->client->ll_put(in);
+  if (entrysize > room)
+    return -ENOSPC;
+
+  /* success */
+  c->pos += entrysize;
+  if (!dot)
+    c->refs.push_back(in);
+  return 0;
+}
+
+static void fuse_ll_readdirplus(fuse_req_t req, fuse_ino_t ino, size_t size,
+				off_t off, struct fuse_file_info *fi)
+{
+  CephFuse::Handle *cfuse = fuse_ll_req_prepare(req);
+
+  dir_result_t *dirp = reinterpret_cast<dir_result_t*>(fi->fh);
+  cfuse->client->seekdir(dirp, off);
+
+  struct readdir_context rc;
+  rc.req = req;
+  rc.buf = new char[size];
+  rc.size = size;
+  rc.pos = 0;
+  rc.snap = cfuse->fino_snap(ino);
+  rc.timeout = cfuse->client->cct->_conf.get_val<double>(
+    "fuse_readdirplus_timeout");
+
+  int r = cfuse->client->readdir_r_cb(dirp, fuse_ll_add_direntplus, &rc,
+				      CEPH_STATX_BASIC_STATS, 0, true);
+  if (r == 0 || r == -CEPHFS_ENOSPC) {  /* ignore ENOSPC from our callback */
+    fuse_reply_buf(req, rc.buf, rc.pos);
+  } else {
+    // the entries never reach the kernel, so neither do their refs
+    for (auto in : rc.refs)
+      cfuse->client->ll_put(in);
+    fuse_reply_err(req, get_sys_errno(-r));
+  }
+  delete[] rc.buf;
+}
+#endif
+
 static void fuse_ll_releasedir(fuse_req_t req, fuse_ino_t ino,
 			       struct fuse_file_info *fi)
 {
@@ -1079,6 +1163,12 @@ static void do_init(void *data, fuse_conn_info *conn)
   if(conn->capable & FUSE_CAP_SPLICE_MOVE)
     conn->want |= FUSE_CAP_SPLICE_MOVE;
 
+#if FUSE_VERSION >= FUSE_MAKE_VERSION(3, 0)
+  // libfuse turns readdirplus on whenever the op is provided
+  if (!client->cct->_conf.get_val<bool>("fuse_readdirplus"))
+    conn->want &= ~(FUSE_CAP_READDIRPLUS | FUSE_CAP_READDIRPLUS_AUTO);
+#endif
+
 #if !defined(__APPLE__)
   if (!client->fuse_default_permissions && client->ll_handle_umask()) {
     // apply umask in userspace if posix acl is enabled
@@ -1159,7 +1249,10 @@ const static struct fuse_lowlevel_ops fuse_ll_oper = {
  flock: fuse_ll_flock,
 #endif
 #if FUSE_VERSION >= FUSE_MAKE_VERSION(2, 9)
- fallocate: fuse_ll_fallocate
+ fallocate: fuse_ll_fallocate,
+#endif
+#if FUSE_VERSION >= FUSE_MAKE_VERSION(3, 0)
+ readdirplus: fuse_ll_readdirplus,
 #endif
 };
 
@@ -1,6 +1,8 @@
 #ifndef __CEPH_SNAP_TYPES_H
 #define __CEPH_SNAP_TYPES_H
 
+#include <memory>
+
 #include "include/types.h"
 #include "include/fs_types.h"
 
@@ -70,6 +72,13 @@ struct SnapContext {
 };
 WRITE_CLASS_ENCODER(SnapContext)
 
+/*
+ * A snap context that is never modified once built.  With thousands of
+ * snaps the vector is large, so caches and writers share one of these
+ * instead of each holding a copy.
+ */
+using SnapContextRef = std::shared_ptr<const SnapContext>;
+
 inline std::ostream& operator<<(std::ostream& out, const SnapContext& snapc) {
   return out << snapc.seq << "=" << snapc.snaps;
 }
@@ -604,6 +604,27 @@ int ceph_readdir_r(struct ceph_mount_info *cmount, struct ceph_dir_result *dirp,
 int ceph_readdirplus_r(struct ceph_mount_info *cmount, struct ceph_dir_result *dirp, struct dirent *de,
 		       struct ceph_statx *stx, unsigned want, unsigned flags, struct Inode **out);
 
+/**
+ * Get up to count directory entries and their file statistics at once.
+ *
+ * Entries come from the same MDS readdir replies as with ceph_readdirplus_r,
+ * without a library call per entry.
+ *
+ * @param cmount the ceph mount handle to use for performing the readdir.
+ * @param dirp the directory stream pointer from an opendir holding the state of the
+ *        next entry to return.
+ * @param des array of count directory entries to fill in.
+ * @param stxs array of count ceph_statx structs to fill in, or NULL.
+ * @param count the number of entries des and stxs have room for.
+ * @param want mask showing desired inode attrs for returned entries
+ * @param flags bitmask of flags to use when filling out attributes
+ * @returns the number of entries filled in, 0 if the end of the directory stream
+ *          was reached, and a negative error code on failure.
+ */
+int ceph_readdirplus_many(struct ceph_mount_info *cmount, struct ceph_dir_result *dirp,
+			  struct dirent *des, struct ceph_statx *stxs, unsigned count,
+			  unsigned want, unsigned flags);
+
 /**
  * Gets multiple directory entries.
  *
@@ -885,6 +906,27 @@ int ceph_statxat(struct ceph_mount_info *cmount, int dirfd, const char *relpath,
 int ceph_statx(struct ceph_mount_info *cmount, const char *path, struct ceph_statx *stx,
 	       unsigned int want, unsigned int flags);
 
+/**
+ * Get the extended statistics of several entries of one directory.
+ *
+ * If many of the entries are not in the client's cache, the directory is read
+ * with a few readdir requests instead of looking the entries up one by one.
+ *
+ * @param cmount the ceph mount handle to use for performing the stat.
+ * @param dirpath the directory holding the entries.
+ * @param names the names of count entries in dirpath.
+ * @param count the number of entries.
+ * @param stxs array of count ceph_statx structs filled in for the entries.
+ * @param rets array of count results, 0 or a negative error code for each entry.
+ * @param want bitfield of CEPH_STATX_* flags showing designed attributes
+ * @param flags bitfield that can be used to set AT_* modifier flags (only AT_NO_ATTR_SYNC and AT_SYMLINK_NOFOLLOW)
+ * @returns 0 on success or negative error code if dirpath could not be read.
+ */
+int ceph_statx_many(struct ceph_mount_info *cmount, const char *dirpath,
+		    const char * const *names, unsigned count,
+		    struct ceph_statx *stxs, int *rets,
+		    unsigned int want, unsigned int flags);
+
 /**
  * Get a file's statistics and attributes.
  *
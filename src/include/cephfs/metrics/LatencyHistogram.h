@@ -0,0 +1,218 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#ifndef CEPH_INCLUDE_CEPHFS_METRICS_LATENCY_HISTOGRAM_H
+#define CEPH_INCLUDE_CEPHFS_METRICS_LATENCY_HISTOGRAM_H
+
+#include <algorithm>
+#include <cmath>
+#include <ostream>
+#include <vector>
+
+#include "common/Formatter.h"
+#include "include/denc.h"
+#include "include/utime.h"
+
+/*
+ * Log-linear latency histogram, in microseconds.
+ *
+ * Below SUB_BUCKETS us every microsecond has a bucket of its own; above
+ * that each power of two is split into SUB_BUCKETS equal buckets, so a
+ * bucket is at most a quarter of its lower bound wide and so is the error
+ * of a quantile read back from it.  Only non-empty buckets go on the wire,
+ * which keeps a typical histogram to a few dozen bytes.
+ *
+ * Histograms add: clients report what they saw since their last report
+ * and the MDSs merge the reports per client and per subtree.
+ */
+class LatencyHistogram {
+public:
+  static constexpr unsigned SUB_BITS = 2;
+  static constexpr unsigned SUB_BUCKETS = 1 << SUB_BITS;
+  // up to 2^40us, about twelve days; anything slower lands in the last one
+  static constexpr unsigned MAX_BUCKETS = (41 - SUB_BITS) * SUB_BUCKETS;
+
+  static unsigned bucket_of(uint64_t us) {
+    if (us < SUB_BUCKETS)
+      return us;
+    unsigned e = 63 - __builtin_clzll(us);
+    unsigned b = (e - SUB_BITS + 1) * SUB_BUCKETS +
+		 ((us >> (e - SUB_BITS)) & (SUB_BUCKETS - 1));
+    return std::min(b, MAX_BUCKETS - 1);
+  }
+  static uint64_t bucket_lower(unsigned b) {
+    if (b < SUB_BUCKETS)
+      return b;
+    unsigned shift = b / SUB_BUCKETS - 1;
+    return (uint64_t)(SUB_BUCKETS + b % SUB_BUCKETS) << shift;
+  }
+  static uint64_t bucket_upper(unsigned b) {
+    if (b < SUB_BUCKETS)
+      return b + 1;
+    return bucket_lower(b) + (1ull << (b / SUB_BUCKETS - 1));
+  }
+
+  void add(uint64_t us, uint64_t n = 1) {
+    unsigned b = bucket_of(us);
+    if (b >= buckets.size())
+      buckets.resize(b + 1);
+    buckets[b] += n;
+    total += n;
+    sum += us * n;
+  }
+  void add(const utime_t& lat) {
+    add(lat.to_nsec() / 1000);
+  }
+
+  void merge(const LatencyHistogram& o) {
+    if (o.buckets.size() > buckets.size())
+      buckets.resize(o.buckets.size());
+    for (size_t i = 0; i < o.buckets.size(); i++)
+      buckets[i] += o.buckets[i];
+    total += o.total;
+    sum += o.sum;
+  }
+
+  /// halve every count, so that old samples fade out
+  void decay() {
+    total = 0;
+    for (auto& c : buckets) {
+      c >>= 1;
+      total += c;
+    }
+    sum >>= 1;
+    trim();
+  }
+
+  /// upper bound of the bucket holding the q-quantile, in microseconds
+  uint64_t quantile(double q) const {
+    if (total == 0)
+      return 0;
+    uint64_t rank = std::max<uint64_t>(1, std::ceil(q * total));
+    uint64_t seen = 0;
+    for (unsigned b = 0; b < buckets.size(); b++) {
+      seen += buckets[b];
+      if (seen >= rank)
+	return bucket_upper(b);
+    }
+    return bucket_upper(buckets.size() - 1);
+  }
+
+  uint64_t count() const { return total; }
+  uint64_t mean() const { return total ? sum / total : 0; }
+  bool empty() const { return total == 0; }
+  void clear() {
+    buckets.clear();
+    total = sum = 0;
+  }
+
+  DENC_HELPERS
+  void bound_encode(size_t& p) const {
+    p += 6 + 3 * 10 + buckets.size() * (5 + 10);
+  }
+  void encode(::ceph::buffer::list::contiguous_appender& p) const {
+    DENC_START(1, 1, p);
+    denc_varint(sum, p);
+    uint32_t n = std::count_if(buckets.begin(), buckets.end(),
+			       [](uint64_t c) { return c != 0; });
+    denc_varint(n, p);
+    unsigned last = 0;
+    for (unsigned b = 0; b < buckets.size(); b++) {
+      if (!buckets[b])
+	continue;
+      denc_varint(b - last, p);
+      denc_varint(buckets[b], p);
+      last = b;
+    }
+    DENC_FINISH(p);
+  }
+  void decode(::ceph::buffer::ptr::const_iterator& p) {
+    DENC_START(1, 1, p);
+    clear();
+    denc_varint(sum, p);
+    uint32_t n;
+    denc_varint(n, p);
+    unsigned b = 0;
+    while (n--) {
+      unsigned delta;
+      uint64_t c;
+      denc_varint(delta, p);
+      denc_varint(c, p);
+      b = std::min(b + delta, MAX_BUCKETS - 1);
+      if (b >= buckets.size())
+	buckets.resize(b + 1);
+      buckets[b] += c;
+      total += c;
+    }
+    DENC_FINISH(p);
+  }
+
+  void dump(ceph::Formatter *f) const {
+    f->dump_unsigned("count", total);
+    f->dump_unsigned("mean_us", mean());
+    f->dump_unsigned("p50_us", quantile(0.5));
+    f->dump_unsigned("p90_us", quantile(0.9));
+    f->dump_unsigned("p99_us", quantile(0.99));
+    f->dump_unsigned("p999_us", quantile(0.999));
+    f->dump_unsigned("max_us", buckets.empty() ? 0 : bucket_upper(buckets.size() - 1));
+  }
+
+  friend std::ostream& operator<<(std::ostream& os, const LatencyHistogram& h) {
+    return os << "{count=" << h.total << ", p99=" << h.quantile(0.99)
+	      << "us, p999=" << h.quantile(0.999) << "us}";
+  }
+
+private:
+  void trim() {
+    while (!buckets.empty() && buckets.back() == 0)
+      buckets.pop_back();
+  }
+
+  std::vector<uint64_t> buckets;
+  uint64_t total = 0;
+  uint64_t sum = 0;
+};
+WRITE_CLASS_DENC(LatencyHistogram)
+
+/// what a client saw under one subtree
+struct LatencyHistograms {
+  LatencyHistogram read;
+  LatencyHistogram write;
+  LatencyHistogram metadata;
+
+  bool empty() const {
+    return read.empty() && write.empty() && metadata.empty();
+  }
+  void merge(const LatencyHistograms& o) {
+    read.merge(o.read);
+    write.merge(o.write);
+    metadata.merge(o.metadata);
+  }
+  void decay() {
+    read.decay();
+    write.decay();
+    metadata.decay();
+  }
+
+  DENC(LatencyHistograms, v, p) {
+    DENC_START(1, 1, p);
+    denc(v.read, p);
+    denc(v.write, p);
+    denc(v.metadata, p);
+    DENC_FINISH(p);
+  }
+
+  void dump(ceph::Formatter *f) const {
+    f->dump_object("read", read);
+    f->dump_object("write", write);
+    f->dump_object("metadata", metadata);
+  }
+
+  friend std::ostream& operator<<(std::ostream& os, const LatencyHistograms& h) {
+    return os << "{read=" << h.read << ", write=" << h.write
+	      << ", metadata=" << h.metadata << "}";
+  }
+};
+WRITE_CLASS_DENC(LatencyHistograms)
+
+#endif // CEPH_INCLUDE_CEPHFS_METRICS_LATENCY_HISTOGRAM_H
@@ -4,6 +4,7 @@
 #ifndef CEPH_INCLUDE_CEPHFS_METRICS_TYPES_H
 #define CEPH_INCLUDE_CEPHFS_METRICS_TYPES_H
 
+#include <map>
 #include <string>
 #include <boost/variant.hpp>
 
@@ -14,6 +15,8 @@
 #include "include/stringify.h"
 #include "include/utime.h"
 
+#include "LatencyHistogram.h"
+
 namespace ceph { class Formatter; }
 
 enum ClientMetricType {
@@ -25,6 +28,7 @@ enum ClientMetricType {
   CLIENT_METRIC_TYPE_OPENED_FILES,
   CLIENT_METRIC_TYPE_PINNED_ICAPS,
   CLIENT_METRIC_TYPE_OPENED_INODES,
+  CLIENT_METRIC_TYPE_LATENCY_HISTOGRAMS,
 };
 inline std::ostream &operator<<(std::ostream &os, const ClientMetricType &type) {
   switch(type) {
@@ -52,6 +56,9 @@ inline std::ostream &operator<<(std::ostream &os, const ClientMetricType &type)
   case ClientMetricType::CLIENT_METRIC_TYPE_OPENED_INODES:
     os << "OPENED_INODES";
     break;
+  case ClientMetricType::CLIENT_METRIC_TYPE_LATENCY_HISTOGRAMS:
+    os << "LATENCY_HISTOGRAMS";
+    break;
   default:
     os << "(UNKNOWN:" << static_cast<std::underlying_type<ClientMetricType>::type>(type) << ")";
     break;
@@ -367,6 +374,42 @@ struct OpenedInodesPayload : public ClientMetricPayloadBase {
   }
 };
 
+// latencies seen since the previous report, per subtree path
+struct LatencyHistogramsPayload : public ClientMetricPayloadBase {
+  std::map<std::string, LatencyHistograms> subtrees;
+
+  LatencyHistogramsPayload()
+    : ClientMetricPayloadBase(ClientMetricType::CLIENT_METRIC_TYPE_LATENCY_HISTOGRAMS) { }
+  LatencyHistogramsPayload(std::map<std::string, LatencyHistograms>&& subtrees)
+    : ClientMetricPayloadBase(ClientMetricType::CLIENT_METRIC_TYPE_LATENCY_HISTOGRAMS),
+    subtrees(std::move(subtrees)) { }
+
+  void encode(bufferlist &bl) const {
+    using ceph::encode;
+    ENCODE_START(1, 1, bl);
+    encode(subtrees, bl);
+    ENCODE_FINISH(bl);
+  }
+
+  void decode(bufferlist::const_iterator &iter) {
+    using ceph::decode;
+    DECODE_START(1, iter);
+    decode(subtrees, iter);
+    DECODE_FINISH(iter);
+  }
+
+  void dump(Formatter *f) const {
+    f->open_object_section("subtrees");
+    for (auto &[path, h] : subtrees)
+      f->dump_object(path, h);
+    f->close_section();
+  }
+
+  void print(std::ostream *out) const {
+    *out << "subtrees: " << subtrees.size();
+  }
+};
+
 struct UnknownPayload : public ClientMetricPayloadBase {
   UnknownPayload()
     : ClientMetricPayloadBase(static_cast<ClientMetricType>(-1)) { }
@@ -398,6 +441,7 @@ typedef boost::variant<CapInfoPayload,
 		       OpenedFilesPayload,
 		       PinnedIcapsPayload,
 		       OpenedInodesPayload,
+		       LatencyHistogramsPayload,
                        UnknownPayload> ClientMetricPayload;
 
 // metric update message sent by clients
@@ -506,6 +550,9 @@ public:
     case ClientMetricType::CLIENT_METRIC_TYPE_OPENED_INODES:
       payload = OpenedInodesPayload();
       break;
+    case ClientMetricType::CLIENT_METRIC_TYPE_LATENCY_HISTOGRAMS:
+      payload = LatencyHistogramsPayload();
+      break;
     default:
       payload = UnknownPayload(static_cast<ClientMetricType>(metric_type));
       break;
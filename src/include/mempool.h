@@ -15,6 +15,7 @@
 #ifndef _CEPH_INCLUDE_MEMPOOL_H
 #define _CEPH_INCLUDE_MEMPOOL_H
 
+#include <atomic>
 #include <cstddef>
 #include <map>
 #include <unordered_map>
@@ -299,14 +300,31 @@ public:
 void dump(ceph::Formatter *f);
 
 
-// STL allocator for use with containers.  All actual state
-// is stored in the static pool_allocator_base_t, which saves us from
-// passing the allocator to container constructors.
+// STL allocator for use with containers.  All actual state is static
+// (the pool is found by index, the type is registered once per T), so the
+// allocator is empty and costs the containers using it nothing: a
+// mempool::vector is as small as a std::vector, which matters for the
+// many small containers hanging off every cached onode and blob.
 
 template<pool_index_t pool_ix, typename T>
 class pool_allocator {
-  pool_t *pool;
-  type_t *type = nullptr;
+  // registered by the first allocation of T in this pool, or up front by
+  // an object factory (force_register).  No item of T can be freed before
+  // that, so the count is exact whenever debug mode comes to report it.
+  static inline std::atomic<type_t*> type = {nullptr};
+
+  static pool_t& pool() {
+    return get_pool(pool_ix);
+  }
+  static type_t* get_type() {
+    type_t *t = type.load(std::memory_order_acquire);
+    if (!t) {
+      // get_type() is idempotent, so racing registrations agree
+      t = pool().get_type(typeid(T), sizeof(T));
+      type.store(t, std::memory_order_release);
+    }
+    return t;
+  }
 
 public:
   typedef pool_allocator<pool_ix, T> allocator_type;
@@ -323,9 +341,8 @@ public:
   };
 
   void init(bool force_register) {
-    pool = &get_pool(pool_ix);
-    if (debug_mode || force_register) {
-      type = pool->get_type(typeid(T), sizeof(T));
+    if (force_register) {
+      get_type();
     }
   }
 
@@ -339,35 +356,29 @@ public:
 
   T* allocate(size_t n, void *p = nullptr) {
     size_t total = sizeof(T) * n;
-    shard_t *shard = pool->pick_a_shard();
+    shard_t *shard = pool().pick_a_shard();
     shard->bytes += total;
     shard->items += n;
-    if (type) {
-      type->items += n;
-    }
+    get_type()->items += n;
     T* r = reinterpret_cast<T*>(new char[total]);
     return r;
   }
 
   void deallocate(T* p, size_t n) {
     size_t total = sizeof(T) * n;
-    shard_t *shard = pool->pick_a_shard();
+    shard_t *shard = pool().pick_a_shard();
     shard->bytes -= total;
     shard->items -= n;
-    if (type) {
-      type->items -= n;
-    }
+    get_type()->items -= n;
     delete[] reinterpret_cast<char*>(p);
   }
 
   T* allocate_aligned(size_t n, size_t align, void *p = nullptr) {
     size_t total = sizeof(T) * n;
-    shard_t *shard = pool->pick_a_shard();
+    shard_t *shard = pool().pick_a_shard();
     shard->bytes += total;
     shard->items += n;
-    if (type) {
-      type->items += n;
-    }
+    get_type()->items += n;
     char *ptr;
     int rc = ::posix_memalign((void**)(void*)&ptr, align, total);
     if (rc)
@@ -378,12 +389,10 @@ public:
 
   void deallocate_aligned(T* p, size_t n) {
     size_t total = sizeof(T) * n;
-    shard_t *shard = pool->pick_a_shard();
+    shard_t *shard = pool().pick_a_shard();
     shard->bytes -= total;
     shard->items -= n;
-    if (type) {
-      type->items -= n;
-    }
+    get_type()->items -= n;
     aligned_free(p);
   }
 
@@ -687,6 +687,18 @@ extern "C" int ceph_readdirplus_r(struct ceph_mount_info *cmount, struct ceph_di
   return cmount->get_client()->readdirplus_r(reinterpret_cast<dir_result_t*>(dirp), de, stx, want, flags, out);
 }
 
+extern "C" int ceph_readdirplus_many(struct ceph_mount_info *cmount, struct ceph_dir_result *dirp,
+				     struct dirent *des, struct ceph_statx *stxs, unsigned count,
+				     unsigned want, unsigned flags)
+{
+  if (!cmount->is_mounted())
+    return -ENOTCONN;
+  if (flags & ~CEPH_REQ_FLAG_MASK)
+    return -EINVAL;
+  return cmount->get_client()->readdirplus_many(reinterpret_cast<dir_result_t*>(dirp),
+						des, stxs, count, want, flags);
+}
+
 extern "C" int ceph_getdents(struct ceph_mount_info *cmount, struct ceph_dir_result *dirp,
 			     char *buf, int buflen)
 {
@@ -878,6 +890,19 @@ extern "C" int ceph_statx(struct ceph_mount_info *cmount, const char *path,
 				     want, flags);
 }
 
+extern "C" int ceph_statx_many(struct ceph_mount_info *cmount, const char *dirpath,
+			       const char * const *names, unsigned count,
+			       struct ceph_statx *stxs, int *rets,
+			       unsigned int want, unsigned int flags)
+{
+  if (!cmount->is_mounted())
+    return -ENOTCONN;
+  if (flags & ~CEPH_REQ_FLAG_MASK)
+    return -EINVAL;
+  return cmount->get_client()->statx_many(dirpath, names, count, stxs, rets,
+					  cmount->default_perms, want, flags);
+}
+
 extern "C" int ceph_fsetattrx(struct ceph_mount_info *cmount, int fd,
 			      struct ceph_statx *stx, int mask)
 {
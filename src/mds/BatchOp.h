@@ -16,7 +16,10 @@
 #ifndef MDS_BATCHOP_H
 #define MDS_BATCHOP_H
 
+#include <memory>
+
 #include "common/ref.h"
+#include "include/mempool.h"
 
 #include "mdstypes.h"
 
@@ -37,4 +40,7 @@ protected:
   virtual void _respond(mds_rank_t) = 0;
 };
 
+// at most a couple of entries, and usually none: keep it a single pointer
+using batch_op_map_t = mempool::mds_co::compact_map<int, std::unique_ptr<BatchOp>>;
+
 #endif
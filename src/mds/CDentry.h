@@ -366,8 +366,8 @@ public:
   SimpleLock lock; // FIXME referenced containers not in mempool
   LocalLockC versionlock; // FIXME referenced containers not in mempool
 
-  mempool::mds_co::map<client_t,ClientLease*> client_lease_map;
-  std::map<int, std::unique_ptr<BatchOp>> batch_ops;
+  mempool::mds_co::compact_map<client_t,ClientLease*> client_lease_map;
+  batch_op_map_t batch_ops;
 
 
 protected:
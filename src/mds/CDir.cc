@@ -29,6 +29,7 @@
 #include "MDLog.h"
 #include "LogSegment.h"
 #include "MDBalancer.h"
+#include "OmapRanges.h"
 
 #include "common/bloom_filter.hpp"
 #include "include/Context.h"
@@ -1612,37 +1613,75 @@ void CDir::fetch(MDSContext *c, const std::set<dentry_key_t>& keys)
   _omap_fetch(c, keys);
 }
 
-class C_IO_Dir_OMAP_FetchedMore : public CDirIOContext {
-  MDSContext *fin;
-public:
+/*
+ * State shared by the omap reads of one dirfrag fetch.  Once the first
+ * read shows that a dirfrag does not fit in a single op, the remaining
+ * key space is split into ranges that are read in parallel; results are
+ * gathered here and handed to _omap_fetched() when every range is done.
+ */
+struct CDir::omap_fetch_state_t {
+  omap_fetch_state_t(version_t v, MDSContext *f) : omap_version(v), fin(f) {}
   const version_t omap_version;
+  MDSContext *fin;
   bufferlist hdrbl;
+  map<string, bufferlist> omap;
+  uint64_t expected = 0;   ///< entries in the dirfrag, per its fnode
+  unsigned max_ranges = 1; ///< ranges we may read at once
+  unsigned pending = 0;    ///< ranges being read
+  bool restart = false;
+  int ret = 0;
+};
+
+class C_IO_Dir_OMAP_FetchedMore : public CDirIOContext {
+  std::shared_ptr<CDir::omap_fetch_state_t> state;
+  const string end; ///< inclusive upper bound of the range, empty if none
+public:
   bool more = false;
-  map<string, bufferlist> omap;      ///< carry-over from before
   map<string, bufferlist> omap_more; ///< new batch
-  int ret;
-  C_IO_Dir_OMAP_FetchedMore(CDir *d, version_t v, MDSContext *f) :
-    CDirIOContext(d), fin(f), omap_version(v), ret(0) { }
-  void finish(int r) {
-    if (omap_version < dir->get_committed_version()) {
-      omap.clear();
-      dir->_omap_fetch(fin, {});
-      return;
+  int ret = 0;
+  C_IO_Dir_OMAP_FetchedMore(CDir *d, std::shared_ptr<CDir::omap_fetch_state_t> s,
+			    const string& e) :
+    CDirIOContext(d), state(std::move(s)), end(e) { }
+  void finish(int r) override {
+    auto& st = *state;
+    if (r >= 0)
+      r = ret;
+    if (r < 0 && st.ret == 0)
+      st.ret = r;
+    if (st.omap_version < dir->get_committed_version()) {
+      // refetch from scratch, but only once all other ranges have drained
+      st.restart = true;
+    }
+
+    if (!st.restart) {
+      // merge results, dropping anything that belongs to the next range
+      bool done;
+      auto stop = omap_range_clip(omap_more, more, end, &done);
+      st.omap.insert(std::make_move_iterator(omap_more.begin()),
+		     std::make_move_iterator(stop));
+      if (!done) {
+	if (end.empty()) {
+	  // the open-ended range hands what it can to idle reads
+	  --st.pending;
+	  dir->_omap_fetch_tail(state, omap_more);
+	} else {
+	  dir->_omap_fetch_range(state, std::prev(stop)->first, end);
+	}
+	return;
+      }
     }
 
-    // merge results
-    if (omap.empty()) {
-      omap.swap(omap_more);
-    } else {
-      omap.insert(omap_more.begin(), omap_more.end());
-    }
-    if (more) {
-      dir->_omap_fetch_more(omap_version, hdrbl, omap, fin);
-    } else {
-      dir->_omap_fetched(hdrbl, omap, !fin, r);
-      if (fin)
-	fin->complete(r);
+    if (--st.pending > 0)
+      return;
+
+    if (st.restart) {
+      st.omap.clear();
+      dir->_omap_fetch(st.fin, {});
+      return;
     }
+    dir->_omap_fetched(st.hdrbl, st.omap, !st.fin, st.ret);
+    if (st.fin)
+      st.fin->complete(st.ret);
   }
   void print(ostream& out) const override {
     out << "dirfrag_fetch_more(" << dir->dirfrag() << ")";
@@ -1727,13 +1766,68 @@ void CDir::_omap_fetch_more(version_t omap_version, bufferlist& hdrbl,
 			    map<string, bufferlist>& omap, MDSContext *c)
 {
   // we have more omap keys to fetch!
+  auto state = std::make_shared<omap_fetch_state_t>(omap_version, c);
+  state->hdrbl = std::move(hdrbl);
+  state->omap.swap(omap);
+  state->max_ranges = std::max<uint64_t>(
+    1, g_conf().get_val<uint64_t>("mds_dir_fetch_parallel_ops"));
+  try {
+    fnode_t got_fnode;
+    auto p = state->hdrbl.cbegin();
+    decode(got_fnode, p);
+    state->expected = std::max<int64_t>(0, got_fnode.fragstat.size());
+  } catch (const buffer::error &err) {
+    // _omap_fetched() will complain; split without an estimate
+  }
+  _omap_fetch_tail(state, state->omap);
+}
+
+/*
+ * Read everything after the last key of batch.  Reads that are allowed
+ * but not in use take a share of it: split points are chosen from the
+ * keys of batch, which is the densest sample we have of what follows.
+ * The open-ended last range calls back here each time it has read more,
+ * so an estimate that fell short is corrected with a fresher sample.
+ */
+void CDir::_omap_fetch_tail(const std::shared_ptr<omap_fetch_state_t>& state,
+			    const map<string, bufferlist>& batch)
+{
+  const uint64_t keys_per_op = std::max<int64_t>(1, g_conf()->mds_dir_keys_per_op);
+  unsigned ranges = state->max_ranges > state->pending ?
+    state->max_ranges - state->pending : 1;
+  uint64_t remaining;
+  if (state->expected > state->omap.size()) {
+    remaining = state->expected - state->omap.size();
+    ranges = std::clamp<uint64_t>((remaining + keys_per_op - 1) / keys_per_op,
+				  1, ranges);
+  } else {
+    // no estimate, or more keys (snapshotted dentries) than it says
+    remaining = keys_per_op * ranges;
+  }
+
+  const string& last = batch.rbegin()->first;
+  auto splits = omap_split_points(batch, remaining, ranges);
+  dout(10) << __func__ << " " << state->omap.size() << " keys so far, about "
+	   << remaining << " to go, reading " << splits.size() + 1
+	   << " ranges after '" << last << "'" << dendl;
+
+  state->pending += splits.size() + 1;
+  string start_after = last;
+  for (auto& split : splits) {
+    _omap_fetch_range(state, start_after, split);
+    start_after = split;
+  }
+  _omap_fetch_range(state, start_after, "");
+}
+
+void CDir::_omap_fetch_range(const std::shared_ptr<omap_fetch_state_t>& state,
+			     const string& start_after, const string& end)
+{
   object_t oid = get_ondisk_object();
   object_locator_t oloc(mdcache->mds->mdsmap->get_metadata_pool());
-  auto fin = new C_IO_Dir_OMAP_FetchedMore(this, omap_version, c);
-  fin->hdrbl = std::move(hdrbl);
-  fin->omap.swap(omap);
+  auto fin = new C_IO_Dir_OMAP_FetchedMore(this, state, end);
   ObjectOperation rd;
-  rd.omap_get_vals(fin->omap.rbegin()->first,
+  rd.omap_get_vals(start_after,
 		   "", /* filter prefix */
 		   g_conf()->mds_dir_keys_per_op,
 		   &fin->omap_more,
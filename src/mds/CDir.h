@@ -644,9 +644,15 @@ protected:
   friend class C_IO_Dir_Committed;
   friend class C_IO_Dir_Commit_Ops;
 
+  struct omap_fetch_state_t;
+
   void _omap_fetch(MDSContext *fin, const std::set<dentry_key_t>& keys);
   void _omap_fetch_more(version_t omap_version, bufferlist& hdrbl,
 			std::map<std::string, bufferlist>& omap, MDSContext *fin);
+  void _omap_fetch_tail(const std::shared_ptr<omap_fetch_state_t>& state,
+			const std::map<std::string, bufferlist>& batch);
+  void _omap_fetch_range(const std::shared_ptr<omap_fetch_state_t>& state,
+			 const std::string& start_after, const std::string& end);
   CDentry *_load_dentry(
       std::string_view key,
       std::string_view dname,
@@ -417,7 +417,7 @@ class CInode : public MDSCacheObject, public InodeStoreBase, public Counter<CIno
     ceph_assert(batch_ops.empty());
   }
 
-  std::map<int, std::unique_ptr<BatchOp>> batch_ops;
+  batch_op_map_t batch_ops;
 
   std::string_view pin_name(int p) const override;
 
@@ -1067,7 +1067,7 @@ class CInode : public MDSCacheObject, public InodeStoreBase, public Counter<CIno
   // list item node for when we have unpropagated rstat data
   elist<CInode*>::item dirty_rstat_item;
 
-  mempool::mds_co::set<client_t> client_snap_caps;
+  mempool::mds_co::compact_set<client_t> client_snap_caps;
   mempool::mds_co::compact_map<snapid_t, mempool::mds_co::set<client_t> > client_need_snapflush;
 
   // LogSegment lists i (may) belong to
@@ -1080,8 +1080,8 @@ class CInode : public MDSCacheObject, public InodeStoreBase, public Counter<CIno
   elist<CInode*>::item item_dirty_dirfrag_dirfragtree;
 
   // also update RecoveryQueue::RecoveryQueue() if you change this
-  elist<CInode*>::item& item_recover_queue = item_dirty_dirfrag_dir;
-  elist<CInode*>::item& item_recover_queue_front = item_dirty_dirfrag_nest;
+  elist<CInode*>::item& item_recover_queue() { return item_dirty_dirfrag_dir; }
+  elist<CInode*>::item& item_recover_queue_front() { return item_dirty_dirfrag_nest; }
 
   inode_load_vec_t pop;
   elist<CInode*>::item item_pop_lru;
@@ -0,0 +1,64 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#ifndef CEPH_MDS_CAPMESSAGEBATCH_H
+#define CEPH_MDS_CAPMESSAGEBATCH_H
+
+#include <map>
+#include <vector>
+
+#include "messages/MClientCaps.h"
+
+/*
+ * The GRANT/REVOKE messages issue_caps() sends one session while a
+ * dispatch cycle runs, held until it ends.
+ *
+ * A cap that is issued again before the earlier message went out only
+ * needs the latest message: it carries the newest seq, and the client's
+ * ack of that seq confirms every revoke before it.  The op stays a REVOKE
+ * if any of the collapsed messages was one, so the client still acks.
+ */
+class CapMessageBatch {
+public:
+  /// queue m; returns the message it replaced, if any
+  ref_t<MClientCaps> add(const ref_t<MClientCaps>& m) {
+    ref_t<MClientCaps> prev;
+    auto [it, inserted] = by_cap_id.emplace(m->get_cap_id(), msgs.size());
+    if (!inserted) {
+      prev.swap(msgs[it->second]);
+      if (prev->get_op() == CEPH_CAP_OP_REVOKE)
+	m->set_op(CEPH_CAP_OP_REVOKE);
+      it->second = msgs.size();
+    }
+    msgs.push_back(m);
+    return prev;
+  }
+
+  /// the messages to send, in the order they were queued
+  std::vector<ref_t<MClientCaps>> take() {
+    std::vector<ref_t<MClientCaps>> out;
+    out.reserve(by_cap_id.size());
+    for (auto& m : msgs) {
+      if (m)
+	out.push_back(std::move(m));
+    }
+    msgs.clear();
+    by_cap_id.clear();
+    return out;
+  }
+
+private:
+  std::vector<ref_t<MClientCaps>> msgs;   // null = superseded
+  std::map<uint64_t, size_t> by_cap_id;   // cap id -> index in msgs
+};
+
+#endif
@@ -0,0 +1,90 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#ifndef CEPH_MDS_EXPORTTHROTTLE_H
+#define CEPH_MDS_EXPORTTHROTTLE_H
+
+#include <cstdint>
+
+/**
+ * Estimated cost of exporting a subtree, gathered from what is in cache.
+ * Exports are throttled on the size and inode counts; all of it is
+ * reported as perf counters next to the actual cost so that the
+ * estimate can be checked.
+ */
+struct export_cost_t {
+  uint64_t size = 0;      // approximate encoded size, in bytes
+  uint64_t inodes = 0;
+  uint64_t dirfrags = 0;
+  uint64_t caps = 0;
+  uint64_t dirty = 0;     // dirty dirfrags, dentries and inodes
+  void add(const export_cost_t& o) {
+    size += o.size;
+    inodes += o.inodes;
+    dirfrags += o.dirfrags;
+    caps += o.caps;
+    dirty += o.dirty;
+  }
+};
+
+/*
+ * Throttle for the Migrator's queued exports.
+ *
+ * Every export in flight is charged its estimated cost from the moment it
+ * starts, while it is still taking locks, and the charge is replaced by a
+ * fresh estimate once the subtree is about to be frozen.  Another queued
+ * export may start while there is room for one more of max_size bytes
+ * within twice that, and while fewer than max_inodes inodes (0 for no
+ * limit) are in flight.
+ */
+class ExportThrottle {
+public:
+  void set_max_size(uint64_t bytes) {
+    max_size = bytes;
+  }
+  void set_max_inodes(uint64_t n) {
+    max_inodes = n;
+  }
+
+  bool may_start() const {
+    uint64_t max_total_size = max_size * 2;
+    return max_total_size > size &&
+	   max_total_size - size >= max_size &&
+	   (max_inodes == 0 || inodes < max_inodes);
+  }
+
+  /// replace what an export was charged, held, by cost
+  void charge(export_cost_t& held, const export_cost_t& cost) {
+    size += cost.size - held.size;
+    inodes += cost.inodes - held.inodes;
+    held = cost;
+  }
+  /// the export is done or cancelled
+  void release(export_cost_t& held) {
+    charge(held, export_cost_t());
+  }
+
+  uint64_t get_size() const {
+    return size;
+  }
+  uint64_t get_inodes() const {
+    return inodes;
+  }
+
+private:
+  uint64_t max_size = 0;
+  uint64_t max_inodes = 0;
+  uint64_t size = 0;
+  uint64_t inodes = 0;
+};
+
+#endif
@@ -0,0 +1,123 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#ifndef CEPH_MDS_HEAVYHITTERS_H
+#define CEPH_MDS_HEAVYHITTERS_H
+
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/*
+ * Approximate top-K of a weighted stream (Metwally et al.'s Space-Saving).
+ *
+ * At most `capacity` keys are tracked.  A key that is not tracked while
+ * the table is full evicts the current minimum and inherits its count as
+ * the error bound, so every key whose true weight exceeds total/capacity
+ * is guaranteed to be present, and for every tracked key
+ *   count - error <= true weight <= count.
+ *
+ * decay() scales all counts, which turns the totals into an exponentially
+ * weighted sum so the table follows what is hot now rather than ever.
+ */
+template<typename Key, typename Hash = std::hash<Key>>
+class SpaceSaving {
+public:
+  struct entry_t {
+    double count = 0.0;
+    double error = 0.0;
+  };
+
+  explicit SpaceSaving(size_t capacity) : capacity(capacity ? capacity : 1) {}
+
+  void hit(const Key& k, double amount = 1.0) {
+    auto it = index.find(k);
+    if (it != index.end()) {
+      slot_t& s = it->second;
+      double c = s.pos->first + amount;
+      by_count.erase(s.pos);
+      s.pos = by_count.emplace(c, k);
+      return;
+    }
+    double error = 0.0;
+    if (index.size() >= capacity) {
+      // evict the minimum; the newcomer may have been seen that often
+      auto victim = by_count.begin();
+      error = victim->first;
+      index.erase(victim->second);
+      by_count.erase(victim);
+    }
+    auto pos = by_count.emplace(error + amount, k);
+    index.emplace(k, slot_t{error, pos});
+  }
+
+  void decay(double factor) {
+    if (factor >= 1.0)
+      return;
+    // scaling preserves the order, so the rebuilt multimap is filled by
+    // appending
+    std::multimap<double, Key> scaled;
+    for (auto& [c, k] : by_count) {
+      slot_t& s = index.find(k)->second;
+      s.error *= factor;
+      s.pos = scaled.emplace_hint(scaled.end(), c * factor, k);
+    }
+    by_count.swap(scaled);
+  }
+
+  bool get(const Key& k, entry_t *e) const {
+    auto it = index.find(k);
+    if (it == index.end())
+      return false;
+    e->count = it->second.pos->first;
+    e->error = it->second.error;
+    return true;
+  }
+
+  /// the `n` heaviest keys, heaviest first
+  std::vector<std::pair<Key, entry_t>> top(size_t n) const {
+    std::vector<std::pair<Key, entry_t>> r;
+    for (auto p = by_count.rbegin(); p != by_count.rend() && r.size() < n; ++p)
+      r.emplace_back(p->second, entry_t{p->first, index.at(p->second).error});
+    return r;
+  }
+
+  void set_capacity(size_t c) {
+    capacity = c ? c : 1;
+    while (index.size() > capacity) {
+      auto victim = by_count.begin();
+      index.erase(victim->second);
+      by_count.erase(victim);
+    }
+  }
+
+  size_t get_capacity() const { return capacity; }
+  size_t size() const { return index.size(); }
+  bool empty() const { return index.empty(); }
+  void clear() {
+    index.clear();
+    by_count.clear();
+  }
+
+private:
+  struct slot_t {
+    double error;
+    typename std::multimap<double, Key>::iterator pos;
+  };
+
+  size_t capacity;
+  std::multimap<double, Key> by_count;
+  std::unordered_map<Key, slot_t, Hash> index;
+};
+
+#endif
@@ -0,0 +1,110 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#ifndef CEPH_MDS_LOADFORECAST_H
+#define CEPH_MDS_LOADFORECAST_H
+
+#include <algorithm>
+#include <deque>
+
+#include "common/Formatter.h"
+
+/*
+ * Short-horizon load forecast for a single series (one dirfrag or one
+ * rank), fed once per balancer epoch.
+ *
+ * This is Holt's linear method: an EWMA of the level plus an EWMA of
+ * the epoch-over-epoch trend.  It is cheap enough to keep one per
+ * popular dirfrag, and the trend term is what lets the balancer tell a
+ * burst that is already fading from load that is still climbing.
+ */
+class LoadForecast {
+public:
+  /**
+   * Add a sample for the given balancer epoch.
+   *
+   * @param epoch balancer epoch the sample belongs to
+   * @param v observed load
+   * @param alpha smoothing factor for the level, in (0, 1]
+   * @param beta smoothing factor for the trend, in [0, 1]
+   * @param max_history number of raw samples to retain for dumping
+   */
+  void sample(int epoch, double v, double alpha, double beta,
+	      size_t max_history) {
+    if (num_samples == 0 || epoch != last_epoch) {
+      // remember where this epoch starts from, so that sampling it again
+      // replaces its observation instead of blending on top of it
+      epoch_level = level;
+      epoch_trend = trend;
+      first_epoch = num_samples == 0;
+    }
+    if (first_epoch) {
+      level = v;
+      trend = 0.0;
+    } else {
+      level = alpha * v + (1.0 - alpha) * (epoch_level + epoch_trend);
+      trend = beta * (level - epoch_level) + (1.0 - beta) * epoch_trend;
+    }
+    last_epoch = epoch;
+    num_samples++;
+
+    if (!history.empty() && history.back().first == epoch)
+      history.back().second = v;
+    else
+      history.emplace_back(epoch, v);
+    while (history.size() > max_history)
+      history.pop_front();
+  }
+
+  /**
+   * Predicted load `steps` epochs after the last sample.  Never negative.
+   */
+  double predict(unsigned steps) const {
+    return std::max(0.0, level + trend * steps);
+  }
+
+  double get_level() const { return level; }
+  double get_trend() const { return trend; }
+  int get_last_epoch() const { return last_epoch; }
+  uint64_t get_num_samples() const { return num_samples; }
+  double get_last_sample() const {
+    return history.empty() ? 0.0 : history.back().second;
+  }
+
+  void dump(ceph::Formatter *f, unsigned horizon) const {
+    f->dump_int("last_epoch", last_epoch);
+    f->dump_unsigned("num_samples", num_samples);
+    f->dump_float("level", level);
+    f->dump_float("trend", trend);
+    f->dump_float("predicted", predict(horizon));
+    f->open_array_section("history");
+    for (const auto& [epoch, v] : history) {
+      f->open_object_section("sample");
+      f->dump_int("epoch", epoch);
+      f->dump_float("load", v);
+      f->close_section();
+    }
+    f->close_section();
+  }
+
+private:
+  double level = 0.0;
+  double trend = 0.0;
+  double epoch_level = 0.0;  ///< level and trend before last_epoch's sample
+  double epoch_trend = 0.0;
+  bool first_epoch = true;   ///< every sample so far is from one epoch
+  int last_epoch = 0;
+  uint64_t num_samples = 0;
+  std::deque<std::pair<int, double>> history;
+};
+
+#endif
@@ -2414,7 +2414,7 @@ int Locker::issue_caps(CInode *in, Capability *only_cap)
 					 mds->get_osd_epoch_barrier());
       in->encode_cap_message(m, cap);
 
-      mds->send_message_client_counted(m, cap->get_session());
+      send_issue_caps_message(m, cap->get_session());
     }
 
     if (only_cap)
@@ -2424,6 +2424,63 @@ int Locker::issue_caps(CInode *in, Capability *only_cap)
   return nissued;
 }
 
+class C_Locker_FlushDeferredCaps : public LockerContext {
+public:
+  explicit C_Locker_FlushDeferredCaps(Locker *l) : LockerContext(l) {}
+  void finish(int r) override {
+    locker->flush_deferred_caps();
+  }
+};
+
+void Locker::send_issue_caps_message(const ref_t<MClientCaps>& m, Session *session)
+{
+  if (!g_conf().get_val<bool>("mds_defer_cap_messages")) {
+    mds->send_message_client_counted(m, session);
+    return;
+  }
+
+  auto prev = deferred_caps[ref_t<Session>(session)].add(m);
+  if (prev) {
+    dout(10) << "send_issue_caps_message coalescing " << *prev << " into "
+	     << *m << dendl;
+    if (mds->logger)
+      mds->logger->inc(l_mdss_ceph_cap_op_coalesced);
+  }
+
+  if (!deferred_caps_flush_queued) {
+    deferred_caps_flush_queued = true;
+    mds->queue_waiter(new C_Locker_FlushDeferredCaps(this));
+  }
+}
+
+void Locker::flush_deferred_caps(Session *session)
+{
+  auto p = deferred_caps.find(ref_t<Session>(session));
+  if (p == deferred_caps.end())
+    return;
+
+  // unhook first: sending goes back through MDSRank, which flushes us
+  auto msgs = p->second.take();
+  deferred_caps.erase(p);
+
+  if (session->is_closed() || session->is_killing()) {
+    dout(10) << "flush_deferred_caps dropping " << msgs.size()
+	     << " messages for closed session " << session->info.inst << dendl;
+    return;
+  }
+  for (auto& m : msgs)
+    mds->send_message_client_counted(m, session);
+}
+
+void Locker::flush_deferred_caps()
+{
+  deferred_caps_flush_queued = false;
+  while (!deferred_caps.empty()) {
+    ref_t<Session> session = deferred_caps.begin()->first;
+    flush_deferred_caps(session.get());
+  }
+}
+
 void Locker::issue_truncate(CInode *in)
 {
   dout(7) << "issue_truncate on " << *in << dendl;
@@ -4274,7 +4331,7 @@ void Locker::revoke_client_leases(SimpleLock *lock)
 {
   int n = 0;
   CDentry *dn = static_cast<CDentry*>(lock->get_parent());
-  for (map<client_t, ClientLease*>::iterator p = dn->client_lease_map.begin();
+  for (auto p = dn->client_lease_map.begin();
        p != dn->client_lease_map.end();
        ++p) {
     ClientLease *l = p->second;
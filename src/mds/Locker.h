@@ -22,6 +22,7 @@
 #include "messages/MClientLease.h"
 #include "messages/MLock.h"
 
+#include "CapMessageBatch.h"
 #include "CInode.h"
 #include "SimpleLock.h"
 #include "MDSContext.h"
@@ -166,6 +167,8 @@ public:
   Capability* issue_new_caps(CInode *in, int mode, MDRequestRef& mdr, SnapRealm *conrealm);
   int issue_caps(CInode *in, Capability *only_cap=0);
   void issue_caps_set(std::set<CInode*>& inset);
+  void flush_deferred_caps(Session *session);
+  void flush_deferred_caps();
   void issue_truncate(CInode *in);
   void revoke_stale_cap(CInode *in, client_t client);
   bool revoke_stale_caps(Session *session);
@@ -249,6 +252,13 @@ protected:
   elist<CInode*> need_snapflush_inodes;
 
 private:
+  // GRANT/REVOKE messages from issue_caps(), held until the current
+  // dispatch cycle ends so repeated issues on one cap collapse into one
+  std::map<ref_t<Session>, CapMessageBatch> deferred_caps;
+  bool deferred_caps_flush_queued = false;
+
+  void send_issue_caps_message(const ref_t<MClientCaps>& m, Session *session);
+
   friend class C_MDL_CheckMaxSize;
   friend class C_MDL_RequestInodeFileCaps;
   friend class C_Locker_FileUpdate_finish;
@@ -74,7 +74,8 @@ int MDBalancer::proc_message(const cref_t<Message> &m)
 }
 
 MDBalancer::MDBalancer(MDSRank *m, Messenger *msgr, MonClient *monc) :
-    mds(m), messenger(msgr), mon_client(monc)
+    mds(m), messenger(msgr), mon_client(monc),
+    top_dirs(g_conf().get_val<uint64_t>("mds_bal_top_dirs"))
 {
   bal_fragment_dirs = g_conf().get_val<bool>("mds_bal_fragment_dirs");
   bal_fragment_interval = g_conf().get_val<int64_t>("mds_bal_fragment_interval");
@@ -86,6 +87,8 @@ void MDBalancer::handle_conf_change(const std::set<std::string>& changed, const
     bal_fragment_dirs = g_conf().get_val<bool>("mds_bal_fragment_dirs");
   if (changed.count("mds_bal_fragment_interval"))
     bal_fragment_interval = g_conf().get_val<int64_t>("mds_bal_fragment_interval");
+  if (changed.count("mds_bal_top_dirs"))
+    top_dirs.set_capacity(g_conf().get_val<uint64_t>("mds_bal_top_dirs"));
 }
 
 void MDBalancer::handle_export_pins(void)
@@ -230,6 +233,8 @@ void MDBalancer::tick()
   if (chrono::duration<double>(now-last_sample).count() >
     g_conf()->mds_bal_sample_interval) {
     dout(15) << "tick last_sample now " << now << dendl;
+    if (last_sample != clock::zero())
+      update_hot_dirs(chrono::duration<double>(now - last_sample).count());
     last_sample = now;
   }
 
@@ -265,6 +270,7 @@ double mds_load_t::mds_load() const
 {
   switch(g_conf()->mds_bal_mode) {
   case 0:
+  case MDBalancer::BAL_MODE_PREDICTIVE: // forecasting is applied on top
     return
       .8 * auth.meta_load() +
       .2 * all.meta_load() +
@@ -694,6 +700,14 @@ void MDBalancer::prep_rebalance(int beat)
 
     mds->mdcache->migrator->clear_export_queue();
 
+    const bool predictive = is_predictive();
+    const double alpha = g_conf().get_val<double>("mds_bal_predict_alpha");
+    const double beta = g_conf().get_val<double>("mds_bal_predict_beta");
+    const unsigned horizon = g_conf().get_val<uint64_t>("mds_bal_predict_horizon");
+    const size_t history = g_conf().get_val<uint64_t>("mds_bal_predict_history");
+    if (predictive)
+      sample_dirfrag_loads();
+
     // rescale!  turn my mds_load back into meta_load units
     double load_fac = 1.0;
     map<mds_rank_t, mds_load_t>::iterator m = mds_load.find(whoami);
@@ -715,6 +729,13 @@ void MDBalancer::prep_rebalance(int beat)
       mds_load_t& load = mds_load.at(i);
 
       double l = load.mds_load() * load_fac;
+      if (predictive) {
+	// balance on where each rank is heading rather than where it is,
+	// so that a burst which is already fading does not trigger exports
+	auto& fc = rank_forecasts[i];
+	fc.sample(beat_epoch, l, alpha, beta, history);
+	l = fc.predict(horizon);
+      }
       mds_meta_load[i] = l;
 
       if (whoami == 0)
@@ -913,7 +934,7 @@ void MDBalancer::try_rebalance(balance_state_t& state)
       continue;  // export pbly already in progress
 
     mds_rank_t from = diri->authority().first;
-    double pop = dir->pop_auth_subtree.meta_load();
+    double pop = get_export_pop(dir);
     if (g_conf()->mds_bal_idle_threshold > 0 &&
 	pop < g_conf()->mds_bal_idle_threshold &&
 	diri != mds->mdcache->get_root() &&
@@ -967,6 +988,9 @@ void MDBalancer::try_rebalance(balance_state_t& state)
 	if (pop <= amount-have) {
 	  dout(7) << "reexporting " << *dir << " pop " << pop
 		  << " back to mds." << target << dendl;
+	  if (is_predictive())
+	    record_decision(dir, target, get_export_pop(dir), 0, true,
+			    "reexport back to origin; cost not checked");
 	  mds->mdcache->migrator->export_dir_nicely(dir, target);
 	  have += pop;
 	  import_from_map.erase(plast);
@@ -1010,6 +1034,9 @@ void MDBalancer::try_rebalance(balance_state_t& state)
       if (pop <= amount-have && pop > MIN_REEXPORT) {
 	dout(5) << "reexporting " << *dir << " pop " << pop
 		<< " to mds." << target << dendl;
+	if (is_predictive())
+	  record_decision(dir, target, get_export_pop(dir), 0, true,
+			  "reexport of an import; cost not checked");
 	have += pop;
 	mds->mdcache->migrator->export_dir_nicely(dir, target);
 	import_pop_map.erase(p++);
@@ -1034,7 +1061,7 @@ void MDBalancer::try_rebalance(balance_state_t& state)
       continue;
 
     // okay, search for fragments of my workload
-    std::vector<CDir*> exports;
+    export_list_t exports;
 
     for (auto p = import_pop_map.rbegin();
 	 p != import_pop_map.rend();
@@ -1046,10 +1073,13 @@ void MDBalancer::try_rebalance(balance_state_t& state)
     }
     //fudge = amount - have;
 
-    for (const auto& dir : exports) {
+    for (const auto& [dir, reason] : exports) {
       dout(5) << "   - exporting " << dir->pop_auth_subtree
 	      << " " << dir->pop_auth_subtree.meta_load()
 	      << " to mds." << target << " " << *dir << dendl;
+      if (is_predictive())
+	record_decision(dir, target, get_export_pop(dir), get_export_cost(dir),
+			true, reason);
       mds->mdcache->migrator->export_dir_nicely(dir, target);
     }
   }
@@ -1060,7 +1090,7 @@ void MDBalancer::try_rebalance(balance_state_t& state)
 
 void MDBalancer::find_exports(CDir *dir,
                               double amount,
-                              std::vector<CDir*>* exports,
+                              export_list_t* exports,
                               double& have,
                               set<CDir*>& already_exporting)
 {
@@ -1086,7 +1116,8 @@ void MDBalancer::find_exports(CDir *dir,
   std::vector<CDir*> bigger_rep, bigger_unrep;
   multimap<double, CDir*> smaller;
 
-  double dir_pop = dir->pop_auth_subtree.meta_load();
+  const bool predictive = is_predictive();
+  double dir_pop = get_export_pop(dir);
   dout(7) << "in " << dir_pop << " " << *dir << " need " << need << " (" << needmin << " - " << needmax << ")" << dendl;
 
   double subdir_sum = 0;
@@ -1112,7 +1143,7 @@ void MDBalancer::find_exports(CDir *dir,
 	continue;  // can't export this right now!
 
       // how popular?
-      double pop = subdir->pop_auth_subtree.meta_load();
+      double pop = get_export_pop(subdir);
       subdir_sum += pop;
       dout(15) << "   subdir pop " << pop << " " << *subdir << dendl;
 
@@ -1121,9 +1152,21 @@ void MDBalancer::find_exports(CDir *dir,
 	continue;
       }
 
+      if (predictive) {
+	// only move it if what we expect to shed pays for the migration
+	double cost = get_export_cost(subdir);
+	if (pop < cost) {
+	  dout(15) << "   forecast " << pop << " < export cost " << cost
+		   << ", not exporting " << *subdir << dendl;
+	  record_decision(subdir, MDS_RANK_NONE, pop, cost, false,
+			  "cost exceeds benefit");
+	  continue;
+	}
+      }
+
       // lucky find?
       if (pop > needmin && pop < needmax) {
-	exports->push_back(subdir);
+	exports->emplace_back(subdir, "forecast pays for export; fits the need");
 	already_exporting.insert(subdir);
 	have += pop;
 	return;
@@ -1153,7 +1196,8 @@ void MDBalancer::find_exports(CDir *dir,
 
     dout(7) << "   taking smaller " << *(*it).second << dendl;
 
-    exports->push_back((*it).second);
+    exports->emplace_back((*it).second,
+			  "forecast pays for export; large part of the need");
     already_exporting.insert((*it).second);
     have += (*it).first;
     if (have > needmin)
@@ -1174,7 +1218,8 @@ void MDBalancer::find_exports(CDir *dir,
        ++it) {
     dout(7) << "   taking (much) smaller " << it->first << " " << *(*it).second << dendl;
 
-    exports->push_back((*it).second);
+    exports->emplace_back((*it).second,
+			  "forecast pays for export; small part of the need");
     already_exporting.insert((*it).second);
     have += (*it).first;
     if (have > needmin)
@@ -1236,6 +1281,12 @@ void MDBalancer::hit_dir(CDir *dir, int type, int who, double amount)
   // hit me
   double v = dir->pop_me.get(type).hit(amount);
 
+  // rank directories by client requests only; fetches, stores and
+  // readdir's per-entry weight would crowd out the busiest ones
+  if (!dir->inode->is_base() &&
+      (type == META_POP_IRD || type == META_POP_IWR))
+    top_dirs.hit(dir->ino(), amount);
+
   const bool hot = (v > g_conf()->mds_bal_split_rd && type == META_POP_IRD) ||
                    (v > g_conf()->mds_bal_split_wr && type == META_POP_IWR);
 
@@ -1402,6 +1453,96 @@ void MDBalancer::handle_mds_failure(mds_rank_t who)
   if (0 == who) {
     mds_last_epoch_under_map.clear();
   }
+  rank_forecasts.erase(who);
+}
+
+bool MDBalancer::is_predictive() const
+{
+  return g_conf()->mds_bal_mode == BAL_MODE_PREDICTIVE;
+}
+
+void MDBalancer::sample_dirfrag_loads()
+{
+  const double alpha = g_conf().get_val<double>("mds_bal_predict_alpha");
+  const double beta = g_conf().get_val<double>("mds_bal_predict_beta");
+  const uint64_t history = g_conf().get_val<uint64_t>("mds_bal_predict_history");
+  const uint64_t max_dirfrags = g_conf().get_val<uint64_t>("mds_bal_predict_max_dirfrags");
+
+  // Walk the auth subtree roots and, below them, the subdirs that have
+  // been hit recently (pop_lru_subdirs); those are the only candidates
+  // find_exports() will consider, so there is no point in sampling more.
+  std::vector<CDir*> q = mds->mdcache->get_fullauth_subtrees();
+  uint64_t sampled = 0;
+  while (!q.empty() && sampled < max_dirfrags) {
+    CDir *dir = q.back();
+    q.pop_back();
+
+    double pop = dir->pop_auth_subtree.meta_load();
+    auto it = dirfrag_forecasts.find(dir->dirfrag());
+    if (it == dirfrag_forecasts.end()) {
+      if (pop < .001 || dirfrag_forecasts.size() >= max_dirfrags)
+	continue;
+      it = dirfrag_forecasts.emplace(dir->dirfrag(), LoadForecast()).first;
+    } else if (it->second.get_num_samples() > 0 &&
+	       it->second.get_last_epoch() == beat_epoch) {
+      continue;  // reached twice (e.g. nested subtree root)
+    }
+    it->second.sample(beat_epoch, pop, alpha, beta, history);
+    sampled++;
+
+    for (auto p = dir->pop_lru_subdirs.begin_use_current(); !p.end(); ++p) {
+      for (const auto& subdir : (*p)->get_nested_dirfrags()) {
+	if (subdir->is_auth())
+	  q.push_back(subdir);
+      }
+    }
+  }
+
+  // forget dirfrags that have gone quiet, were exported or were trimmed
+  for (auto it = dirfrag_forecasts.begin(); it != dirfrag_forecasts.end(); ) {
+    if (beat_epoch - it->second.get_last_epoch() > (int)history)
+      it = dirfrag_forecasts.erase(it);
+    else
+      ++it;
+  }
+  dout(15) << "sampled " << sampled << " dirfrags, tracking "
+	   << dirfrag_forecasts.size() << dendl;
+}
+
+double MDBalancer::get_export_pop(CDir *dir) const
+{
+  double pop = dir->pop_auth_subtree.meta_load();
+  if (!is_predictive())
+    return pop;
+
+  auto it = dirfrag_forecasts.find(dir->dirfrag());
+  if (it == dirfrag_forecasts.end())
+    return pop;
+  const unsigned horizon = g_conf().get_val<uint64_t>("mds_bal_predict_horizon");
+  return it->second.predict(horizon);
+}
+
+double MDBalancer::get_export_cost(CDir *dir) const
+{
+  auto cost = mds->mdcache->migrator->estimate_export_cost(dir);
+  return cost.inodes + cost.dirfrags + cost.caps;
+}
+
+void MDBalancer::record_decision(CDir *dir, mds_rank_t target, double predicted,
+                                 double cost, bool exported, std::string_view reason)
+{
+  bal_decision_t d;
+  d.epoch = beat_epoch;
+  d.df = dir->dirfrag();
+  d.target = target;
+  d.pop = dir->pop_auth_subtree.meta_load();
+  d.predicted = predicted;
+  d.cost = cost;
+  d.exported = exported;
+  d.reason = reason;
+  bal_decisions.push_back(d);
+  while (bal_decisions.size() > MAX_DECISIONS)
+    bal_decisions.pop_front();
 }
 
 int MDBalancer::dump_loads(Formatter *f) const
@@ -1496,3 +1637,135 @@ int MDBalancer::dump_loads(Formatter *f) const
   f->close_section(); // loads
   return 0;
 }
+
+int MDBalancer::dump_forecast(Formatter *f) const
+{
+  const unsigned horizon = g_conf().get_val<uint64_t>("mds_bal_predict_horizon");
+
+  f->open_object_section("forecast");
+  f->dump_bool("predictive", is_predictive());
+  f->dump_int("epoch", beat_epoch);
+  f->dump_unsigned("horizon", horizon);
+
+  f->open_array_section("ranks");
+  for (const auto& [rank, fc] : rank_forecasts) {
+    f->open_object_section("rank");
+    f->dump_int("rank", rank);
+    fc.dump(f, horizon);
+    f->close_section();
+  }
+  f->close_section(); // ranks
+
+  f->open_array_section("dirfrags");
+  for (const auto& [df, fc] : dirfrag_forecasts) {
+    f->open_object_section("dirfrag");
+    f->dump_stream("dirfrag") << df;
+    fc.dump(f, horizon);
+    f->close_section();
+  }
+  f->close_section(); // dirfrags
+
+  f->open_array_section("decisions");
+  for (const auto& d : bal_decisions) {
+    f->open_object_section("decision");
+    f->dump_int("epoch", d.epoch);
+    f->dump_stream("dirfrag") << d.df;
+    f->dump_int("target", d.target);
+    f->dump_float("pop", d.pop);
+    f->dump_float("predicted", d.predicted);
+    f->dump_float("cost", d.cost);
+    f->dump_bool("exported", d.exported);
+    f->dump_string("reason", d.reason);
+    f->close_section();
+  }
+  f->close_section(); // decisions
+
+  f->close_section(); // forecast
+  return 0;
+}
+
+double MDBalancer::top_dir_rate(double count) const
+{
+  // decay() applies exp(-ln2 * dt / halflife), so a steady r hits/s
+  // settles at r * halflife / ln2
+  double halflife = g_conf().get_val<double>("mds_decay_halflife");
+  return halflife > 0 ? count * M_LN2 / halflife : count;
+}
+
+void MDBalancer::update_hot_dirs(double elapsed)
+{
+  double halflife = g_conf().get_val<double>("mds_decay_halflife");
+  if (halflife > 0)
+    top_dirs.decay(std::exp(-M_LN2 * elapsed / halflife));
+
+  const double hot = g_conf().get_val<double>("mds_bal_hot_dir_threshold");
+  const double cool = hot * g_conf().get_val<double>("mds_bal_hot_dir_cool_ratio");
+  const uint64_t need = g_conf().get_val<uint64_t>("mds_bal_hot_dir_samples");
+
+  std::map<inodeno_t, hot_dir_t> next;
+  if (hot > 0) {
+    for (const auto& [ino, e] : top_dirs.top(top_dirs.size())) {
+      double rate = top_dir_rate(e.count - e.error);
+      auto p = hot_dirs.find(ino);
+      hot_dir_t h = p == hot_dirs.end() ? hot_dir_t() : p->second;
+      if (rate >= hot) {
+        h.hot_samples++;
+      } else if (rate < cool) {
+        // cooled off; only a fresh streak can raise it again
+        h = hot_dir_t();
+      } else {
+        // the streak is broken, but a raised suggestion stays until the
+        // directory cools off
+        h.hot_samples = 0;
+      }
+      if (!h.suggested && h.hot_samples >= need) {
+        h.suggested = true;
+        CInode *in = mds->mdcache->get_inode(ino);
+        if (in && in->get_export_pin(false) == MDS_RANK_NONE &&
+            !in->get_inode()->export_ephemeral_distributed_pin) {
+          std::string path;
+          in->make_path_string(path);
+          mds->clog->info() << "directory " << path << " (" << ino << ") has"
+                            << " sustained " << rate << " req/s; consider"
+                            << " setting ceph.dir.pin.distributed on it";
+        }
+      }
+      if (h.hot_samples || h.suggested)
+        next.emplace(ino, h);
+    }
+  }
+  hot_dirs.swap(next);
+}
+
+int MDBalancer::dump_top_dirs(Formatter *f, size_t count) const
+{
+  f->open_object_section("top_dirs");
+  f->dump_unsigned("capacity", top_dirs.get_capacity());
+  f->dump_float("hot_threshold",
+                g_conf().get_val<double>("mds_bal_hot_dir_threshold"));
+  f->open_array_section("dirs");
+  for (const auto& [ino, e] : top_dirs.top(count)) {
+    f->open_object_section("dir");
+    f->dump_stream("ino") << ino;
+    CInode *in = mds->mdcache->get_inode(ino);
+    if (in) {
+      std::string path;
+      in->make_path_string(path);
+      f->dump_string("path", path);
+      f->dump_int("export_pin", in->get_export_pin(false));
+      f->dump_bool("distributed_pin",
+                   in->get_inode()->export_ephemeral_distributed_pin);
+    }
+    f->dump_float("rate", top_dir_rate(e.count));
+    f->dump_float("rate_error", top_dir_rate(e.error));
+    auto p = hot_dirs.find(ino);
+    f->dump_unsigned("hot_samples", p == hot_dirs.end() ? 0 : p->second.hot_samples);
+    f->dump_bool("suggest_pin", p != hot_dirs.end() && p->second.suggested &&
+                                in && in->get_export_pin(false) == MDS_RANK_NONE &&
+                                !in->get_inode()->export_ephemeral_distributed_pin);
+    f->close_section();
+  }
+  f->close_section(); // dirs
+  f->close_section(); // top_dirs
+  return 0;
+}
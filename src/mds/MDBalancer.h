@@ -22,6 +22,8 @@
 #include "messages/MHeartbeat.h"
 
 #include "MDSMap.h"
+#include "LoadForecast.h"
+#include "HeavyHitters.h"
 
 class MDSRank;
 class MHeartbeat;
@@ -32,6 +34,9 @@ class MonClient;
 
 class MDBalancer {
 public:
+  // mds_bal_mode values
+  static const int BAL_MODE_PREDICTIVE = 3;
+
   using clock = ceph::coarse_mono_clock;
   using time = ceph::coarse_mono_time;
   friend class C_Bal_SendHeartbeat;
@@ -75,6 +80,8 @@ public:
   void handle_mds_failure(mds_rank_t who);
 
   int dump_loads(Formatter *f) const;
+  int dump_forecast(Formatter *f) const;
+  int dump_top_dirs(Formatter *f, size_t count) const;
 
 private:
   typedef struct {
@@ -83,6 +90,26 @@ private:
     std::map<mds_rank_t, double> exported;
   } balance_state_t;
 
+  // a migration decision made by the predictive balancer, kept for
+  // the `dump forecast` admin socket command
+  struct bal_decision_t {
+    int epoch = 0;
+    dirfrag_t df;
+    mds_rank_t target = MDS_RANK_NONE;
+    double pop = 0;
+    double predicted = 0;
+    double cost = 0;
+    bool exported = false;
+    std::string_view reason;
+  };
+  static const size_t MAX_DECISIONS = 128;
+
+  // hysteresis state for a directory in the top-dirs table
+  struct hot_dir_t {
+    unsigned hot_samples = 0;  // consecutive samples above the hot threshold
+    bool suggested = false;    // pin suggestion currently raised
+  };
+
   //set up the rebalancing targets for export and do one if the
   //MDSMap is up to date
   void prep_rebalance(int beat);
@@ -92,9 +119,11 @@ private:
   int localize_balancer();
   void send_heartbeat();
   void handle_heartbeat(const cref_t<MHeartbeat> &m);
+  // each export comes with why it was picked, for the decision log
+  typedef std::vector<std::pair<CDir*, std::string_view>> export_list_t;
   void find_exports(CDir *dir,
                     double amount,
-                    std::vector<CDir*>* exports,
+                    export_list_t* exports,
                     double& have,
                     std::set<CDir*>& already_exporting);
 
@@ -118,6 +147,34 @@ private:
    */
   void try_rebalance(balance_state_t& state);
 
+  bool is_predictive() const;
+  /**
+   * Refresh the forecasts of all auth subtree roots and the recently
+   * popular dirfrags beneath them. Called once per balancer epoch.
+   */
+  void sample_dirfrag_loads();
+  /**
+   * The load the balancer should attribute to a candidate dirfrag:
+   * the current popularity, or its forecast in predictive mode.
+   */
+  double get_export_pop(CDir *dir) const;
+  /**
+   * What exporting a candidate dirfrag costs, in load units: every inode,
+   * dirfrag and client cap the Migrator estimates it would move counts as
+   * one metadata operation.
+   */
+  double get_export_cost(CDir *dir) const;
+  void record_decision(CDir *dir, mds_rank_t target, double predicted,
+                       double cost, bool exported, std::string_view reason);
+
+  /**
+   * Age the top-dirs table by `elapsed` seconds and re-evaluate which
+   * directories have stayed hot long enough to suggest pinning.
+   */
+  void update_hot_dirs(double elapsed);
+  // exponentially decayed hit count -> hits per second
+  double top_dir_rate(double count) const;
+
   bool bal_fragment_dirs;
   int64_t bal_fragment_interval;
   static const unsigned int AUTH_TREES_THRESHOLD = 5;
@@ -155,5 +212,14 @@ private:
   // per-epoch state
   double my_load = 0;
   double target_load = 0;
+
+  // predictive balancer (mds_bal_mode 3) state
+  std::map<mds_rank_t, LoadForecast> rank_forecasts;
+  std::map<dirfrag_t, LoadForecast> dirfrag_forecasts;
+  std::deque<bal_decision_t> bal_decisions;
+
+  // request-rate heavy hitters among directories, fed by hit_dir()
+  SpaceSaving<inodeno_t> top_dirs;
+  std::map<inodeno_t, hot_dir_t> hot_dirs;
 };
 #endif
@@ -6647,6 +6647,22 @@ std::pair<bool, uint64_t> MDCache::trim_lru(uint64_t count, expiremap& expiremap
   uint64_t trimmed = 0;
 
   auto trim_threshold = g_conf().get_val<Option::size_t>("mds_cache_trim_threshold");
+  auto trim_budget = g_conf().get_val<double>("mds_cache_trim_budget");
+  auto trim_start = mono_clock::now();
+  uint64_t visited = 0;
+
+  // Bound how long a single pass may hold mds_lock; checking the clock
+  // every few dentries is plenty.  A full trim (cache drop, shutdown)
+  // means to empty the cache, so it is not bounded.
+  if (count == UINT64_MAX)
+    trim_budget = 0;
+  bool out_of_budget = false;
+  auto over_budget = [&]() {
+    if (trim_budget > 0 && (++visited % 32) == 0 &&
+        mono_clock::now() - trim_start >= make_timespan(trim_budget))
+      out_of_budget = true;
+    return out_of_budget;
+  };
 
   dout(7) << "trim_lru trimming " << count
           << " items from LRU"
@@ -6660,6 +6676,7 @@ std::pair<bool, uint64_t> MDCache::trim_lru(uint64_t count, expiremap& expiremap
   bool throttled = false;
   while (1) {
     throttled |= trim_counter_start+trimmed >= trim_threshold;
+    throttled |= over_budget();
     if (throttled) break;
     CDentry *dn = static_cast<CDentry*>(bottom_lru.lru_expire());
     if (!dn)
@@ -6680,6 +6697,7 @@ std::pair<bool, uint64_t> MDCache::trim_lru(uint64_t count, expiremap& expiremap
   // if mds is in standby_replay and skip trimming the inodes
   while (!throttled && (cache_toofull() || count > 0 || is_standby_replay)) {
     throttled |= trim_counter_start+trimmed >= trim_threshold;
+    throttled |= over_budget();
     if (throttled) break;
     CDentry *dn = static_cast<CDentry*>(lru.lru_expire());
     if (!dn) {
@@ -6704,6 +6722,13 @@ std::pair<bool, uint64_t> MDCache::trim_lru(uint64_t count, expiremap& expiremap
   }
   unexpirables.clear();
 
+  trim_over_budget = out_of_budget;
+  if (out_of_budget) {
+    dout(7) << "trim_lru ran out of budget (" << trim_budget << "s)" << dendl;
+    if (logger)
+      logger->inc(l_mdc_trim_budget_exceeded);
+  }
+
   dout(7) << "trim_lru trimmed " << trimmed << " items" << dendl;
   return std::pair<bool, uint64_t>(throttled, trimmed);
 }
@@ -12495,8 +12520,22 @@ void MDCache::cache_status(Formatter *f)
 {
   f->open_object_section("cache");
 
+  auto& pool = mempool::get_pool(mempool::mds_co::id);
   f->open_object_section("pool");
-  mempool::get_pool(mempool::mds_co::id).dump(f);
+  pool.dump(f);
+  f->close_section();
+
+  // footprint per cached inode, counting everything in the mds_co pool
+  // (inodes, dentries, dirfrags and their containers)
+  uint64_t num_inodes = inode_map.size() + snap_inode_map.size();
+  f->open_object_section("footprint");
+  f->dump_unsigned("inodes", num_inodes);
+  f->dump_unsigned("dentries", lru.lru_get_size() + bottom_lru.lru_get_size());
+  f->dump_unsigned("bytes_per_inode",
+		   num_inodes ? pool.allocated_bytes() / num_inodes : 0);
+  f->dump_unsigned("sizeof_inode", sizeof(CInode));
+  f->dump_unsigned("sizeof_dentry", sizeof(CDentry));
+  f->dump_unsigned("sizeof_dirfrag", sizeof(CDir));
   f->close_section();
 
   f->close_section();
@@ -13117,6 +13156,27 @@ void MDCache::register_perfcounters()
     pcb.add_u64_counter(l_mdc_recovery_started, "recovery_started",
                         "File recoveries started");
 
+    // cache trimming
+    PerfHistogramCommon::axis_config_d trim_hist_x_axis_config{
+      "Latency (usec)",
+      PerfHistogramCommon::SCALE_LOG2, ///< Latency in logarithmic scale
+      0,                               ///< Start at 0
+      100,                             ///< Quantization unit is 100usec
+      24,                              ///< Up to ~800 seconds
+    };
+    PerfHistogramCommon::axis_config_d trim_hist_y_axis_config{
+      "Dentries trimmed",
+      PerfHistogramCommon::SCALE_LOG2, ///< Count in logarithmic scale
+      0,                               ///< Start at 0
+      1,                               ///< Quantization unit is 1 dentry
+      24,                              ///< Enough for any trim pass
+    };
+    pcb.add_u64_counter_histogram(l_mdc_trim_lock_hist, "trim_lock_histogram",
+                                  trim_hist_x_axis_config, trim_hist_y_axis_config,
+                                  "Histogram of time spent trimming under mds_lock + dentries trimmed");
+    pcb.add_u64_counter(l_mdc_trim_budget_exceeded, "trim_budget_exceeded",
+                        "Trim passes stopped by mds_cache_trim_budget");
+
     // along with other stray dentries stats
     pcb.add_u64(l_mdc_num_strays_delayed, "num_strays_delayed",
                 "Stray dentries delayed");
@@ -13260,7 +13320,7 @@ void MDCache::upkeep_main(void)
     auto now = clock::now();
     auto since = now-upkeep_last_trim;
     auto trim_interval = clock::duration(g_conf().get_val<std::chrono::seconds>("mds_cache_trim_interval"));
-    if (since >= trim_interval*.90) {
+    if (since >= trim_interval*.90 || trim_over_budget) {
       lock.unlock(); /* mds_lock -> upkeep_mutex */
       std::scoped_lock mds_lock(mds->mds_lock);
       lock.lock();
@@ -13273,7 +13333,16 @@ void MDCache::upkeep_main(void)
         if (active_with_clients) {
           trim_client_leases();
         }
-        trim();
+        auto trim_start = mono_clock::now();
+        auto trimmed = trim().second;
+        auto trim_lat = mono_clock::now() - trim_start;
+        if (logger) {
+          logger->hinc(l_mdc_trim_lock_hist,
+                       std::chrono::duration_cast<std::chrono::microseconds>(trim_lat).count(),
+                       trimmed);
+        }
+        if (trim_over_budget && !cache_toofull())
+          trim_over_budget = false;
         if (active_with_clients) {
           auto recall_flags = Server::RecallFlags::ENFORCE_MAX|Server::RecallFlags::ENFORCE_LIVENESS;
           if (cache_toofull()) {
@@ -13282,6 +13351,11 @@ void MDCache::upkeep_main(void)
           mds->server->recall_client_state(nullptr, recall_flags);
         }
         upkeep_last_trim = now = clock::now();
+        if (trim_over_budget) {
+          // come back once mds_lock has been free for about as long as we
+          // just held it, rather than waiting out a full trim interval
+          trim_interval = std::chrono::duration_cast<clock::duration>(trim_lat);
+        }
       } else {
         dout(10) << "cache not ready for trimming" << dendl;
       }
@@ -99,6 +99,11 @@ enum {
   // How many inodes ever completed size recovery
   l_mdc_recovery_completed,
 
+  // Time spent trimming under mds_lock vs. dentries trimmed
+  l_mdc_trim_lock_hist,
+  // Trim passes cut short by mds_cache_trim_budget
+  l_mdc_trim_budget_exceeded,
+
   l_mdss_ireq_enqueue_scrub,
   l_mdss_ireq_exportdir,
   l_mdss_ireq_flush,
@@ -1333,6 +1338,9 @@ class MDCache {
   std::map<dirfrag_t,fragment_info_t> fragments;
 
   DecayCounter trim_counter;
+  // the last trim_lru() stopped because it ran out of mds_cache_trim_budget;
+  // set under mds_lock, read by the upkeep thread without it
+  std::atomic<bool> trim_over_budget = false;
 
   std::thread upkeeper;
   ceph::mutex upkeep_mutex = ceph::make_mutex("MDCache::upkeep_mutex");
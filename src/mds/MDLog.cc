@@ -17,6 +17,7 @@
 #include "MDCache.h"
 #include "LogEvent.h"
 #include "MDSContext.h"
+#include "ReplayDecodePool.h"
 
 #include "osdc/Journaler.h"
 #include "mds/JournalPointer.h"
@@ -69,6 +70,10 @@ void MDLog::create_logger()
   plb.add_u64_counter(l_mdl_replayed, "replayed", "Events replayed",
 		      "repl", PerfCountersBuilder::PRIO_INTERESTING);
   plb.add_time_avg(l_mdl_jlat, "jlat", "Journaler flush latency");
+  plb.add_u64_avg(l_mdl_batch, "batch", "Events per journal submit batch");
+  plb.add_time_avg(l_mdl_enclat, "encode_lat", "Event encoding latency");
+  plb.add_time_avg(l_mdl_replay_declat, "replay_decode_lat",
+                   "Replay batch decoding latency");
   plb.add_u64_counter(l_mdl_evex, "evex", "Total expired events");
   plb.add_u64_counter(l_mdl_evtrm, "evtrm", "Trimmed events");
   plb.add_u64_counter(l_mdl_segadd, "segadd", "Segments added");
@@ -375,68 +380,116 @@ void MDLog::_submit_thread()
       continue;
     }
 
+    const uint64_t max_batch =
+      g_conf().get_val<uint64_t>("mds_log_max_batch_events");
+    const double group_wait =
+      g_conf().get_val<double>("mds_log_group_commit_latency");
+
+    // Group commit: only hold the batch back if the last one actually
+    // coalesced concurrent submitters, so a lone serial writer never pays
+    // the extra latency.  Anything that asks for a flush, or a segment
+    // boundary, goes out immediately.
+    if (group_wait > 0 && last_batch_size > 1 &&
+	pending_events.size() == 1 &&
+	it->second.size() < max_batch &&
+	it->second.front().le) {
+      bool want_flush = std::any_of(it->second.begin(), it->second.end(),
+				    [](const PendingEvent& p) { return p.flush; });
+      double age = ceph_clock_now() - it->second.front().le->get_stamp();
+      if (!want_flush && age < group_wait) {
+	submit_cond.wait_for(locker, ceph::make_timespan(group_wait - age));
+	continue;
+      }
+    }
+
     int64_t features = mdsmap_up_features;
-    PendingEvent data = it->second.front();
-    it->second.pop_front();
+    vector<PendingEvent> batch;
+    batch.reserve(std::min<uint64_t>(max_batch, it->second.size()));
+    while (!it->second.empty() && batch.size() < max_batch) {
+      batch.push_back(it->second.front());
+      it->second.pop_front();
+    }
 
     locker.unlock();
 
-    if (data.le) {
-      LogEvent *le = data.le;
-      LogSegment *ls = le->_segment;
-      // encode it, with event type
-      bufferlist bl;
-      le->encode_with_header(bl, features);
+    // encode the whole batch up front, then append it to the journal in
+    // submission order.
+    vector<bufferlist> encoded(batch.size());
+    size_t num_encoded = 0;
+    bool do_flush = false;
+    auto encode_start = ceph::mono_clock::now();
+    for (size_t i = 0; i < batch.size(); ++i) {
+      if (batch[i].le) {
+	batch[i].le->encode_with_header(encoded[i], features);
+	++num_encoded;
+      }
+    }
+    if (logger && num_encoded) {
+      logger->tinc(l_mdl_enclat, ceph::mono_clock::now() - encode_start);
+      logger->inc(l_mdl_batch, num_encoded);
+    }
 
-      uint64_t write_pos = journaler->get_write_pos();
+    for (size_t i = 0; i < batch.size(); ++i) {
+      _submit_pending(batch[i], encoded[i]);
+      do_flush |= batch[i].flush;
+    }
 
-      le->set_start_off(write_pos);
-      if (le->get_type() == EVENT_SUBTREEMAP)
-	ls->offset = write_pos;
+    // one flush covers every flush request in the batch
+    if (do_flush)
+      journaler->flush();
 
-      dout(5) << "_submit_thread " << write_pos << "~" << bl.length()
-	      << " : " << *le << dendl;
+    locker.lock();
+    last_batch_size = num_encoded;
+    for (const auto& data : batch) {
+      if (data.flush)
+	unflushed = 0;
+      else if (data.le)
+	unflushed++;
+    }
+  }
+}
 
-      // journal it.
-      const uint64_t new_write_pos = journaler->append_entry(bl);  // bl is destroyed.
-      ls->end = new_write_pos;
+void MDLog::_submit_pending(const PendingEvent& data, bufferlist& bl)
+{
+  if (data.le) {
+    LogEvent *le = data.le;
+    LogSegment *ls = le->_segment;
 
-      MDSLogContextBase *fin;
-      if (data.fin) {
-	fin = dynamic_cast<MDSLogContextBase*>(data.fin);
-	ceph_assert(fin);
-	fin->set_write_pos(new_write_pos);
-      } else {
-	fin = new C_MDL_Flushed(this, new_write_pos);
-      }
+    uint64_t write_pos = journaler->get_write_pos();
 
-      journaler->wait_for_flush(fin);
+    le->set_start_off(write_pos);
+    if (le->get_type() == EVENT_SUBTREEMAP)
+      ls->offset = write_pos;
 
-      if (data.flush)
-	journaler->flush();
+    dout(5) << "_submit_thread " << write_pos << "~" << bl.length()
+	    << " : " << *le << dendl;
 
-      if (logger)
-	logger->set(l_mdl_wrpos, ls->end);
+    // journal it.
+    const uint64_t new_write_pos = journaler->append_entry(bl);  // bl is destroyed.
+    ls->end = new_write_pos;
 
-      delete le;
+    MDSLogContextBase *fin;
+    if (data.fin) {
+      fin = dynamic_cast<MDSLogContextBase*>(data.fin);
+      ceph_assert(fin);
+      fin->set_write_pos(new_write_pos);
     } else {
-      if (data.fin) {
-	MDSContext* fin =
-		dynamic_cast<MDSContext*>(data.fin);
-	ceph_assert(fin);
-	C_MDL_Flushed *fin2 = new C_MDL_Flushed(this, fin);
-	fin2->set_write_pos(journaler->get_write_pos());
-	journaler->wait_for_flush(fin2);
-      }
-      if (data.flush)
-	journaler->flush();
+      fin = new C_MDL_Flushed(this, new_write_pos);
     }
 
-    locker.lock();
-    if (data.flush)
-      unflushed = 0;
-    else if (data.le)
-      unflushed++;
+    journaler->wait_for_flush(fin);
+
+    if (logger)
+      logger->set(l_mdl_wrpos, ls->end);
+
+    delete le;
+  } else if (data.fin) {
+    MDSContext* fin =
+	    dynamic_cast<MDSContext*>(data.fin);
+    ceph_assert(fin);
+    C_MDL_Flushed *fin2 = new C_MDL_Flushed(this, fin);
+    fin2->set_write_pos(journaler->get_write_pos());
+    journaler->wait_for_flush(fin2);
   }
 }
 
@@ -936,6 +989,10 @@ void MDLog::replay(MDSContext *c)
   }
   already_replayed = true;
 
+  uint64_t periods = g_conf().get_val<uint64_t>("mds_replay_prefetch_periods");
+  if (periods)
+    journaler->set_prefetch_periods(std::max<uint64_t>(periods, 2));
+
   replay_thread.create("md_log_replay");
 }
 
@@ -1302,6 +1359,9 @@ void MDLog::_replay_thread()
 {
   dout(10) << "_replay_thread start" << dendl;
 
+  ReplayDecodePool decode_pool(
+    g_conf().get_val<uint64_t>("mds_replay_decode_threads"));
+
   // loop
   int r = 0;
   while (1) {
@@ -1376,17 +1436,113 @@ void MDLog::_replay_thread()
       break;
     
     ceph_assert(journaler->is_readable() || mds->is_daemon_stopping());
-    
-    // read it
-    uint64_t pos = journaler->get_read_pos();
-    bufferlist bl;
-    bool r = journaler->try_read_entry(bl);
-    if (!r && journaler->get_error())
+
+    // read whatever is already prefetched, up to a batch
+    const uint64_t max_batch =
+      g_conf().get_val<uint64_t>("mds_replay_batch_events");
+    std::vector<ReplayEntry> batch;
+    while (batch.size() < max_batch &&
+	   (batch.empty() || journaler->is_readable())) {
+      ReplayEntry re;
+      re.pos = journaler->get_read_pos();
+      if (!journaler->try_read_entry(re.bl))
+	break;
+      re.end = journaler->get_read_pos();
+      batch.push_back(std::move(re));
+    }
+    if (batch.empty() && journaler->get_error())
       continue;
-    ceph_assert(r);
-    
-    // unpack event
-    auto le = LogEvent::decode_event(bl.cbegin());
+    ceph_assert(!batch.empty());
+
+    _replay_decode(decode_pool, batch);
+    if (!_replay_apply(batch))
+      return;
+  }
+
+  // done!
+  if (r == 0) {
+    ceph_assert(journaler->get_read_pos() == journaler->get_write_pos());
+    dout(10) << "_replay - complete, " << num_events
+	     << " events" << dendl;
+
+    logger->set(l_mdl_expos, journaler->get_expire_pos());
+  }
+
+  safe_pos = journaler->get_write_safe_pos();
+
+  dout(10) << "_replay_thread kicking waiters" << dendl;
+  {
+    std::lock_guard l(mds->mds_lock);
+    if (mds->is_daemon_stopping()) {
+      return;
+    }
+    pre_segments_size = segments.size();  // get num of logs when replay is finished
+    finish_contexts(g_ceph_context, waitfor_replay, r);  
+  }
+
+  dout(10) << "_replay_thread finish" << dendl;
+}
+
+void MDLog::_replay_decode(ReplayDecodePool& pool,
+			   std::vector<ReplayEntry>& batch)
+{
+  auto decode_one = [](ReplayEntry& re) {
+    try {
+      re.le = LogEvent::decode_event(re.bl.cbegin());
+      // unpack the dentries too, so that applying the event under
+      // mds_lock doesn't have to.  An event whose dentries don't decode
+      // is treated like one that doesn't decode at all: as corrupt.
+      if (re.le) {
+	if (EMetaBlob *blob = re.le->get_metablob())
+	  blob->decode_bits();
+      }
+    } catch (const buffer::error &e) {
+      re.le.reset();
+    }
+  };
+
+  auto start = ceph::mono_clock::now();
+
+  // don't bother waking the pool for a handful of events
+  if (pool.size() <= 1 || batch.size() / 8 <= 1) {
+    for (auto& re : batch)
+      decode_one(re);
+  } else {
+    pool.run(batch.size(), [&](size_t i) { decode_one(batch[i]); });
+  }
+
+  logger->tinc(l_mdl_replay_declat, ceph::mono_clock::now() - start);
+}
+
+/**
+ * Apply a decoded batch in journal order.  Events are applied under a
+ * single mds_lock acquisition, except that the pending ones are flushed
+ * whenever a new segment begins so that replay always sees the segment
+ * it belongs to as the current one.
+ *
+ * @return false if the daemon is stopping and replay must bail out
+ */
+bool MDLog::_replay_apply(std::vector<ReplayEntry>& batch)
+{
+  std::vector<LogEvent*> ready;
+  auto apply_ready = [this, &ready]() {
+    if (ready.empty())
+      return true;
+    std::lock_guard l(mds->mds_lock);
+    if (mds->is_daemon_stopping())
+      return false;
+    for (auto le : ready) {
+      logger->inc(l_mdl_replayed);
+      le->replay(mds);
+    }
+    ready.clear();
+    return true;
+  };
+
+  for (auto& re : batch) {
+    uint64_t pos = re.pos;
+    bufferlist& bl = re.bl;
+    LogEvent *le = re.le.get();
     if (!le) {
       dout(0) << "_replay " << pos << "~" << bl.length() << " / " << journaler->get_write_pos() 
 	      << " -- unable to decode event" << dendl;
@@ -1411,7 +1567,9 @@ void MDLog::_replay_thread()
     // new segment?
     if (le->get_type() == EVENT_SUBTREEMAP ||
 	le->get_type() == EVENT_RESETJOURNAL) {
-      auto sle = dynamic_cast<ESubtreeMap*>(le.get());
+      if (!apply_ready())
+	return false;
+      auto sle = dynamic_cast<ESubtreeMap*>(le);
       if (sle && sle->event_seq > 0)
 	event_seq = sle->event_seq;
       else
@@ -1431,44 +1589,17 @@ void MDLog::_replay_thread()
 	       << " " << le->get_stamp() << ": " << *le << dendl;
       le->_segment = get_current_segment();    // replay may need this
       le->_segment->num_events++;
-      le->_segment->end = journaler->get_read_pos();
+      le->_segment->end = re.end;
       num_events++;
-
-      {
-        std::lock_guard l(mds->mds_lock);
-        if (mds->is_daemon_stopping()) {
-          return;
-        }
-        logger->inc(l_mdl_replayed);
-        le->replay(mds);
-      }
+      ready.push_back(le);
     }
-
-    logger->set(l_mdl_rdpos, pos);
   }
 
-  // done!
-  if (r == 0) {
-    ceph_assert(journaler->get_read_pos() == journaler->get_write_pos());
-    dout(10) << "_replay - complete, " << num_events
-	     << " events" << dendl;
-
-    logger->set(l_mdl_expos, journaler->get_expire_pos());
-  }
+  if (!apply_ready())
+    return false;
 
-  safe_pos = journaler->get_write_safe_pos();
-
-  dout(10) << "_replay_thread kicking waiters" << dendl;
-  {
-    std::lock_guard l(mds->mds_lock);
-    if (mds->is_daemon_stopping()) {
-      return;
-    }
-    pre_segments_size = segments.size();  // get num of logs when replay is finished
-    finish_contexts(g_ceph_context, waitfor_replay, r);  
-  }
-
-  dout(10) << "_replay_thread finish" << dendl;
+  logger->set(l_mdl_rdpos, batch.back().pos);
+  return true;
 }
 
 void MDLog::standby_trim_segments()
@@ -35,6 +35,9 @@ enum {
   l_mdl_rdpos,
   l_mdl_jlat,
   l_mdl_replayed,
+  l_mdl_batch,
+  l_mdl_enclat,
+  l_mdl_replay_declat,
   l_mdl_last,
 };
 
@@ -50,6 +53,8 @@ enum {
 
 #include <list>
 #include <map>
+#include <memory>
+#include <vector>
 
 class Journaler;
 class JournalPointer;
@@ -57,6 +62,7 @@ class LogEvent;
 class MDSRank;
 class LogSegment;
 class ESubtreeMap;
+class ReplayDecodePool;
 
 class MDLog {
 public:
@@ -184,6 +190,13 @@ protected:
   };
 
   // -- replay --
+  struct ReplayEntry {
+    uint64_t pos = 0;   // journal offset of the entry
+    uint64_t end = 0;   // read position after the entry
+    bufferlist bl;
+    std::unique_ptr<LogEvent> le;
+  };
+
   class ReplayThread : public Thread {
   public:
     explicit ReplayThread(MDLog *l) : log(l) {}
@@ -230,6 +243,8 @@ protected:
 
   void _replay();         // old way
   void _replay_thread();  // new way
+  void _replay_decode(ReplayDecodePool& pool, std::vector<ReplayEntry>& batch);
+  bool _replay_apply(std::vector<ReplayEntry>& batch);
 
   void _recovery_thread(MDSContext *completion);
   void _reformat_journal(JournalPointer const &jp, Journaler *old_journal, MDSContext *completion);
@@ -242,6 +257,7 @@ protected:
   }
 
   void _submit_thread();
+  void _submit_pending(const PendingEvent& data, bufferlist& bl);
 
   uint64_t get_last_segment_seq() const {
     ceph_assert(!segments.empty());
@@ -258,6 +274,7 @@ protected:
 
   int num_events = 0; // in events
   int unflushed = 0;
+  size_t last_batch_size = 0;
   bool capped = false;
 
   // Log position which is persistent *and* for which
@@ -340,6 +340,19 @@ void MDSDaemon::set_up_admin_socket()
                                      asok_hook,
                                      "dump metadata loads");
   ceph_assert(r == 0);
+  r = admin_socket->register_command("dump forecast",
+                                     asok_hook,
+                                     "dump balancer load forecasts and migration decisions");
+  ceph_assert(r == 0);
+  r = admin_socket->register_command("perf top-dirs "
+				     "name=count,type=CephInt,range=0,req=false",
+                                     asok_hook,
+                                     "show the directories with the highest request rate");
+  ceph_assert(r == 0);
+  r = admin_socket->register_command("perf latency",
+                                     asok_hook,
+                                     "show client latency percentiles per client and per subtree (rank 0 only)");
+  ceph_assert(r == 0);
   r = admin_socket->register_command("dump snaps name=server,type=CephChoices,strings=--server,req=false",
                                      asok_hook,
                                      "dump snapshots");
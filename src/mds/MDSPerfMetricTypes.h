@@ -6,6 +6,7 @@
 
 #include <ostream>
 
+#include "include/cephfs/metrics/LatencyHistogram.h"
 #include "include/denc.h"
 #include "include/utime.h"
 #include "mdstypes.h"
@@ -202,6 +203,31 @@ struct OpenedInodesMetric {
   }
 };
 
+// latencies reported since the last update to rank 0, per subtree path
+struct LatencyHistogramsMetric {
+  std::map<std::string, LatencyHistograms> subtrees;
+  bool updated = false;
+
+  DENC(LatencyHistogramsMetric, v, p) {
+    DENC_START(1, 1, p);
+    denc(v.subtrees, p);
+    denc(v.updated, p);
+    DENC_FINISH(p);
+  }
+
+  void dump(Formatter *f) const {
+    f->open_object_section("subtrees");
+    for (auto &[path, h] : subtrees)
+      f->dump_object(path, h);
+    f->close_section();
+  }
+
+  friend std::ostream& operator<<(std::ostream& os, const LatencyHistogramsMetric &metric) {
+    os << "{subtrees=" << metric.subtrees.size() << "}";
+    return os;
+  }
+};
+
 WRITE_CLASS_DENC(CapHitMetric)
 WRITE_CLASS_DENC(ReadLatencyMetric)
 WRITE_CLASS_DENC(WriteLatencyMetric)
@@ -210,6 +236,7 @@ WRITE_CLASS_DENC(DentryLeaseHitMetric)
 WRITE_CLASS_DENC(OpenedFilesMetric)
 WRITE_CLASS_DENC(PinnedIcapsMetric)
 WRITE_CLASS_DENC(OpenedInodesMetric)
+WRITE_CLASS_DENC(LatencyHistogramsMetric)
 
 // metrics that are forwarded to the MDS by client(s).
 struct Metrics {
@@ -222,12 +249,13 @@ struct Metrics {
   OpenedFilesMetric opened_files_metric;
   PinnedIcapsMetric pinned_icaps_metric;
   OpenedInodesMetric opened_inodes_metric;
+  LatencyHistogramsMetric latency_histograms_metric;
 
   // metric update type
   uint32_t update_type = UpdateType::UPDATE_TYPE_REFRESH;
 
   DENC(Metrics, v, p) {
-    DENC_START(3, 1, p);
+    DENC_START(4, 1, p);
     denc(v.update_type, p);
     denc(v.cap_hit_metric, p);
     denc(v.read_latency_metric, p);
@@ -241,6 +269,9 @@ struct Metrics {
       denc(v.pinned_icaps_metric, p);
       denc(v.opened_inodes_metric, p);
     }
+    if (struct_v >= 4) {
+      denc(v.latency_histograms_metric, p);
+    }
     DENC_FINISH(p);
   }
 
@@ -254,6 +285,7 @@ struct Metrics {
     f->dump_object("opened_files_metric", opened_files_metric);
     f->dump_object("pinned_icaps_metric", pinned_icaps_metric);
     f->dump_object("opened_inodes_metric", opened_inodes_metric);
+    f->dump_object("latency_histograms_metric", latency_histograms_metric);
   }
 
   friend std::ostream& operator<<(std::ostream& os, const Metrics& metrics) {
@@ -266,6 +298,7 @@ struct Metrics {
        << ", opened_files_metric =" << metrics.opened_files_metric
        << ", pinned_icaps_metric =" << metrics.pinned_icaps_metric
        << ", opened_inodes_metric =" << metrics.opened_inodes_metric
+       << ", latency_histograms_metric =" << metrics.latency_histograms_metric
        << "}]";
     return os;
   }
@@ -1491,6 +1491,9 @@ void MDSRank::send_message_client_counted(const ref_t<Message>& m, const Connect
 
 void MDSRank::send_message_client_counted(const ref_t<Message>& m, Session* session)
 {
+  // keep deferred cap grants/revokes ordered with everything else we send
+  locker->flush_deferred_caps(session);
+
   version_t seq = session->inc_push_seq();
   dout(10) << "send_message_client_counted " << session->info.inst.name << " seq "
 	   << seq << " " << *m << dendl;
@@ -1503,6 +1506,8 @@ void MDSRank::send_message_client_counted(const ref_t<Message>& m, Session* sess
 
 void MDSRank::send_message_client(const ref_t<Message>& m, Session* session)
 {
+  locker->flush_deferred_caps(session);
+
   dout(10) << "send_message_client " << session->info.inst << " " << *m << dendl;
   if (session->get_connection()) {
     session->get_connection()->send_message2(m);
@@ -2768,6 +2773,22 @@ void MDSRankDispatcher::handle_asok_command(
   } else if (command == "dump loads") {
     std::lock_guard l(mds_lock);
     r = balancer->dump_loads(f);
+  } else if (command == "dump forecast") {
+    std::lock_guard l(mds_lock);
+    r = balancer->dump_forecast(f);
+  } else if (command == "perf top-dirs") {
+    int64_t count = 10;
+    cmd_getval(cmdmap, "count", count);
+    std::lock_guard l(mds_lock);
+    r = balancer->dump_top_dirs(f, std::max<int64_t>(count, 0));
+  } else if (command == "perf latency") {
+    std::lock_guard l(mds_lock);
+    if (metric_aggregator) {
+      metric_aggregator->dump_latency(f);
+    } else {
+      r = -CEPHFS_EINVAL;
+      *css << "latency is aggregated on rank 0";
+    }
   } else if (command == "dump snaps") {
     std::lock_guard l(mds_lock);
     string server;
@@ -3314,6 +3335,8 @@ void MDSRank::create_logger()
                            "Grant caps", "cgra", PerfCountersBuilder::PRIO_INTERESTING);
     mds_plb.add_u64_counter(l_mdss_ceph_cap_op_trunc, "ceph_cap_op_trunc",
                            "caps truncate notify", "ctru", PerfCountersBuilder::PRIO_INTERESTING);
+    mds_plb.add_u64_counter(l_mdss_ceph_cap_op_coalesced, "ceph_cap_op_coalesced",
+                           "Cap grants/revokes folded into a later one", "ccoa", PerfCountersBuilder::PRIO_INTERESTING);
     mds_plb.add_u64_counter(l_mdss_ceph_cap_op_flushsnap_ack, "ceph_cap_op_flushsnap_ack",
                            "caps truncate notify", "cfsa", PerfCountersBuilder::PRIO_INTERESTING);
     mds_plb.add_u64_counter(l_mdss_ceph_cap_op_flush_ack, "ceph_cap_op_flush_ack",
@@ -3361,6 +3384,20 @@ void MDSRank::create_logger()
     mds_plb.add_u64(l_mds_dispatch_queue_len, "q", "Dispatch queue length");
     mds_plb.add_u64_counter(l_mds_exported, "exported", "Exports");
     mds_plb.add_u64_counter(l_mds_imported, "imported", "Imports");
+    mds_plb.add_u64_counter(l_mds_export_predicted_inodes, "export_predicted_inodes",
+                            "Inodes predicted to be exported");
+    mds_plb.add_u64_counter(l_mds_export_predicted_bytes, "export_predicted_bytes",
+                            "Bytes predicted to be exported");
+    mds_plb.add_u64_counter(l_mds_export_predicted_caps, "export_predicted_caps",
+                            "Capabilities predicted to be exported");
+    mds_plb.add_u64_counter(l_mds_export_actual_bytes, "export_actual_bytes",
+                            "Bytes exported");
+    mds_plb.add_u64_counter(l_mds_export_clients, "export_clients",
+                            "Client sessions exported with subtrees");
+    mds_plb.add_time_avg(l_mds_export_frozen_latency, "export_frozen_latency",
+                         "Time exported subtrees spent frozen");
+    mds_plb.add_u64(l_mds_exporting_inodes, "exporting_inodes",
+                    "Inodes in exports in flight");
     mds_plb.add_u64_counter(l_mds_openino_backtrace_fetch, "openino_backtrace_fetch",
                             "OpenIno backtrace fetchings");
     mds_plb.add_u64_counter(l_mds_openino_peer_discover, "openino_peer_discover",
@@ -3682,6 +3719,8 @@ const char** MDSRankDispatcher::get_tracked_conf_keys() const
     "mds_inject_migrator_session_race",
     "mds_log_pause",
     "mds_max_export_size",
+    "mds_max_export_inodes",
+    "mds_bal_top_dirs",
     "mds_max_purge_files",
     "mds_forward_all_requests_to_auth",
     "mds_max_purge_ops",
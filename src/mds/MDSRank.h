@@ -80,6 +80,13 @@ enum {
   l_mds_exported_inodes,
   l_mds_imported,
   l_mds_imported_inodes,
+  l_mds_export_predicted_inodes,
+  l_mds_export_predicted_bytes,
+  l_mds_export_predicted_caps,
+  l_mds_export_actual_bytes,
+  l_mds_export_clients,
+  l_mds_export_frozen_latency,
+  l_mds_exporting_inodes,
   l_mds_openino_dir_fetch,
   l_mds_openino_backtrace_fetch,
   l_mds_openino_peer_discover,
@@ -98,6 +105,7 @@ enum {
   l_mdss_ceph_cap_op_revoke,
   l_mdss_ceph_cap_op_grant,
   l_mdss_ceph_cap_op_trunc,
+  l_mdss_ceph_cap_op_coalesced,
   l_mdss_ceph_cap_op_flushsnap_ack,
   l_mdss_ceph_cap_op_flush_ack,
   l_mdss_handle_client_caps,
@@ -36,6 +36,7 @@ int MetricAggregator::init() {
       std::unique_lock locker(lock);
       while (!stopping) {
         ping_all_active_ranks();
+        decay_latency();
         locker.unlock();
         double timo = g_conf().get_val<std::chrono::seconds>("mds_ping_interval").count();
         sleep(timo);
@@ -103,8 +104,20 @@ void MetricAggregator::refresh_metrics_for_rank(const entity_inst_t &client,
              << " client(s)" << dendl;
   }
 
-  auto update_counter_func = [&metrics](const MDSPerformanceCounterDescriptor &d,
-                                        PerformanceCounter *c) {
+  const LatencyHistograms *latency = nullptr;
+  if (metrics.latency_histograms_metric.updated) {
+    auto &h = client_latency[client];
+    for (auto &[path, delta] : metrics.latency_histograms_metric.subtrees) {
+      h.merge(delta);
+      subtree_latency[path].merge(delta);
+    }
+  }
+  if (auto it = client_latency.find(client); it != client_latency.end()) {
+    latency = &it->second;
+  }
+
+  auto update_counter_func = [&metrics, latency](const MDSPerformanceCounterDescriptor &d,
+                                                 PerformanceCounter *c) {
     ceph_assert(d.is_supported());
 
     dout(20) << ": performance_counter_descriptor=" << d << dendl;
@@ -156,6 +169,24 @@ void MetricAggregator::refresh_metrics_for_rank(const entity_inst_t &client,
         c->second = metrics.opened_inodes_metric.total_inodes;
       }
       break;
+    case MDSPerformanceCounterType::READ_LATENCY_TAIL_METRIC:
+      if (latency) {
+        c->first = latency->read.quantile(0.99);
+        c->second = latency->read.quantile(0.999);
+      }
+      break;
+    case MDSPerformanceCounterType::WRITE_LATENCY_TAIL_METRIC:
+      if (latency) {
+        c->first = latency->write.quantile(0.99);
+        c->second = latency->write.quantile(0.999);
+      }
+      break;
+    case MDSPerformanceCounterType::METADATA_LATENCY_TAIL_METRIC:
+      if (latency) {
+        c->first = latency->metadata.quantile(0.99);
+        c->second = latency->metadata.quantile(0.999);
+      }
+      break;
     default:
       ceph_abort_msg("unknown counter type");
     }
@@ -212,6 +243,7 @@ void MetricAggregator::remove_metrics_for_rank(const entity_inst_t &client,
     ceph_assert(rm);
     dout(20) << ": rank=" << rank << " has " << p.size() << " connected"
              << " client(s)" << dendl;
+    put_client_latency(client);
   }
 
   auto sub_key_func = [client, rank](const MDSPerfMetricSubKeyDescriptor &d,
@@ -294,7 +326,64 @@ void MetricAggregator::cull_metrics_for_rank(mds_rank_t rank) {
   }
 
   dout(10) << ": culled " << p.size() << " clients" << dendl;
+  auto culled = std::move(p);
   clients_by_rank.erase(rank);
+  for (auto &client : culled) {
+    put_client_latency(client);
+  }
+}
+
+void MetricAggregator::put_client_latency(const entity_inst_t &client) {
+  // keep the client's latency for as long as any rank still has it
+  for (auto &[rank, clients] : clients_by_rank) {
+    if (clients.count(client)) {
+      return;
+    }
+  }
+  client_latency.erase(client);
+}
+
+void MetricAggregator::decay_latency() {
+  auto halflife = g_conf().get_val<std::chrono::seconds>("mds_metrics_latency_halflife");
+  auto now = ceph_clock_now();
+  if (halflife.count() == 0 || last_latency_decay == utime_t()) {
+    last_latency_decay = now;
+    return;
+  }
+  if (now - last_latency_decay < utime_t(halflife.count(), 0)) {
+    return;
+  }
+  last_latency_decay = now;
+
+  dout(20) << ": " << client_latency.size() << " clients, " << subtree_latency.size()
+           << " subtrees" << dendl;
+  for (auto &[client, h] : client_latency) {
+    h.decay();
+  }
+  // a subtree nobody has touched for a while fades away completely
+  for (auto it = subtree_latency.begin(); it != subtree_latency.end();) {
+    it->second.decay();
+    if (it->second.empty()) {
+      it = subtree_latency.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void MetricAggregator::dump_latency(Formatter *f) {
+  std::scoped_lock locker(lock);
+
+  f->open_object_section("clients");
+  for (auto &[client, h] : client_latency) {
+    f->dump_object(stringify(client.name), h);
+  }
+  f->close_section();
+  f->open_object_section("subtrees");
+  for (auto &[path, h] : subtree_latency) {
+    f->dump_object(path, h);
+  }
+  f->close_section();
 }
 
 void MetricAggregator::notify_mdsmap(const MDSMap &mdsmap) {
@@ -6,12 +6,15 @@
 
 #include <map>
 #include <set>
+#include <string>
 #include <thread>
+#include <unordered_map>
 
 #include "msg/msg_types.h"
 #include "msg/Dispatcher.h"
 #include "common/ceph_mutex.h"
 #include "include/common_fwd.h"
+#include "include/cephfs/metrics/LatencyHistogram.h"
 #include "messages/MMDSMetrics.h"
 
 #include "mgr/MetricTypes.h"
@@ -33,6 +36,9 @@ public:
 
   void notify_mdsmap(const MDSMap &mdsmap);
 
+  // latency percentiles per client and per subtree
+  void dump_latency(Formatter *f);
+
   bool ms_can_fast_dispatch_any() const override {
     return true;
   }
@@ -62,6 +68,12 @@ private:
   // goes away we cull metrics of clients connected to that rank.
   std::map<mds_rank_t, std::unordered_set<entity_inst_t>> clients_by_rank;
 
+  // latency histograms reported by clients, merged over all ranks, per
+  // client and per subtree path over all clients
+  std::unordered_map<entity_inst_t, LatencyHistograms> client_latency;
+  std::map<std::string, LatencyHistograms> subtree_latency;
+  utime_t last_latency_decay;
+
   // user query to metrics map
   std::map<MDSPerfMetricQuery, std::map<MDSPerfMetricKey, PerformanceCounters>> query_metrics_map;
 
@@ -79,6 +91,9 @@ private:
   void remove_metrics_for_rank(const entity_inst_t &client, mds_rank_t rank, bool remove);
 
   void cull_metrics_for_rank(mds_rank_t rank);
+  void put_client_latency(const entity_inst_t &client);
+
+  void decay_latency();
 
   void ping_all_active_ranks();
 
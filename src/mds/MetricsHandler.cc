@@ -127,6 +127,7 @@ void MetricsHandler::remove_session(Session *session) {
   metrics.opened_files_metric = { };
   metrics.pinned_icaps_metric = { };
   metrics.opened_inodes_metric = { };
+  metrics.latency_histograms_metric = { };
   metrics.update_type = UPDATE_TYPE_REMOVE;
 }
 
@@ -275,6 +276,27 @@ void MetricsHandler::handle_payload(Session *session, const OpenedInodesPayload
   metrics.opened_inodes_metric.updated = true;
 }
 
+void MetricsHandler::handle_payload(Session *session, const LatencyHistogramsPayload &payload) {
+  dout(20) << ": type=" << payload.get_type()
+           << ", session=" << session << ", subtrees=" << payload.subtrees.size()
+           << dendl;
+
+  auto it = client_metrics_map.find(session->info.inst);
+  if (it == client_metrics_map.end()) {
+    return;
+  }
+
+  // clients send deltas, and several may arrive between two updates
+  // to rank 0
+  auto &metrics = it->second.second;
+  metrics.update_type = UPDATE_TYPE_REFRESH;
+  auto &subtrees = metrics.latency_histograms_metric.subtrees;
+  for (auto &[path, h] : payload.subtrees) {
+    subtrees[path].merge(h);
+  }
+  metrics.latency_histograms_metric.updated = true;
+}
+
 void MetricsHandler::handle_payload(Session *session, const UnknownPayload &payload) {
   dout(5) << ": type=Unknown, session=" << session << ", ignoring unknown payload" << dendl;
 }
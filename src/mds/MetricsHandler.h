@@ -98,6 +98,7 @@ private:
   void handle_payload(Session *session, const OpenedFilesPayload &payload);
   void handle_payload(Session *session, const PinnedIcapsPayload &payload);
   void handle_payload(Session *session, const OpenedInodesPayload &payload);
+  void handle_payload(Session *session, const LatencyHistogramsPayload &payload);
   void handle_payload(Session *session, const UnknownPayload &payload);
 
   void set_next_seq(version_t seq);
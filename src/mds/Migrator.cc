@@ -268,7 +268,6 @@ void Migrator::export_try_cancel(CDir *dir, bool notify_peer)
   switch (state) {
   case EXPORT_LOCKING:
     dout(10) << "export state=locking : dropping locks and removing auth_pin" << dendl;
-    num_locking_exports--;
     it->second.state = EXPORT_CANCELLED;
     dir->auth_unpin(this);
     break;
@@ -383,13 +382,20 @@ void Migrator::export_try_cancel(CDir *dir, bool notify_peer)
   }
 }
 
+void Migrator::set_export_cost(export_state_t& stat, const export_cost_t& cost)
+{
+  export_throttle.charge(stat.predicted, cost);
+  if (mds->logger)
+    mds->logger->set(l_mds_exporting_inodes, export_throttle.get_inodes());
+}
+
 void Migrator::export_cancel_finish(export_state_iterator& it)
 {
   CDir *dir = it->first;
   bool unpin = (it->second.state == EXPORT_CANCELLING);
   auto parent = std::move(it->second.parent);
 
-  total_exporting_size -= it->second.approx_size;
+  set_export_cost(it->second, export_cost_t());
   export_state.erase(it);
 
   ceph_assert(dir->state_test(CDir::STATE_EXPORTING));
@@ -619,7 +625,8 @@ void Migrator::show_exporting()
   for (const auto& [dir, state] : export_state) {
     dout(10) << " exporting to " << state.peer
 	     << ": (" << state.state << ") " << get_export_statename(state.state)
-	     << " " << dir->dirfrag() << " " << *dir << dendl;
+	     << " " << dir->dirfrag() << " " << state.predicted
+	     << " " << *dir << dendl;
   }
 }
 
@@ -700,12 +707,7 @@ void Migrator::maybe_do_queued_export()
     return;
   running = true;
 
-  uint64_t max_total_size = max_export_size * 2;
-
-  while (!export_queue.empty() &&
-	 max_total_size > total_exporting_size &&
-	 max_total_size - total_exporting_size >=
-	 max_export_size * (num_locking_exports + 1)) {
+  while (!export_queue.empty() && export_throttle.may_start()) {
 
     dirfrag_t df = export_queue.front().first;
     mds_rank_t dest = export_queue.front().second;
@@ -862,11 +864,13 @@ void Migrator::export_dir(CDir *dir, mds_rank_t dest)
 
   ceph_assert(export_state.count(dir) == 0);
   export_state_t& stat = export_state[dir];
-  num_locking_exports++;
   stat.state = EXPORT_LOCKING;
   stat.peer = dest;
   stat.tid = mdr->reqid.tid;
   stat.mut = mdr;
+  // charge the throttle now; locking may take a while, and queued
+  // exports must not start in the meantime as if this one were free
+  set_export_cost(stat, estimate_export_cost(dir));
 
   mdcache->dispatch_request(mdr);
 }
@@ -876,7 +880,7 @@ void Migrator::export_dir(CDir *dir, mds_rank_t dest)
  * choose some subdirs, whose total size is suitable.
  */
 void Migrator::maybe_split_export(CDir* dir, uint64_t max_size, bool null_okay,
-				  vector<pair<CDir*, size_t> >& results)
+				  vector<pair<CDir*, export_cost_t> >& results)
 {
   static const unsigned frag_size = 800;
   static const unsigned inode_size = 1000;
@@ -888,45 +892,57 @@ void Migrator::maybe_split_export(CDir* dir, uint64_t max_size, bool null_okay,
   struct LevelData {
     CDir *dir;
     CDir::dentry_key_map::iterator iter;
-    size_t dirfrag_size = frag_size;
-    size_t subdirs_size = 0;
+    export_cost_t dirfrag_cost;
+    export_cost_t subdirs_cost;
     bool complete = true;
     vector<CDir*> siblings;
-    vector<pair<CDir*, size_t> > subdirs;
+    vector<pair<CDir*, export_cost_t> > subdirs;
     LevelData(const LevelData&) = default;
     LevelData(CDir *d) :
-      dir(d), iter(d->begin()) {}
+      dir(d), iter(d->begin()) {
+      dirfrag_cost.size = frag_size;
+      dirfrag_cost.dirfrags = 1;
+      if (d->is_dirty())
+	dirfrag_cost.dirty++;
+    }
   };
 
   vector<LevelData> stack;
   stack.emplace_back(dir);
 
-  size_t found_size = 0;
-  size_t skipped_size = 0;
+  export_cost_t found;
+  export_cost_t skipped;
 
   for (;;) {
     auto& data = stack.back();
     CDir *cur = data.dir;
     auto& it = data.iter;
-    auto& dirfrag_size = data.dirfrag_size;
+    auto& dirfrag_cost = data.dirfrag_cost;
 
     while(it != cur->end()) {
       CDentry *dn = it->second;
       ++it;
 
-      dirfrag_size += dn->name.size();
+      dirfrag_cost.size += dn->name.size();
+      if (dn->is_dirty())
+	dirfrag_cost.dirty++;
       if (dn->get_linkage()->is_null()) {
-	dirfrag_size += null_size;
+	dirfrag_cost.size += null_size;
 	continue;
       }
       if (dn->get_linkage()->is_remote()) {
-	dirfrag_size += remote_size;
+	dirfrag_cost.size += remote_size;
 	continue;
       }
 
       CInode *in = dn->get_linkage()->get_inode();
-      dirfrag_size += inode_size;
-      dirfrag_size += in->get_client_caps().size() * cap_size;
+      size_t num_caps = in->get_client_caps().size();
+      dirfrag_cost.size += inode_size;
+      dirfrag_cost.size += num_caps * cap_size;
+      dirfrag_cost.inodes++;
+      dirfrag_cost.caps += num_caps;
+      if (in->is_dirty())
+	dirfrag_cost.dirty++;
 
       if (in->is_dir()) {
 	auto ls = in->get_nested_dirfrags();
@@ -964,22 +980,23 @@ void Migrator::maybe_split_export(CDir* dir, uint64_t max_size, bool null_okay,
       continue;
 
     if (data.complete) {
-      auto cur_size = data.subdirs_size + dirfrag_size;
+      auto cur_cost = data.subdirs_cost;
+      cur_cost.add(dirfrag_cost);
       // we can do nothing with large dirfrag
-      if (cur_size >= max_size && found_size * 2 > max_size)
+      if (cur_cost.size >= max_size && found.size * 2 > max_size)
 	break;
 
-      found_size += dirfrag_size;
+      found.add(dirfrag_cost);
 
       if (stack.size() > 1) {
 	auto& parent = stack[stack.size() - 2];
-	parent.subdirs.emplace_back(cur, cur_size);
-	parent.subdirs_size += cur_size;
+	parent.subdirs.emplace_back(cur, cur_cost);
+	parent.subdirs_cost.add(cur_cost);
       }
     } else {
       // can't merge current dirfrag to its parent if there is skipped subdir
       results.insert(results.end(), data.subdirs.begin(), data.subdirs.end());
-      skipped_size += dirfrag_size;
+      skipped.add(dirfrag_cost);
     }
 
     vector<CDir*> ls;
@@ -989,7 +1006,7 @@ void Migrator::maybe_split_export(CDir* dir, uint64_t max_size, bool null_okay,
     if (stack.empty())
       break;
 
-    if (found_size >= max_size)
+    if (found.size >= max_size)
       break;
 
     // next dirfrag
@@ -1003,8 +1020,20 @@ void Migrator::maybe_split_export(CDir* dir, uint64_t max_size, bool null_okay,
   for (auto& p : stack)
     results.insert(results.end(), p.subdirs.begin(), p.subdirs.end());
 
-  if (results.empty() && (!skipped_size || !null_okay))
-    results.emplace_back(dir, found_size + skipped_size);
+  if (results.empty() && (!skipped.size || !null_okay)) {
+    found.add(skipped);
+    results.emplace_back(dir, found);
+  }
+}
+
+Migrator::export_cost_t Migrator::estimate_export_cost(CDir *dir)
+{
+  vector<pair<CDir*, export_cost_t> > results;
+  maybe_split_export(dir, max_export_size, false, results);
+  export_cost_t cost;
+  for (const auto& p : results)
+    cost.add(p.second);
+  return cost;
 }
 
 class C_M_ExportDirWait : public MigratorContext {
@@ -1119,11 +1148,10 @@ void Migrator::dispatch_export_dir(MDRequestRef& mdr, int count)
 
   auto parent = it->second.parent;
 
-  vector<pair<CDir*, size_t> > results;
+  vector<pair<CDir*, export_cost_t> > results;
   maybe_split_export(dir, max_export_size, (bool)parent, results);
 
   if (results.size() == 1 && results.front().first == dir) {
-    num_locking_exports--;
     it->second.state = EXPORT_DISCOVERING;
     // send ExportDirDiscover (ask target)
     filepath path;
@@ -1135,8 +1163,13 @@ void Migrator::dispatch_export_dir(MDRequestRef& mdr, int count)
     ceph_assert(g_conf()->mds_kill_export_at != 2);
 
     it->second.last_cum_auth_pins_change = ceph_clock_now();
-    it->second.approx_size = results.front().second;
-    total_exporting_size += it->second.approx_size;
+    set_export_cost(it->second, results.front().second);
+    dout(7) << "predicted export cost " << it->second.predicted << dendl;
+    if (mds->logger) {
+      mds->logger->inc(l_mds_export_predicted_inodes, it->second.predicted.inodes);
+      mds->logger->inc(l_mds_export_predicted_bytes, it->second.predicted.size);
+      mds->logger->inc(l_mds_export_predicted_caps, it->second.predicted.caps);
+    }
 
     // start the freeze, but hold it up with an auth_pin.
     dir->freeze_tree();
@@ -1174,12 +1207,12 @@ void Migrator::dispatch_export_dir(MDRequestRef& mdr, int count)
 
     ceph_assert(export_state.count(sub) == 0);
     auto& stat = export_state[sub];
-    num_locking_exports++;
     stat.state = EXPORT_LOCKING;
     stat.peer = dest;
     stat.tid = _mdr->reqid.tid;
     stat.mut = _mdr;
     stat.parent = parent;
+    set_export_cost(stat, p.second);
     mdcache->dispatch_request(_mdr);
   }
 
@@ -1342,6 +1375,7 @@ void Migrator::export_frozen(CDir *dir, uint64_t tid)
   ceph_assert(it->second.state == EXPORT_FREEZING);
   ceph_assert(dir->is_frozen_tree_root());
 
+  it->second.frozen_stamp = ceph_clock_now();
   it->second.mut = new MutationImpl();
 
   // ok, try to grab all my locks.
@@ -1597,7 +1631,8 @@ void Migrator::export_go_synced(CDir *dir, uint64_t tid)
        ++p)
     req->add_export((*p)->dirfrag());
 
-  // send
+  // send; the messenger may be encoding req as soon as it has it
+  const uint64_t export_bytes = req->export_data.length();
   mds->send_message_mds(req, dest);
   ceph_assert(g_conf()->mds_kill_export_at != 8);
 
@@ -1606,6 +1641,12 @@ void Migrator::export_go_synced(CDir *dir, uint64_t tid)
   // stats
   if (mds->logger) mds->logger->inc(l_mds_exported);
   if (mds->logger) mds->logger->inc(l_mds_exported_inodes, num_exported_inodes);
+  if (mds->logger) mds->logger->inc(l_mds_export_actual_bytes, export_bytes);
+  if (mds->logger) mds->logger->inc(l_mds_export_clients, exported_client_map.size());
+  dout(7) << "exported " << num_exported_inodes << " inodes, "
+	  << export_bytes << " bytes, "
+	  << exported_client_map.size() << " clients (predicted "
+	  << it->second.predicted << ")" << dendl;
 
   mdcache->show_subtrees();
 }
@@ -2219,8 +2260,12 @@ void Migrator::export_finish(CDir *dir)
 
   MutationRef mut = std::move(it->second.mut);
   auto parent = std::move(it->second.parent);
+  if (mds->logger && it->second.frozen_stamp != utime_t())
+    mds->logger->tinc(l_mds_export_frozen_latency,
+		      ceph_clock_now() - it->second.frozen_stamp);
+
   // remove from exporting list, clean up state
-  total_exporting_size -= it->second.approx_size;
+  set_export_cost(it->second, export_cost_t());
   export_state.erase(it);
 
   ceph_assert(dir->state_test(CDir::STATE_EXPORTING));
@@ -3696,13 +3741,19 @@ void Migrator::logged_import_caps(CInode *in,
 
 Migrator::Migrator(MDSRank *m, MDCache *c) : mds(m), mdcache(c) {
   max_export_size = g_conf().get_val<Option::size_t>("mds_max_export_size");
+  export_throttle.set_max_size(max_export_size);
+  export_throttle.set_max_inodes(g_conf().get_val<uint64_t>("mds_max_export_inodes"));
   inject_session_race = g_conf().get_val<bool>("mds_inject_migrator_session_race");
 }
 
 void Migrator::handle_conf_change(const std::set<std::string>& changed, const MDSMap& mds_map)
 {
-  if (changed.count("mds_max_export_size"))
+  if (changed.count("mds_max_export_size")) {
     max_export_size = g_conf().get_val<Option::size_t>("mds_max_export_size");
+    export_throttle.set_max_size(max_export_size);
+  }
+  if (changed.count("mds_max_export_inodes"))
+    export_throttle.set_max_inodes(g_conf().get_val<uint64_t>("mds_max_export_inodes"));
   if (changed.count("mds_inject_migrator_session_race")) {
     inject_session_race = g_conf().get_val<bool>("mds_inject_migrator_session_race");
     dout(0) << "mds_inject_migrator_session_race is " << inject_session_race << dendl;
@@ -19,6 +19,7 @@
 
 #include "include/types.h"
 
+#include "ExportThrottle.h"
 #include "MDSContext.h"
 
 #include <map>
@@ -189,6 +190,8 @@ public:
   void export_dir(CDir *dir, mds_rank_t dest);
   void export_empty_import(CDir *dir);
 
+  typedef ::export_cost_t export_cost_t;
+
   void export_dir_nicely(CDir *dir, mds_rank_t dest);
   void maybe_do_queued_export();
   void clear_export_queue() {
@@ -197,7 +200,12 @@ public:
   }
   
   void maybe_split_export(CDir* dir, uint64_t max_size, bool null_okay,
-			  std::vector<std::pair<CDir*, size_t> >& results);
+			  std::vector<std::pair<CDir*, export_cost_t> >& results);
+  /**
+   * What exporting dir would move first, as estimated by
+   * maybe_split_export() for the current mds_max_export_size.
+   */
+  export_cost_t estimate_export_cost(CDir *dir);
 
   bool export_try_grab_locks(CDir *dir, MutationRef& mut);
   void get_export_client_set(CDir *dir, std::set<client_t> &client_set);
@@ -273,7 +281,8 @@ protected:
     std::set<mds_rank_t> notify_ack_waiting;
     std::map<inodeno_t,std::map<client_t,Capability::Import> > peer_imported;
     MutationRef mut;
-    size_t approx_size = 0;
+    export_cost_t predicted;
+    utime_t frozen_stamp;
     // for freeze tree deadlock detection
     utime_t last_cum_auth_pins_change;
     int last_cum_auth_pins = 0;
@@ -317,6 +326,7 @@ protected:
   void export_go_synced(CDir *dir, uint64_t tid);
   void export_try_cancel(CDir *dir, bool notify_peer=true);
   void export_cancel_finish(export_state_iterator& it);
+  void set_export_cost(export_state_t& stat, const export_cost_t& cost);
   void export_reverse(CDir *dir, export_state_t& stat);
   void export_notify_abort(CDir *dir, export_state_t& stat, std::set<CDir*>& bounds);
   void handle_export_ack(const cref_t<MExportDirAck> &m);
@@ -360,8 +370,7 @@ protected:
 
   std::map<CDir*, export_state_t>  export_state;
 
-  uint64_t total_exporting_size = 0;
-  unsigned num_locking_exports = 0; // exports in locking state (approx_size == 0)
+  ExportThrottle export_throttle;
 
   std::list<std::pair<dirfrag_t,mds_rank_t> >  export_queue;
   uint64_t export_queue_gen = 1;
@@ -375,4 +384,11 @@ private:
   bool inject_session_race = false;
 };
 
+inline std::ostream& operator<<(std::ostream& out, const Migrator::export_cost_t& c)
+{
+  return out << "export_cost(" << c.size << "B inodes=" << c.inodes
+	     << " dirfrags=" << c.dirfrags << " caps=" << c.caps
+	     << " dirty=" << c.dirty << ")";
+}
+
 #endif
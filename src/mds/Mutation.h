@@ -446,7 +446,7 @@ struct MDRequestImpl : public MutationImpl {
   // indicates how may retries of request have been made
   int retry = 0;
 
-  std::map<int, std::unique_ptr<BatchOp> > *batch_op_map = nullptr;
+  batch_op_map_t *batch_op_map = nullptr;
 
   // indicator for vxattr osdmap update
   bool waited_for_osdmap = false;
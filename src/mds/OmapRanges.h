@@ -0,0 +1,153 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#ifndef CEPH_MDS_OMAPRANGES_H
+#define CEPH_MDS_OMAPRANGES_H
+
+#include <bitset>
+#include <cmath>
+#include <iterator>
+#include <string>
+#include <vector>
+
+/*
+ * Split the rest of an omap, everything after the last key of a first
+ * sorted batch, into ranges that can be read in parallel.
+ *
+ * Nothing is known about the keys that have not been read yet, so the
+ * batch serves as the sample.  Keys are treated as numbers whose digits
+ * are the bytes seen where the sampled keys differ from one another (the
+ * digits of "file0001_head", the UTF-8 bytes of non-ASCII names, ...),
+ * starting a few digits above the batch's common prefix so that the
+ * estimate can carry into it.  The density of the batch along that axis
+ * gives the extent of the `remaining` keys, and the split points divide
+ * it into `ranges` pieces of about the same number of keys.
+ *
+ * Range i is (split[i-1], split[i]], with the batch's last key before the
+ * first split and nothing after the last: a split point is the inclusive
+ * end of one range and the start_after of the next, so a key equal to it
+ * is read exactly once.  Fewer than ranges - 1 points are returned if the
+ * sample does not allow more.
+ */
+template<typename Map>
+std::vector<std::string> omap_split_points(const Map& batch, uint64_t remaining,
+					   unsigned ranges)
+{
+  std::vector<std::string> splits;
+  if (ranges < 2 || batch.size() < 2)
+    return splits;
+  const std::string& first = batch.begin()->first;
+  const std::string& last = batch.rbegin()->first;
+
+  // positions at which the sampled keys differ, then the bytes seen there
+  std::vector<bool> varies(first.size());
+  for (auto& p : batch) {
+    const std::string& k = p.first;
+    if (k.size() > varies.size())
+      varies.resize(k.size());
+    for (size_t i = 0; i < k.size(); i++)
+      if (i >= first.size() || k[i] != first[i])
+	varies[i] = true;
+    for (size_t i = k.size(); i < first.size(); i++)
+      varies[i] = true;
+  }
+  std::bitset<256> seen;
+  for (auto& p : batch) {
+    const std::string& k = p.first;
+    for (size_t i = 0; i < k.size(); i++)
+      if (varies[i])
+	seen.set((unsigned char)k[i]);
+  }
+
+  // digit 0 is the end of the key, which sorts before any byte; a byte
+  // that was not seen takes the digit of the nearest seen byte below it
+  std::vector<unsigned char> syms;
+  unsigned digit[256];
+  for (unsigned b = 0; b < 256; b++) {
+    if (seen.test(b))
+      syms.push_back(b);
+    digit[b] = syms.size();
+  }
+  const double base = syms.size() + 1;
+
+  size_t prefix = 0;
+  while (prefix < first.size() && prefix < last.size() &&
+	 first[prefix] == last[prefix])
+    prefix++;
+
+  // start far enough above the common prefix for the remaining keys to
+  // fit, but never at a prefix byte that is not a digit: it could not
+  // carry into the next symbol
+  const double grow = (double)remaining / batch.size() + 1.0;
+  size_t start = prefix - std::min<size_t>(
+    prefix, (size_t)std::ceil(std::log(grow) / std::log(base)) + 1);
+  for (size_t i = prefix; i > start; i--) {
+    if (!seen.test((unsigned char)last[i - 1])) {
+      start = i;
+      break;
+    }
+  }
+  const size_t width = std::max<int>(1, (int)(52 / std::log2(base)));
+  const double top = std::pow(base, width);
+
+  auto value = [&](const std::string& k) {
+    double v = 0;
+    for (size_t i = start; i < start + width; i++)
+      v = v * base + (i < k.size() ? digit[(unsigned char)k[i]] : 0);
+    return v;
+  };
+  // the density near the end of the batch says most about what follows
+  auto mid = batch.begin();
+  std::advance(mid, batch.size() / 2);
+  const double lo = value(last);
+  const double span = (lo - value(mid->first)) * remaining /
+		      (batch.size() - batch.size() / 2);
+  if (span <= 0)
+    return splits;
+
+  for (unsigned r = 1; r < ranges; r++) {
+    double v = std::floor(lo + span * r / ranges);
+    if (v >= top)
+      break;
+    std::string s = last.substr(0, start);
+    for (double scale = top / base; scale >= 1; scale /= base) {
+      unsigned d = (unsigned)std::fmod(std::floor(v / scale), base);
+      if (d == 0)
+	break;
+      s.push_back(syms[d - 1]);
+    }
+    if (s > last && (splits.empty() || s > splits.back()))
+      splits.push_back(std::move(s));
+  }
+  return splits;
+}
+
+/*
+ * Clip the result of a read of the range ending (inclusively) at `end`
+ * (empty for the last range) to the keys that belong to it.  Returns the
+ * end of those keys; *done is set if the range needs no further read.
+ */
+template<typename Map>
+typename Map::iterator omap_range_clip(Map& batch, bool more,
+				       const std::string& end, bool *done)
+{
+  if (end.empty()) {
+    *done = !more || batch.empty();
+    return batch.end();
+  }
+  auto stop = batch.upper_bound(end);
+  *done = !more || stop != batch.end() || batch.empty() ||
+	  std::prev(stop)->first == end;
+  return stop;
+}
+
+#endif
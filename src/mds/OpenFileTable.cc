@@ -29,6 +29,8 @@ enum {
   l_oft_omap_total_kv_pairs,
   l_oft_omap_total_updates,
   l_oft_omap_total_removes,
+  l_oft_commits,
+  l_oft_journaled_commits,
   l_oft_last
 };
 
@@ -50,6 +52,9 @@ OpenFileTable::OpenFileTable(MDSRank *m) : mds(m) {
   b.add_u64(l_oft_omap_total_kv_pairs, "omap_total_kv_pairs");
   b.add_u64(l_oft_omap_total_updates, "omap_total_updates");
   b.add_u64(l_oft_omap_total_removes, "omap_total_removes");
+  b.add_u64_counter(l_oft_commits, "commits", "Open file table commits");
+  b.add_u64_counter(l_oft_journaled_commits, "journaled_commits",
+		    "Open file table commits that went through the journal");
   logger.reset(b.create_perf_counters());
   mds->cct->get_perfcounters_collection()->add(logger.get());
   logger->set(l_oft_omap_total_objs, 0);
@@ -582,16 +587,22 @@ void OpenFileTable::commit(MDSContext *c, uint64_t log_seq, int op_prio)
       omap_num_objs = used_objs;
       omap_num_items.resize(omap_num_objs);
     }
-    // skip journal if only one osd request is required and object count
-    // does not change.
-    if (!journaled && old_num_objs == omap_num_objs &&
-	objs_to_write.size() <= 1) {
+    // skip journal if every object takes a single osd request and object
+    // count does not change.  An item never moves between objects, so each
+    // object is updated atomically on its own; if we crash half way, the
+    // log segments this commit covers have not been trimmed yet and replay
+    // adds back what is missing.
+    if (!journaled && old_num_objs == omap_num_objs) {
       ceph_assert(journal_state == JOURNAL_NONE);
       ceph_assert(!gather.has_subs());
 
-      unsigned omap_idx = objs_to_write.empty() ? 0 : objs_to_write.front();
-      create_op_func(omap_idx, true);
+      if (objs_to_write.empty())
+	objs_to_write.push_back(0);
+      for (auto omap_idx : objs_to_write)
+	create_op_func(omap_idx, true);
       submit_ops_func();
+      logger->inc(l_oft_commits);
+      logger->set(l_oft_omap_total_kv_pairs, total_items);
       return;
     }
   }
@@ -661,6 +672,7 @@ void OpenFileTable::commit(MDSContext *c, uint64_t log_seq, int op_prio)
 
   ceph_assert(!ops_map.empty());
   if (journal_state == JOURNAL_FINISH) {
+    logger->inc(l_oft_journaled_commits);
     gather.set_finisher(new C_OnFinisher(new C_IO_OFT_Journal(this, log_seq, c, ops_map),
 					 mds->finisher));
     gather.activate();
@@ -671,6 +683,7 @@ void OpenFileTable::commit(MDSContext *c, uint64_t log_seq, int op_prio)
   logger->set(l_oft_omap_total_kv_pairs, total_items);
   logger->inc(l_oft_omap_total_updates, total_updates);
   logger->inc(l_oft_omap_total_removes, total_removes);
+  logger->inc(l_oft_commits);
 }
 
 class C_IO_OFT_Load : public MDSIOContextBase {
@@ -733,6 +746,7 @@ void OpenFileTable::_read_omap_values(const std::string& key, unsigned idx,
     dout(10) << __func__ << ": load from '" << oid << ":" << key << "'" << dendl;
     object_locator_t oloc(mds->get_metadata_pool());
     C_IO_OFT_Load *c = new C_IO_OFT_Load(this, idx, first);
+    num_loading++;
     ObjectOperation op;
     if (first)
       op.omap_get_header(&c->header_bl, &c->header_r);
@@ -750,7 +764,10 @@ void OpenFileTable::_load_finish(int op_r, int header_r, int values_r,
   using ceph::decode;
   int err = -CEPHFS_EINVAL;
 
-  auto decode_func = [this](unsigned idx, inodeno_t ino, bufferlist &bl) {
+  // item counts are worked out once all objects are read, as reads
+  // complete out of order and a later header may change the object count
+  auto decode_func = [this](unsigned idx, inodeno_t ino, bufferlist &bl,
+			    bool count_items) {
     auto p = bl.cbegin();
 
     size_t count = loaded_anchor_map.size();
@@ -767,102 +784,128 @@ void OpenFileTable::_load_finish(int op_r, int header_r, int values_r,
     anchor.auth = MDS_RANK_NONE;
 
 
-    if (loaded_anchor_map.size() > count)
+    if (count_items && loaded_anchor_map.size() > count)
       ++omap_num_items[idx];
   };
 
-  if (op_r < 0) {
+  ceph_assert(num_loading > 0);
+  num_loading--;
+
+  if (load_err < 0) {
+    // an earlier read failed; just wait for the others
+  } else if (op_r < 0) {
     derr << __func__ << " got " << cpp_strerror(op_r) << dendl;
-    err = op_r;
-    goto out;
-  }
+    load_err = op_r;
+  } else {
+    try {
+      if (first) {
+	auto p = header_bl.cbegin();
 
-  try {
-    if (first) {
-      auto p = header_bl.cbegin();
+	string magic;
+	version_t version;
+	unsigned num_objs;
+	__u8 jstate;
 
-      string magic;
-      version_t version;
-      unsigned num_objs;
-      __u8 jstate;
+	if (header_bl.length() == 13) {
+	  // obsolete format.
+	  decode(version, p);
+	  decode(num_objs, p);
+	  decode(jstate, p);
+	} else {
+	  decode(magic, p);
+	  if (magic != CEPH_FS_ONDISK_MAGIC) {
+	    CachedStackStringStream css;
+	    *css << "invalid magic '" << magic << "'";
+	    throw buffer::malformed_input(css->str());
+	  }
 
-      if (header_bl.length() == 13) {
-	// obsolete format.
-	decode(version, p);
-	decode(num_objs, p);
-	decode(jstate, p);
-      } else {
-	decode(magic, p);
-	if (magic != CEPH_FS_ONDISK_MAGIC) {
-	  CachedStackStringStream css;
-	  *css << "invalid magic '" << magic << "'";
-	  throw buffer::malformed_input(css->str());
+	  DECODE_START(1, p);
+	  decode(version, p);
+	  decode(num_objs, p);
+	  decode(jstate, p);
+	  DECODE_FINISH(p);
 	}
 
-	DECODE_START(1, p);
-	decode(version, p);
-	decode(num_objs, p);
-	decode(jstate, p);
-	DECODE_FINISH(p);
-      }
-
-      if (num_objs > MAX_OBJECTS) {
-	  CachedStackStringStream css;
-	  *css << "invalid object count '" << num_objs << "'";
-	  throw buffer::malformed_input(css->str());
-      }
-      if (jstate > JOURNAL_FINISH) {
-	  CachedStackStringStream css;
-	  *css << "invalid journal state '" << jstate << "'";
-	  throw buffer::malformed_input(css->str());
-      }
+	if (num_objs > MAX_OBJECTS) {
+	    CachedStackStringStream css;
+	    *css << "invalid object count '" << num_objs << "'";
+	    throw buffer::malformed_input(css->str());
+	}
+	if (jstate > JOURNAL_FINISH) {
+	    CachedStackStringStream css;
+	    *css << "invalid journal state '" << jstate << "'";
+	    throw buffer::malformed_input(css->str());
+	}
 
-      if (version > omap_version) {
-	omap_version = version;
-	omap_num_objs = num_objs;
-	omap_num_items.resize(omap_num_objs);
-	journal_state = jstate;
-      } else if (version == omap_version) {
-	ceph_assert(omap_num_objs == num_objs);
-	if (jstate > journal_state)
+	if (version > omap_version) {
+	  omap_version = version;
+	  omap_num_objs = num_objs;
 	  journal_state = jstate;
+	} else if (version == omap_version) {
+	  ceph_assert(omap_num_objs == num_objs);
+	  if (jstate > journal_state)
+	    journal_state = jstate;
+	}
       }
-    }
 
-    for (auto& it : values) {
-      if (it.first.compare(0, 9, "_journal.") == 0) {
-	if (idx >= loaded_journals.size())
-	  loaded_journals.resize(idx + 1);
+      for (auto& it : values) {
+	if (it.first.compare(0, 9, "_journal.") == 0) {
+	  if (idx >= loaded_journals.size())
+	    loaded_journals.resize(idx + 1);
 
-	if (journal_state == JOURNAL_FINISH) {
+	  // keep it even if the journal looks incomplete so far; the header
+	  // that says otherwise may be in an object still being read
 	  loaded_journals[idx][it.first].swap(it.second);
-	} else { // incomplete journal
-	  loaded_journals[idx][it.first].length();
+	  continue;
 	}
-	continue;
-      }
 
-      inodeno_t ino;
-      sscanf(it.first.c_str(), "%llx", (unsigned long long*)&ino.val);
-      decode_func(idx, ino, it.second);
+	inodeno_t ino;
+	sscanf(it.first.c_str(), "%llx", (unsigned long long*)&ino.val);
+	decode_func(idx, ino, it.second, false);
+      }
+    } catch (buffer::error &e) {
+      derr << __func__ << ": corrupted header/values: " << e.what() << dendl;
+      load_err = -CEPHFS_EINVAL;
     }
-  } catch (buffer::error &e) {
-    derr << __func__ << ": corrupted header/values: " << e.what() << dendl;
-    goto out;
   }
 
-  if (more || idx + 1 < omap_num_objs) {
-    // Issue another read if we're not at the end of the omap
-    std::string last_key;
-    if (more)
-      last_key = values.rbegin()->first;
-    else
-      idx++;
+  if (load_err == 0) {
+    // Issue another read if we're not at the end of the omap, and keep
+    // up to mds_oft_load_max_inflight objects loading at once
+    if (more) {
+      _read_omap_values(values.rbegin()->first, idx, false);
+    }
+    unsigned max_inflight = std::max<uint64_t>(1,
+      g_conf().get_val<uint64_t>("mds_oft_load_max_inflight"));
+    while (next_load_idx < omap_num_objs && num_loading < max_inflight)
+      _read_omap_values("", next_load_idx++, true);
+  }
 
-    _read_omap_values(last_key, idx, !more);
+  if (num_loading > 0)
     return;
+
+  if (load_err < 0) {
+    err = load_err;
+    goto out;
   }
 
+  // drop what was read from objects past the final object count and
+  // count the items per object
+  omap_num_items.assign(omap_num_objs, 0);
+  for (auto it = loaded_anchor_map.begin(); it != loaded_anchor_map.end(); ) {
+    if ((unsigned)it->second.omap_idx >= omap_num_objs) {
+      loaded_anchor_map.erase(it++);
+    } else {
+      ++omap_num_items[it->second.omap_idx];
+      ++it;
+    }
+  }
+  if (loaded_journals.size() > omap_num_objs)
+    loaded_journals.resize(omap_num_objs);
+
+  dout(10) << __func__ << ": loaded " << loaded_anchor_map.size()
+	   << " items from " << omap_num_objs << " objects" << dendl;
+
   // replay journal
   if (loaded_journals.size() > 0) {
     dout(10) << __func__ << ": recover journal" << dendl;
@@ -895,7 +938,7 @@ void OpenFileTable::_load_finish(int op_r, int header_r, int values_r,
 	  for (auto& q : to_update) {
 	    inodeno_t ino;
 	    sscanf(q.first.c_str(), "%llx", (unsigned long long*)&ino.val);
-	    decode_func(omap_idx, ino, q.second);
+	    decode_func(omap_idx, ino, q.second, true);
 	  }
 	  for (auto& q : to_remove) {
 	    inodeno_t ino;
@@ -970,6 +1013,9 @@ void OpenFileTable::load(MDSContext *onload)
   if (onload)
     waiting_for_load.push_back(onload);
 
+  // the first object's header gives the object count; the others are
+  // read in parallel once it is known
+  next_load_idx = 1;
   _read_omap_values("", 0, true);
 }
 
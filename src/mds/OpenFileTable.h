@@ -131,6 +131,10 @@ protected:
   };
   int journal_state = 0;
 
+  unsigned num_loading = 0;	// omap reads in flight
+  unsigned next_load_idx = 0;	// next object to read
+  int load_err = 0;
+
   std::vector<std::map<std::string, bufferlist> > loaded_journals;
   std::map<inodeno_t, RecoveredAnchor> loaded_anchor_map;
   MDSContext::vec waiting_for_load;
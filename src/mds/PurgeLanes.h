@@ -0,0 +1,163 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#ifndef CEPH_MDS_PURGELANES_H
+#define CEPH_MDS_PURGELANES_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+
+#include "common/ceph_time.h"
+
+/*
+ * Op throttling for the PurgeQueue, with a lane per pool.
+ *
+ * Each pool the queue deletes from gets its own share of the op limit, so
+ * that one slow or small pool cannot hold up purging in the others.  An
+ * item whose pool is at its share waits in that pool's lane, in journal
+ * order, while items for other pools keep being read and started.  Only
+ * the total number of waiting items is capped (may_defer()).
+ *
+ * The op limit itself is scaled down while the average latency of purge
+ * items is above a target, and back up once it is below.
+ */
+class PurgeLanes {
+public:
+  void set_op_limit(uint64_t ops) {
+    max_ops = ops;
+  }
+  /// the op limit after latency feedback, which draining ignores
+  uint64_t get_op_limit(bool draining) const {
+    if (draining || scale >= 1.0)
+      return max_ops;
+    return std::max<uint64_t>(1, max_ops * scale);
+  }
+
+  void clear_pool_limits() {
+    for (auto& [pool, lane] : lanes)
+      lane.max_ops = 0;
+  }
+  /// a pool's share of the op limit; zero leaves only the global limit
+  void set_pool_limit(int64_t pool, uint64_t ops) {
+    lanes[pool].max_ops = ops;
+  }
+
+  /// may an item of pool that needs ops start now, or must it wait?
+  bool may_start(int64_t pool, uint64_t ops, bool draining) const {
+    auto p = lanes.find(pool);
+    return p == lanes.end() ||
+	   (p->second.waiting.empty() && has_room(p->second, ops, draining));
+  }
+  void defer(int64_t pool, uint64_t key) {
+    lanes[pool].waiting.push_back(key);
+    deferred++;
+  }
+  size_t get_deferred() const {
+    return deferred;
+  }
+  /// waiting items are capped at max_files for each pool with a lane
+  bool may_defer(uint64_t max_files) const {
+    return deferred < max_files * std::max<size_t>(1, lanes.size());
+  }
+
+  void started(int64_t pool, uint64_t ops) {
+    lanes[pool].ops_in_flight += ops;
+    ops_in_flight += ops;
+  }
+  void finished(int64_t pool, uint64_t ops) {
+    lanes[pool].ops_in_flight -= ops;
+    ops_in_flight -= ops;
+  }
+  uint64_t get_ops_in_flight(int64_t pool) const {
+    auto p = lanes.find(pool);
+    return p == lanes.end() ? 0 : p->second.ops_in_flight;
+  }
+
+  /**
+   * Start the waiting items that fit now, in journal order within each
+   * pool.  ops(key) gives the ops a waiting item needs and start(pool,
+   * key) starts it, calling started().
+   */
+  template<typename OpsFn, typename StartFn>
+  void start_deferred(bool draining, OpsFn&& ops, StartFn&& start) {
+    for (auto& [pool, lane] : lanes) {
+      while (!lane.waiting.empty()) {
+	uint64_t key = lane.waiting.front();
+	uint64_t n = ops(key);
+	if (!has_room(lane, n, draining) ||
+	    (ops_in_flight > 0 && ops_in_flight + n > get_op_limit(draining)))
+	  break;
+	lane.waiting.pop_front();
+	deferred--;
+	start(pool, key);
+      }
+    }
+  }
+
+  /**
+   * Feed back the latency of a completed item.  The limit moves at most
+   * once a second, so a burst of completions from one slow period only
+   * counts once.  Returns true if the op limit scale changed.
+   */
+  bool update_latency(double lat, double target, ceph::coarse_mono_time now) {
+    if (target <= 0) {
+      bool changed = (scale != 1.0);
+      scale = 1.0;
+      return changed;
+    }
+    avg_latency = avg_latency > 0 ? 0.9 * avg_latency + 0.1 * lat : lat;
+    if (now - last_scale_change < std::chrono::seconds(1))
+      return false;
+    last_scale_change = now;
+
+    double s = avg_latency > target ? std::max(1.0 / 8, scale * 0.75)
+				    : std::min(1.0, scale + 0.05);
+    if (s == scale)
+      return false;
+    scale = s;
+    return true;
+  }
+  double get_scale() const {
+    return scale;
+  }
+  double get_avg_latency() const {
+    return avg_latency;
+  }
+
+private:
+  struct lane_t {
+    uint64_t ops_in_flight = 0;
+    uint64_t max_ops = 0;
+    std::deque<uint64_t> waiting;
+  };
+
+  bool has_room(const lane_t& lane, uint64_t ops, bool draining) const {
+    // one item per pool may always run, so a pool is never starved by a
+    // share smaller than its largest item
+    return draining || lane.max_ops == 0 || lane.ops_in_flight == 0 ||
+	   lane.ops_in_flight + ops <= lane.max_ops;
+  }
+
+  std::map<int64_t, lane_t> lanes;
+  size_t deferred = 0;
+  uint64_t ops_in_flight = 0;
+  uint64_t max_ops = 0;
+
+  double scale = 1.0;
+  double avg_latency = 0.0;
+  ceph::coarse_mono_time last_scale_change;
+};
+
+#endif
@@ -147,6 +147,13 @@ void PurgeQueue::create_logger()
   pcb.add_u64(l_pq_executing, "pq_executing", "Purge queue tasks in flight");
   pcb.add_u64(l_pq_executing_high_water, "pq_executing_high_water", "Maximum number of executing file purges");
   pcb.add_u64(l_pq_item_in_journal, "pq_item_in_journal", "Purge item left in journal");
+  pcb.add_u64_counter(l_pq_executed_ops, "pq_executed_ops", "Purge queue RADOS ops completed");
+  pcb.add_time_avg(l_pq_item_lat, "pq_item_lat", "Latency of executing a purge item");
+  pcb.add_u64(l_pq_deferred, "pq_deferred", "Purge items waiting for their pool's op limit");
+  pcb.add_u64(l_pq_op_limit, "pq_op_limit", "Current purge op limit after latency feedback");
+  pcb.add_u64(l_pq_purge_rate, "pq_purge_rate", "Purge items completed per second");
+  pcb.add_u64(l_pq_backlog_eta, "pq_backlog_eta",
+              "Estimated seconds to drain the purge queue at the current rate");
 
   logger.reset(pcb.create_perf_counters());
   g_ceph_context->get_perfcounters_collection()->add(logger.get());
@@ -394,11 +401,22 @@ bool PurgeQueue::_can_consume()
     return false;
   }
 
+  // Deferred items are only waiting for their pool's share of ops, so
+  // they do not count against mds_max_purge_files.  They are capped in
+  // total rather than per pool: one pool being at its share must not
+  // stop items for the others from being read.
+  const size_t deferred = lanes.get_deferred();
+  const size_t executing = in_flight.size() - deferred;
   dout(20) << ops_in_flight << "/" << max_purge_ops << " ops, "
-           << in_flight.size() << "/" << g_conf()->mds_max_purge_files
-           << " files" << dendl;
+           << executing << "/" << g_conf()->mds_max_purge_files
+           << " files, " << deferred << " deferred" << dendl;
 
-  if (in_flight.size() == 0 && cct->_conf->mds_max_purge_files > 0) {
+  if (!lanes.may_defer(cct->_conf->mds_max_purge_files)) {
+    dout(20) << "Throttling on deferred items " << deferred << dendl;
+    return false;
+  }
+
+  if (executing == 0 && cct->_conf->mds_max_purge_files > 0) {
     // Always permit consumption if nothing is in flight, so that the ops
     // limit can never be so low as to forbid all progress (unless
     // administrator has deliberately paused purging by setting max
@@ -406,14 +424,14 @@ bool PurgeQueue::_can_consume()
     return true;
   }
 
-  if (ops_in_flight >= max_purge_ops) {
+  if (ops_in_flight >= lanes.get_op_limit(draining)) {
     dout(20) << "Throttling on op limit " << ops_in_flight << "/"
-             << max_purge_ops << dendl;
+             << lanes.get_op_limit(draining) << dendl;
     return false;
   }
 
-  if (in_flight.size() >= cct->_conf->mds_max_purge_files) {
-    dout(20) << "Throttling on item limit " << in_flight.size()
+  if (executing >= cct->_conf->mds_max_purge_files) {
+    dout(20) << "Throttling on item limit " << executing
              << "/" << cct->_conf->mds_max_purge_files << dendl;
     return false;
   } else {
@@ -487,8 +505,19 @@ bool PurgeQueue::_consume()
            << journaler.get_read_pos() << dendl;
       _go_readonly(CEPHFS_EIO);
     }
+    uint64_t expire_to = journaler.get_read_pos();
+    const int64_t pool = _get_pool(item);
+    if (!lanes.may_start(pool, _calculate_ops(item), draining)) {
+      dout(20) << " deferring item (" << item.ino << "), pool " << pool
+               << " at " << lanes.get_ops_in_flight(pool) << " ops" << dendl;
+      in_flight[expire_to] = item;
+      lanes.defer(pool, expire_to);
+      logger->set(l_pq_executing, in_flight.size());
+      logger->set(l_pq_deferred, lanes.get_deferred());
+      continue;
+    }
     dout(20) << " executing item (" << item.ino << ")" << dendl;
-    _execute_item(item, journaler.get_read_pos());
+    _execute_item(item, expire_to);
   }
 
   dout(10) << " cannot consume right now" << dendl;
@@ -602,6 +631,8 @@ void PurgeQueue::_execute_item(
   logger->set(l_pq_executing_high_water, files_high_water);
   auto ops = _calculate_ops(item);
   ops_in_flight += ops;
+  lanes.started(_get_pool(item), ops);
+  exec_start[expire_to] = ceph::coarse_mono_clock::now();
   logger->set(l_pq_executing_ops, ops_in_flight);
   ops_high_water = std::max(ops_high_water, ops_in_flight);
   logger->set(l_pq_executing_ops_high_water, ops_high_water);
@@ -660,6 +691,8 @@ void PurgeQueue::_execute_item(
     derr << "Invalid item (action=" << item.action << ") in purge queue, "
             "dropping it" << dendl;
     ops_in_flight -= ops;
+    lanes.finished(_get_pool(item), ops);
+    exec_start.erase(expire_to);
     logger->set(l_pq_executing_ops, ops_in_flight);
     ops_high_water = std::max(ops_high_water, ops_in_flight);
     logger->set(l_pq_executing_ops_high_water, ops_high_water);
@@ -710,7 +743,16 @@ void PurgeQueue::_execute_item_complete(
     pending_expire.insert(expire_to);
   }
 
-  ops_in_flight -= _calculate_ops(iter->second);
+  auto ops = _calculate_ops(iter->second);
+  ops_in_flight -= ops;
+  lanes.finished(_get_pool(iter->second), ops);
+  logger->inc(l_pq_executed_ops, ops);
+  if (auto s = exec_start.find(expire_to); s != exec_start.end()) {
+    auto lat = ceph::coarse_mono_clock::now() - s->second;
+    logger->tinc(l_pq_item_lat, lat);
+    _update_latency(std::chrono::duration<double>(lat).count());
+    exec_start.erase(s);
+  }
   logger->set(l_pq_executing_ops, ops_in_flight);
   ops_high_water = std::max(ops_high_water, ops_in_flight);
   logger->set(l_pq_executing_ops_high_water, ops_high_water);
@@ -736,6 +778,68 @@ void PurgeQueue::_execute_item_complete(
 
   logger->set(l_pq_item_in_journal, item_num);
   logger->inc(l_pq_executed);
+  _update_rate(item_num + lanes.get_deferred());
+
+  _start_deferred();
+}
+
+int64_t PurgeQueue::_get_pool(const PurgeItem &item) const
+{
+  return item.action == PurgeItem::PURGE_DIR ? metadata_pool
+                                             : item.layout.pool_id;
+}
+
+void PurgeQueue::_start_deferred()
+{
+  ceph_assert(ceph_mutex_is_locked_by_me(lock));
+
+  // purging paused by the administrator
+  if (readonly || cct->_conf->mds_max_purge_files == 0)
+    return;
+
+  lanes.start_deferred(
+    draining,
+    [this](uint64_t expire_to) {
+      return _calculate_ops(in_flight.at(expire_to));
+    },
+    [this](int64_t pool, uint64_t expire_to) {
+      PurgeItem item = in_flight.at(expire_to);
+      logger->set(l_pq_deferred, lanes.get_deferred());
+      dout(20) << " executing deferred item (" << item.ino << ") in pool "
+               << pool << dendl;
+      _execute_item(item, expire_to);
+    });
+}
+
+void PurgeQueue::_update_latency(double lat)
+{
+  const double target = cct->_conf.get_val<double>("mds_purge_target_latency");
+  const double scale = lanes.get_scale();
+  if (lanes.update_latency(lat, target, ceph::coarse_mono_clock::now())) {
+    dout(10) << "average purge latency " << lanes.get_avg_latency()
+             << "s (target " << target << "s), op limit scale " << scale
+             << " -> " << lanes.get_scale() << dendl;
+  }
+  logger->set(l_pq_op_limit, lanes.get_op_limit(draining));
+}
+
+void PurgeQueue::_update_rate(uint64_t items_left)
+{
+  auto now = ceph::coarse_mono_clock::now();
+  if (rate_stamp == ceph::coarse_mono_time()) {
+    rate_stamp = now;
+    return;
+  }
+  ++rate_items;
+  double elapsed = std::chrono::duration<double>(now - rate_stamp).count();
+  if (elapsed < 1.0)
+    return;
+  double rate = rate_items / elapsed;
+  purge_rate = purge_rate > 0 ? 0.7 * purge_rate + 0.3 * rate : rate;
+  rate_items = 0;
+  rate_stamp = now;
+  logger->set(l_pq_purge_rate, purge_rate);
+  logger->set(l_pq_backlog_eta, purge_rate > 0 ? items_left / purge_rate : 0);
 }
 
 void PurgeQueue::update_op_limit(const MDSMap &mds_map)
@@ -747,6 +851,15 @@ void PurgeQueue::update_op_limit(const MDSMap &mds_map)
     return;
   }
 
+  // Work out a limit based on n_pgs / n_mdss, multiplied by the user's
+  // preference for how many ops per PG
+  auto pg_ops = [&](uint64_t pgs) {
+    return uint64_t(((double)pgs / (double)mds_map.get_max_mds()) *
+		    cct->_conf->mds_max_purge_ops_per_pg);
+  };
+
+  lanes.clear_pool_limits();
+
   uint64_t pg_count = 0;
   objecter->with_osdmap([&](const OSDMap& o) {
     // Number of PGs across all data pools
@@ -760,18 +873,27 @@ void PurgeQueue::update_op_limit(const MDSMap &mds_map)
         continue;
       }
       pg_count += o.get_pg_num(dp);
+      lanes.set_pool_limit(dp, std::max<uint64_t>(1, pg_ops(o.get_pg_num(dp))));
+    }
+    if (o.get_pg_pool(metadata_pool)) {
+      lanes.set_pool_limit(metadata_pool,
+	std::max<uint64_t>(1, pg_ops(o.get_pg_num(metadata_pool))));
     }
   });
 
-  // Work out a limit based on n_pgs / n_mdss, multiplied by the user's
-  // preference for how many ops per PG
-  max_purge_ops = uint64_t(((double)pg_count / (double)mds_map.get_max_mds()) *
-			   cct->_conf->mds_max_purge_ops_per_pg);
+  max_purge_ops = pg_ops(pg_count);
 
   // User may also specify a hard limit, apply this if so.
   if (cct->_conf->mds_max_purge_ops) {
     max_purge_ops = std::min(max_purge_ops, cct->_conf->mds_max_purge_ops);
   }
+  lanes.set_op_limit(max_purge_ops);
+  // called from the MDSRank constructor, before create_logger()
+  if (logger)
+    logger->set(l_pq_op_limit, lanes.get_op_limit(draining));
+
+  // a larger share may let deferred items go
+  _start_deferred();
 }
 
 void PurgeQueue::handle_conf_change(const std::set<std::string>& changed, const MDSMap& mds_map)
@@ -781,13 +903,14 @@ void PurgeQueue::handle_conf_change(const std::set<std::string>& changed, const
     update_op_limit(mds_map);
   } else if (changed.count("mds_max_purge_files")) {
     std::lock_guard l(lock);
-    if (in_flight.empty()) {
+    if (in_flight.size() == lanes.get_deferred()) {
       // We might have gone from zero to a finite limit, so
       // might need to kick off consume.
       dout(4) << "maybe start work again (max_purge_files="
               << g_conf()->mds_max_purge_files << dendl;
       finisher.queue(new LambdaContext([this](int r){
         std::lock_guard l(lock);
+        _start_deferred();
         _consume();
       }));
     }
@@ -828,6 +951,7 @@ bool PurgeQueue::drain(
     // Life the op throttle as this daemon now has nothing to do but
     // drain the purge queue, so do it as fast as we can.
     max_purge_ops = 0xffff;
+    lanes.set_op_limit(max_purge_ops);
   }
 
   drain_initial = std::max(bytes_remaining, drain_initial);
@@ -18,6 +18,7 @@
 #include "include/compact_set.h"
 #include "common/Finisher.h"
 #include "mds/MDSMap.h"
+#include "mds/PurgeLanes.h"
 #include "osdc/Journaler.h"
 
 
@@ -91,6 +92,12 @@ enum {
   l_pq_executing_high_water,
   l_pq_executed,
   l_pq_item_in_journal,
+  l_pq_executed_ops,
+  l_pq_item_lat,
+  l_pq_deferred,
+  l_pq_op_limit,
+  l_pq_purge_rate,
+  l_pq_backlog_eta,
   l_pq_last
 };
 
@@ -181,6 +188,10 @@ public:
 
 private:
   uint32_t _calculate_ops(const PurgeItem &item) const;
+  int64_t _get_pool(const PurgeItem &item) const;
+  void _start_deferred();
+  void _update_latency(double lat);
+  void _update_rate(uint64_t items_left);
 
   bool _can_consume();
 
@@ -228,6 +239,19 @@ private:
   // Dynamic op limit per MDS based on PG count
   uint64_t max_purge_ops = 0;
 
+  // Per-pool shares of the op limit, the items waiting for them, and
+  // the op limit scale lowered while OSD latency exceeds
+  // mds_purge_target_latency
+  PurgeLanes lanes;
+
+  // when each executing item was started, for latency feedback
+  std::map<uint64_t, ceph::coarse_mono_time> exec_start;
+
+  // completion rate, for the backlog ETA
+  double purge_rate = 0.0;
+  uint64_t rate_items = 0;
+  ceph::coarse_mono_time rate_stamp;
+
   // How many bytes were remaining when drain() was first called,
   // used for indicating progress.
   uint64_t drain_initial = 0;
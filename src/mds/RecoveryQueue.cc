@@ -71,12 +71,12 @@ void RecoveryQueue::advance()
   while (file_recovering.size() < g_conf()->mds_max_file_recover) {
     if (!file_recover_queue_front.empty()) {
       CInode *in = file_recover_queue_front.front();
-      in->item_recover_queue_front.remove_myself();
+      in->item_recover_queue_front().remove_myself();
       file_recover_queue_front_size--;
       _start(in);
     } else if (!file_recover_queue.empty()) {
       CInode *in = file_recover_queue.front();
-      in->item_recover_queue.remove_myself();
+      in->item_recover_queue().remove_myself();
       file_recover_queue_size--;
       _start(in);
     } else {
@@ -132,14 +132,14 @@ void RecoveryQueue::prioritize(CInode *in)
     return;
   }
 
-  if (!in->item_recover_queue_front.is_on_list()) {
+  if (!in->item_recover_queue_front().is_on_list()) {
     dout(20) << *in << dendl;
 
-    ceph_assert(in->item_recover_queue.is_on_list());
-    in->item_recover_queue.remove_myself();
+    ceph_assert(in->item_recover_queue().is_on_list());
+    in->item_recover_queue().remove_myself();
     file_recover_queue_size--;
 
-    file_recover_queue_front.push_back(&in->item_recover_queue_front);
+    file_recover_queue_front.push_back(&in->item_recover_queue_front());
 
     file_recover_queue_front_size++;
     logger->set(l_mdc_num_recovering_prioritized, file_recover_queue_front_size);
@@ -151,8 +151,8 @@ void RecoveryQueue::prioritize(CInode *in)
 
 static bool _is_in_any_recover_queue(CInode *in)
 {
-  return in->item_recover_queue.is_on_list() ||
-	 in->item_recover_queue_front.is_on_list();
+  return in->item_recover_queue().is_on_list() ||
+	 in->item_recover_queue_front().is_on_list();
 }
 
 /**
@@ -173,7 +173,7 @@ void RecoveryQueue::enqueue(CInode *in)
   }
 
   if (!_is_in_any_recover_queue(in)) {
-    file_recover_queue.push_back(&in->item_recover_queue);
+    file_recover_queue.push_back(&in->item_recover_queue());
     file_recover_queue_size++;
     logger->set(l_mdc_num_recovering_enqueued, file_recover_queue_size + file_recover_queue_front_size);
   }
@@ -215,12 +215,12 @@ void RecoveryQueue::_recovered(CInode *in, int r, uint64_t size, utime_t mtime)
   in->state_clear(CInode::STATE_RECOVERING);
 
   if (restart) {
-    if (in->item_recover_queue.is_on_list()) {
-      in->item_recover_queue.remove_myself();
+    if (in->item_recover_queue().is_on_list()) {
+      in->item_recover_queue().remove_myself();
       file_recover_queue_size--;
     }
-    if (in->item_recover_queue_front.is_on_list()) {
-      in->item_recover_queue_front.remove_myself();
+    if (in->item_recover_queue_front().is_on_list()) {
+      in->item_recover_queue_front().remove_myself();
       file_recover_queue_front_size--;
     }
     logger->set(l_mdc_num_recovering_enqueued, file_recover_queue_size + file_recover_queue_front_size);
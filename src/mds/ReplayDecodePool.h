@@ -0,0 +1,112 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#ifndef CEPH_MDS_REPLAYDECODEPOOL_H
+#define CEPH_MDS_REPLAYDECODEPOOL_H
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "common/ceph_mutex.h"
+#include "common/Thread.h"
+
+/*
+ * Threads that decode journal events alongside the replay thread.
+ *
+ * Replay decodes many small batches one after the other, so the threads
+ * are started once for the whole replay and handed each batch in turn;
+ * the caller works on the batch too and returns once all of it is done.
+ */
+class ReplayDecodePool {
+public:
+  /// nthreads counts the caller, so nthreads - 1 threads are started
+  explicit ReplayDecodePool(size_t nthreads) {
+    for (size_t t = 1; t < nthreads; ++t)
+      workers.push_back(make_named_thread("md_log_decode",
+					  &ReplayDecodePool::worker, this));
+  }
+  ~ReplayDecodePool() {
+    {
+      std::lock_guard l(lock);
+      stopping = true;
+    }
+    cond.notify_all();
+    for (auto& w : workers)
+      w.join();
+  }
+
+  size_t size() const {
+    return workers.size() + 1;
+  }
+
+  /// call fn(i) for every i in [0, n), spread over the pool and the caller
+  void run(size_t n, std::function<void(size_t)> fn) {
+    if (workers.empty()) {
+      for (size_t i = 0; i < n; ++i)
+	fn(i);
+      return;
+    }
+    std::unique_lock l(lock);
+    job = std::move(fn);
+    job_size = n;
+    next = 0;
+    busy = workers.size();
+    ++generation;
+    l.unlock();
+    cond.notify_all();
+
+    drain();
+
+    l.lock();
+    done_cond.wait(l, [this] { return busy == 0; });
+    job = nullptr;
+  }
+
+private:
+  void drain() {
+    for (size_t i = next++; i < job_size; i = next++)
+      job(i);
+  }
+
+  void worker() {
+    std::unique_lock l(lock);
+    uint64_t seen = 0;
+    while (true) {
+      cond.wait(l, [&] { return stopping || generation != seen; });
+      if (stopping)
+	return;
+      seen = generation;
+      l.unlock();
+      drain();
+      l.lock();
+      if (--busy == 0)
+	done_cond.notify_one();
+    }
+  }
+
+  ceph::mutex lock = ceph::make_mutex("ReplayDecodePool::lock");
+  ceph::condition_variable cond;       ///< a new batch, or stopping
+  ceph::condition_variable done_cond;  ///< the workers are done with it
+  std::vector<std::thread> workers;
+  bool stopping = false;
+
+  // the current batch; set under lock before generation moves on
+  uint64_t generation = 0;
+  std::function<void(size_t)> job;
+  size_t job_size = 0;
+  std::atomic<size_t> next = {0};
+  size_t busy = 0;
+};
+
+#endif
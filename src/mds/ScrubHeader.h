@@ -16,11 +16,14 @@
 #ifndef SCRUB_HEADER_H_
 #define SCRUB_HEADER_H_
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <string_view>
 
+#include "common/ceph_time.h"
 #include "include/ceph_assert.h"
+#include "include/fs_types.h"
 
 namespace ceph {
 class Formatter;
@@ -63,6 +66,39 @@ public:
   }
   unsigned get_num_pending() const { return num_pending; }
 
+  // progress, as seen by this rank
+  void set_num_estimated(uint64_t n) { num_estimated = n; }
+  uint64_t get_num_estimated() const { return num_estimated; }
+  void inc_num_scrubbed() { ++num_scrubbed; }
+  uint64_t get_num_scrubbed() const { return num_scrubbed; }
+  void add_num_skipped(uint64_t n) { num_skipped += n; }
+  uint64_t get_num_skipped() const { return num_skipped; }
+  ceph::coarse_mono_time get_start_time() const { return start_time; }
+
+  struct progress_t {
+    uint64_t done = 0;       // scrubbed and skipped
+    uint64_t estimated = 0;  // never less than done
+    double percent = 0;
+    double rate = 0;         // inodes scrubbed per second
+    double eta = -1;         // seconds left, or -1 if unknown
+  };
+  progress_t get_progress(ceph::coarse_mono_time now) const {
+    progress_t p;
+    p.done = num_scrubbed + num_skipped;
+    p.estimated = std::max(num_estimated, p.done);
+    if (p.estimated)
+      p.percent = 100.0 * p.done / p.estimated;
+    double elapsed = ceph::to_seconds<double>(now - start_time);
+    if (elapsed > 0) {
+      p.rate = num_scrubbed / elapsed;
+      // skipped subtrees go by as fast as they are reached, so the time
+      // left follows everything done so far rather than the scrub rate
+      if (p.done)
+	p.eta = (p.estimated - p.done) * elapsed / p.done;
+    }
+    return p;
+  }
+
 protected:
   const std::string tag;
   bool is_tag_internal;
@@ -74,6 +110,11 @@ protected:
   bool repaired = false;  // May be set during scrub if repairs happened
   unsigned epoch_last_forwarded = 0;
   unsigned num_pending = 0;
+
+  uint64_t num_estimated = 0;  // from the origin's rstat when queued
+  uint64_t num_scrubbed = 0;
+  uint64_t num_skipped = 0;   // in subtrees unchanged since the last scrub
+  const ceph::coarse_mono_time start_time = ceph::coarse_mono_clock::now();
 };
 
 typedef std::shared_ptr<ScrubHeader> ScrubHeaderRef;
@@ -103,6 +103,12 @@ int ScrubStack::enqueue(CInode *in, ScrubHeaderRef& header, bool top)
     return -CEPHFS_EAGAIN;
 
   header->set_origin(in->ino());
+  if (header->get_recursive() && in->is_dir()) {
+    const auto& rstat = in->get_projected_inode()->rstat;
+    header->set_num_estimated(rstat.rfiles + rstat.rsubdirs);
+  } else {
+    header->set_num_estimated(1);
+  }
   auto ret = scrubbing_map.emplace(header->get_tag(), header);
   if (!ret.second) {
     dout(10) << __func__ << " with {" << *in << "}"
@@ -195,6 +201,10 @@ void ScrubStack::kick_off_scrubs()
 
     if (CInode *in = dynamic_cast<CInode*>(*it)) {
       dout(20) << __func__ << " examining " << *in << dendl;
+      if (scrub_rate_limited()) {
+	dout(20) << __func__ << " rate limited" << dendl;
+	break;
+      }
       ++it;
 
       if (!validate_inode_auth(in))
@@ -234,6 +244,85 @@ void ScrubStack::kick_off_scrubs()
       ceph_assert(0 == "dentry in scrub stack");
     }
   }
+
+  prefetch_dirfrags();
+}
+
+class C_PrefetchScrub : public MDSInternalContext {
+public:
+  C_PrefetchScrub(ScrubStack *s) :
+    MDSInternalContext(s->mdcache->mds), stack(s) {
+    stack->prefetches_in_progress++;
+  }
+  void finish(int r) override {
+    stack->prefetches_in_progress--;
+  }
+private:
+  ScrubStack *stack;
+};
+
+void ScrubStack::prefetch_dirfrag(CDir *dir)
+{
+  if (!dir->is_auth() || dir->is_complete() ||
+      dir->state_test(CDir::STATE_FETCHING) || !dir->can_auth_pin())
+    return;
+  dout(20) << __func__ << " " << *dir << dendl;
+  dir->fetch(new C_PrefetchScrub(this));
+}
+
+void ScrubStack::prefetch_dirfrags()
+{
+  const int max = g_conf().get_val<uint64_t>("mds_scrub_prefetch_dirfrags");
+  if (prefetches_in_progress >= max)
+    return;
+
+  // Only look a little way down the stack. Fetched dirfrags are not pinned
+  // and are trimmed like any other if the traversal is slow to reach them.
+  int window = max * 4;
+  for (auto it = scrub_stack.begin();
+       !it.end() && window > 0 && prefetches_in_progress < max;
+       ++it, --window) {
+    if (CDir *dir = dynamic_cast<CDir*>(*it)) {
+      prefetch_dirfrag(dir);
+    } else if (CInode *in = dynamic_cast<CInode*>(*it)) {
+      if (!in->is_dir() || !in->is_auth() || !in->can_auth_pin())
+	continue;
+      frag_vec_t frags;
+      in->dirfragtree.get_leaves(frags);
+      for (auto &fg : frags) {
+	if (prefetches_in_progress >= max)
+	  break;
+	if (in->scrub_queued_frags().contains(fg))
+	  continue;
+	prefetch_dirfrag(in->get_or_open_dirfrag(mdcache, fg));
+      }
+    }
+  }
+}
+
+bool ScrubStack::scrub_rate_limited()
+{
+  double rate = g_conf().get_val<double>("mds_scrub_rate_limit");
+  double wait = throttle.wait(rate, ceph::coarse_mono_clock::now());
+  if (wait == 0)
+    return false;
+
+  if (!rate_timer) {
+    auto fin = new LambdaContext([this](int r) {
+      rate_timer = nullptr;
+      kick_off_scrubs();
+    });
+    rate_timer = mdcache->mds->timer.add_event_after(wait, fin);
+  }
+  return true;
+}
+
+void ScrubStack::cancel_rate_timer()
+{
+  if (rate_timer) {
+    mdcache->mds->timer.cancel_event(rate_timer);
+    rate_timer = nullptr;
+  }
 }
 
 bool ScrubStack::validate_inode_auth(CInode *in)
@@ -387,6 +476,7 @@ void ScrubStack::scrub_dir_inode_final(CInode *in)
 {
   dout(20) << __func__ << " " << *in << dendl;
 
+  throttle.take();
   C_InodeValidated *fin = new C_InodeValidated(mdcache->mds, this, in);
   in->validate_disk_state(&fin->result, fin);
   return;
@@ -417,6 +507,13 @@ void ScrubStack::scrub_dirfrag(CDir *dir, bool *done)
 	  !header->get_force()) {
 	dout(15) << __func__ << " skip dentry " << it->first
 		 << ", no change since last scrub" << dendl;
+	// an unchanged directory is skipped with everything beneath it
+	uint64_t skipped = 1;
+	if (dnl->is_primary() && dnl->get_inode()->is_dir()) {
+	  const auto& rstat = dnl->get_inode()->get_projected_inode()->rstat;
+	  skipped = std::max<int64_t>(1, rstat.rfiles + rstat.rsubdirs);
+	}
+	header->add_num_skipped(skipped);
 	continue;
       }
       if (dnl->is_primary()) {
@@ -438,6 +535,7 @@ void ScrubStack::scrub_dirfrag(CDir *dir, bool *done)
 
 void ScrubStack::scrub_file_inode(CInode *in)
 {
+  throttle.take();
   C_InodeValidated *fin = new C_InodeValidated(mdcache->mds, this, in);
   // At this stage the DN is already past scrub_initialize, so
   // it's in the cache, it has PIN_SCRUBQUEUE and it is authpinned
@@ -496,6 +594,7 @@ void ScrubStack::_validate_inode_done(CInode *in, int r,
     dout(10) << __func__ << " scrub passed on inode " << *in << dendl;
   }
 
+  in->get_scrub_header()->inc_num_scrubbed();
   in->scrub_finished();
 }
 
@@ -656,6 +755,15 @@ void ScrubStack::scrub_status(Formatter *f) {
     }
 
     f->dump_string("options", optcss->strv());
+
+    auto progress = header->get_progress(ceph::coarse_mono_clock::now());
+    f->dump_unsigned("inodes_scrubbed", header->get_num_scrubbed());
+    f->dump_unsigned("inodes_skipped", header->get_num_skipped());
+    f->dump_unsigned("inodes_estimated", progress.estimated);
+    f->dump_float("progress", progress.percent);
+    f->dump_float("inodes_per_sec", progress.rate);
+    if (progress.eta >= 0)
+      f->dump_float("eta_secs", progress.eta);
     f->close_section(); // scrub id
   }
   f->close_section(); // scrubs
@@ -684,6 +792,7 @@ void ScrubStack::abort_pending_scrubs() {
   stack_size = 0;
   scrub_stack.clear();
   scrub_waiting.clear();
+  cancel_rate_timer();
 
   for (auto& p : remote_scrubs)
     remove_from_waiting(p.first, false);
@@ -749,6 +858,8 @@ void ScrubStack::scrub_pause(Context *on_finish) {
     return;
   }
 
+  cancel_rate_timer();
+
   bool done = scrub_in_transition_state();
   if (done) {
     set_state(STATE_PAUSING);
@@ -20,6 +20,7 @@
 #include "CInode.h"
 #include "MDSContext.h"
 #include "ScrubHeader.h"
+#include "ScrubThrottle.h"
 
 #include "common/LogClient.h"
 #include "include/elist.h"
@@ -117,6 +118,12 @@ protected:
   /// current number of dentries we're actually scrubbing
   int scrubs_in_progress = 0;
   int stack_size = 0;
+  /// dirfrags being read ahead of the traversal
+  int prefetches_in_progress = 0;
+
+  // inode validation rate limit
+  ScrubThrottle throttle;
+  Context *rate_timer = nullptr;
 
   struct scrub_remote_t {
     std::string tag;
@@ -152,6 +159,7 @@ private:
   friend std::ostream &operator<<(std::ostream &os, const State &state);
 
   friend class C_InodeValidated;
+  friend class C_PrefetchScrub;
 
   int _enqueue(MDSCacheObject *obj, ScrubHeaderRef& header, bool top);
   /**
@@ -165,6 +173,21 @@ private:
    */
   void kick_off_scrubs();
 
+  /**
+   * Fetch incomplete dirfrags near the top of the stack before the
+   * traversal gets to them, so that scrubbing does not stall on one
+   * dirfrag read at a time.
+   */
+  void prefetch_dirfrags();
+  void prefetch_dirfrag(CDir *dir);
+
+  /**
+   * Check mds_scrub_rate_limit before validating another inode. If we
+   * are over the limit, a timer is armed to kick the scrubs again.
+   */
+  bool scrub_rate_limited();
+  void cancel_rate_timer();
+
   /**
    * Move the inode/dirfrag that can't be scrubbed immediately
    * from scrub queue to waiting list.
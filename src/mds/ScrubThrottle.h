@@ -0,0 +1,51 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#ifndef CEPH_MDS_SCRUBTHROTTLE_H
+#define CEPH_MDS_SCRUBTHROTTLE_H
+
+#include <algorithm>
+
+#include "common/ceph_time.h"
+
+/*
+ * Token bucket behind mds_scrub_rate_limit.  Tokens accrue at `rate` per
+ * second up to a burst of one second's worth, and each inode validated
+ * takes one.  The bucket starts full whenever a limit is (re)applied.
+ */
+class ScrubThrottle {
+public:
+  /// seconds to wait before the next inode may be validated; 0 for now
+  double wait(double rate, ceph::coarse_mono_time now) {
+    if (rate <= 0) {
+      stamp = ceph::coarse_mono_time();
+      return 0;
+    }
+    double burst = std::max(rate, 1.0);
+    if (stamp == ceph::coarse_mono_time())
+      tokens = burst;
+    else
+      tokens = std::min(burst, tokens + rate * ceph::to_seconds<double>(now - stamp));
+    stamp = now;
+    return tokens >= 1.0 ? 0 : (1.0 - tokens) / rate;
+  }
+  /// an inode is being validated
+  void take() {
+    tokens -= 1.0;
+  }
+
+private:
+  double tokens = 0;
+  ceph::coarse_mono_time stamp;
+};
+
+#endif
@@ -4618,6 +4618,9 @@ void Server::handle_client_readdir(MDRequestRef& mdr)
   if (!max_bytes)
     // make sure at least one item can be encoded
     max_bytes = (512 << 10) + g_conf()->mds_max_xattr_pairs_size;
+  else
+    max_bytes = std::min<uint64_t>(max_bytes,
+				   g_conf().get_val<Option::size_t>("mds_readdir_max_bytes"));
 
   // start final blob
   bufferlist dirbl;
@@ -4763,12 +4766,41 @@ void Server::handle_client_readdir(MDRequestRef& mdr)
 
   // bump popularity.  NOTE: this doesn't quite capture it.
   mds->balancer->hit_dir(dir, META_POP_READDIR, -1, numfiles);
-  
+
+  if (end && snapid == CEPH_NOSNAP && !dir->get_frag().is_rightmost() &&
+      g_conf().get_val<bool>("mds_readdir_prefetch"))
+    readdir_prefetch_next_frag(diri, dir->get_frag());
+
   // reply
   mdr->tracei = diri;
   respond_to_request(mdr, 0);
 }
 
+/*
+ * A readdir just reached the end of a dirfrag; the client will ask for
+ * the next one as soon as it has consumed this reply.  Start loading it
+ * now so that its RADOS fetch overlaps with that instead of adding a
+ * round trip for every fragment of a large cold directory.
+ */
+void Server::readdir_prefetch_next_frag(CInode *diri, frag_t fg)
+{
+  frag_t next = diri->dirfragtree[fg.next().value()];
+  CDir *dir = diri->get_dirfrag(next);
+  if (!dir) {
+    // same rules as try_open_auth_dirfrag(), minus the forwarding
+    if (!diri->is_auth() || diri->is_frozen())
+      return;
+    dir = diri->get_or_open_dirfrag(mdcache, next);
+  }
+  if (!dir->is_auth() || dir->is_complete() ||
+      dir->state_test(CDir::STATE_FETCHING) ||
+      dir->is_frozen() || !dir->can_auth_pin())
+    return;
+
+  dout(10) << __func__ << " " << *dir << dendl;
+  dir->fetch(nullptr);
+}
+
 
 
 // ===============================================================================
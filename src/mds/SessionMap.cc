@@ -66,6 +66,15 @@ void SessionMap::register_perfcounters()
   plb.add_u64(l_mdssm_avg_load, "average_load", "Average Load");
   plb.add_u64(l_mdssm_avg_session_uptime, "avg_session_uptime",
                "Average session uptime");
+  plb.add_time_avg(l_mdssm_save_lat, "save_lat",
+                   "Latency of writing the session map");
+  plb.add_time_avg(l_mdssm_save_encode_lat, "save_encode_lat",
+                   "Time spent encoding sessions for a session map write");
+  plb.add_u64_avg(l_mdssm_save_keys, "save_keys",
+                  "Sessions written per session map write");
+  plb.add_u64_counter(l_mdssm_save_bytes, "save_bytes",
+                      "Bytes of session data written", NULL, 0,
+                      unit_t(UNIT_BYTES));
 
   logger = plb.create_perf_counters();
   g_ceph_context->get_perfcounters_collection()->add(logger);
@@ -358,15 +367,25 @@ void SessionMap::_load_legacy_finish(int r, bufferlist &bl)
 // SAVE
 
 namespace {
+// Sessions are written in their compact form once the file system's
+// compat set says that every daemon that could load them can read it.
+bool compact_sessions(MDSRank *mds)
+{
+  return mds->mdsmap->compat.incompat.contains(
+    MDS_FEATURE_INCOMPAT_COMPACT_SESSIONS);
+}
+
 class C_IO_SM_Save : public SessionMapIOContext {
   version_t version;
+  ceph::coarse_mono_time started;
 public:
-  C_IO_SM_Save(SessionMap *cm, version_t v) : SessionMapIOContext(cm), version(v) {}
+  C_IO_SM_Save(SessionMap *cm, version_t v, ceph::coarse_mono_time s)
+    : SessionMapIOContext(cm), version(v), started(s) {}
   void finish(int r) override {
     if (r != 0) {
       get_mds()->handle_write_error(r);
     } else {
-      sessionmap->_save_finish(version);
+      sessionmap->_save_finish(version, started);
     }
   }
   void print(ostream& out) const override {
@@ -391,7 +410,15 @@ void SessionMap::save(MDSContext *onsave, version_t needv)
   SnapContext snapc;
   object_t oid = get_object_name();
   object_locator_t oloc(mds->get_metadata_pool());
-
+  auto started = ceph::coarse_mono_clock::now();
+  uint64_t nkeys = 0, nbytes = 0;
+
+  /*
+   * The header (which carries the version) and every dirty session go
+   * in one op, so the object is never seen with sessions newer than its
+   * version: replaying the journal on top of such sessions would apply
+   * their prealloc_inos changes twice.
+   */
   ObjectOperation op;
 
   /* Compose OSD OMAP transaction for full write */
@@ -409,6 +436,7 @@ void SessionMap::save(MDSContext *onsave, version_t needv)
   }
 
   dout(20) << " updating keys:" << dendl;
+  const bool compact = compact_sessions(mds);
   map<string, bufferlist> to_set;
   for(std::set<entity_name_t>::iterator i = dirty_sessions.begin();
       i != dirty_sessions.end(); ++i) {
@@ -426,10 +454,12 @@ void SessionMap::save(MDSContext *onsave, version_t needv)
 
       // Serialize V
       bufferlist bl;
-      session->info.encode(bl, mds->mdsmap->get_up_features());
+      session->info.encode(bl, mds->mdsmap->get_up_features(), compact);
 
       // Add to RADOS op
-      to_set[std::string(css->strv())] = bl;
+      nbytes += bl.length();
+      ++nkeys;
+      to_set[std::string(css->strv())] = std::move(bl);
 
       session->clear_dirty_completed_requests();
     } else {
@@ -456,17 +486,23 @@ void SessionMap::save(MDSContext *onsave, version_t needv)
   dirty_sessions.clear();
   null_sessions.clear();
 
+  logger->tinc(l_mdssm_save_encode_lat,
+	       ceph::coarse_mono_clock::now() - started);
+  logger->inc(l_mdssm_save_keys, nkeys);
+  logger->inc(l_mdssm_save_bytes, nbytes);
+
   mds->objecter->mutate(oid, oloc, op, snapc,
 			ceph::real_clock::now(),
 			0,
-			new C_OnFinisher(new C_IO_SM_Save(this, version),
+			new C_OnFinisher(new C_IO_SM_Save(this, version, started),
 					 mds->finisher));
 }
 
-void SessionMap::_save_finish(version_t v)
+void SessionMap::_save_finish(version_t v, ceph::coarse_mono_time started)
 {
   dout(10) << "_save_finish v" << v << dendl;
   committed = v;
+  logger->tinc(l_mdssm_save_lat, ceph::coarse_mono_clock::now() - started);
 
   finish_contexts(g_ceph_context, commit_waiters[v]);
   commit_waiters.erase(v);
@@ -873,7 +909,8 @@ void SessionMap::save_if_dirty(const std::set<entity_name_t> &tgt_sessions,
 
     // Serialize V
     bufferlist bl;
-    session->info.encode(bl, mds->mdsmap->get_up_features());
+    session->info.encode(bl, mds->mdsmap->get_up_features(),
+			 compact_sessions(mds));
 
     // Add to RADOS op
     to_set[css->str()] = bl;
@@ -45,6 +45,10 @@ enum {
   l_mdssm_total_load,
   l_mdssm_avg_load,
   l_mdssm_avg_session_uptime,
+  l_mdssm_save_lat,
+  l_mdssm_save_encode_lat,
+  l_mdssm_save_keys,
+  l_mdssm_save_bytes,
   l_mdssm_last,
 };
 
@@ -738,7 +742,7 @@ public:
   void _load_legacy_finish(int r, ceph::buffer::list &bl);
 
   void save(MDSContext *onsave, version_t needv=0);
-  void _save_finish(version_t v);
+  void _save_finish(version_t v, ceph::coarse_mono_time started);
 
   /**
    * Advance the version, and mark this session
@@ -71,6 +71,7 @@ namespace ceph {
     CLIENT_METRIC_TYPE_OPENED_FILES,		\
     CLIENT_METRIC_TYPE_PINNED_ICAPS,		\
     CLIENT_METRIC_TYPE_OPENED_INODES,		\
+    CLIENT_METRIC_TYPE_LATENCY_HISTOGRAMS,	\
 }
 
 #define CEPHFS_FEATURES_MDS_SUPPORTED CEPHFS_FEATURES_ALL
@@ -571,6 +571,12 @@ private:
   
   void add_dir_context(CDir *dir, int mode = TO_AUTH_SUBTREE_ROOT);
 
+  // unpack every dirlump's dentries now rather than lazily during replay
+  void decode_bits() const {
+    for (const auto& p : lump_map)
+      p.second._decode_bits();
+  }
+
   bool empty() {
     return roots.empty() && lump_order.empty() && table_tids.empty() &&
 	   truncate_start.empty() && truncate_finish.empty() &&
@@ -559,13 +559,63 @@ void client_metadata_t::dump(Formatter *f) const
 /*
  * session_info_t
  */
-void session_info_t::encode(bufferlist& bl, uint64_t features) const
+
+// The v8 encoding stores completed_requests and prealloc_inos as runs of
+// varints (in the layout of denc_varint): tids only grow and most
+// completed requests created no inode, so an entry usually takes two or
+// three bytes instead of sixteen.
+static void encode_varint(uint64_t v, bufferlist& bl)
+{
+  char buf[10];
+  int n = 0;
+  while (v >= 0x80) {
+    buf[n++] = (char)(0x80 | (v & 0x7f));
+    v >>= 7;
+  }
+  buf[n++] = (char)v;
+  bl.append(buf, n);
+}
+
+static uint64_t decode_varint(bufferlist::const_iterator& p)
 {
-  ENCODE_START(7, 7, bl);
+  uint64_t v = 0;
+  uint8_t byte;
+  int shift = 0;
+  do {
+    decode(byte, p);
+    if (shift >= 64)
+      throw ceph::buffer::malformed_input("varint too long");
+    v |= (uint64_t)(byte & 0x7f) << shift;
+    shift += 7;
+  } while (byte & 0x80);
+  return v;
+}
+
+void session_info_t::encode(bufferlist& bl, uint64_t features, bool compact) const
+{
+  const __u8 v = compact ? 8 : 7;
+  ENCODE_START(v, v, bl);
   encode(inst, bl, features);
-  encode(completed_requests, bl);
-  encode(prealloc_inos, bl);   // hacky, see below.
-  encode((__u32)0, bl); // used_inos
+  if (compact) {
+    encode_varint(completed_requests.size(), bl);
+    ceph_tid_t last_tid = 0;
+    for (const auto& [tid, ino] : completed_requests) {
+      encode_varint(tid - last_tid, bl);
+      encode_varint(ino, bl);
+      last_tid = tid;
+    }
+    encode_varint(prealloc_inos.num_intervals(), bl);
+    uint64_t last_end = 0;
+    for (const auto& [start, len] : prealloc_inos) {
+      encode_varint(start - last_end, bl);
+      encode_varint(len, bl);
+      last_end = start + len;
+    }
+  } else {
+    encode(completed_requests, bl);
+    encode(prealloc_inos, bl);   // hacky, see below.
+    encode((__u32)0, bl); // used_inos
+  }
   encode(completed_flushes, bl);
   encode(auth_name, bl);
   encode(client_metadata, bl);
@@ -574,23 +624,43 @@ void session_info_t::encode(bufferlist& bl, uint64_t features) const
 
 void session_info_t::decode(bufferlist::const_iterator& p)
 {
-  DECODE_START_LEGACY_COMPAT_LEN(7, 2, 2, p);
+  DECODE_START_LEGACY_COMPAT_LEN(8, 2, 2, p);
   decode(inst, p);
-  if (struct_v <= 2) {
-    set<ceph_tid_t> s;
-    decode(s, p);
-    while (!s.empty()) {
-      completed_requests[*s.begin()] = inodeno_t();
-      s.erase(s.begin());
+  if (struct_v >= 8) {
+    completed_requests.clear();
+    ceph_tid_t tid = 0;
+    for (uint64_t n = decode_varint(p); n > 0; n--) {
+      tid += decode_varint(p);
+      completed_requests.emplace_hint(completed_requests.end(), tid,
+				      inodeno_t(decode_varint(p)));
+    }
+    prealloc_inos.clear();
+    uint64_t end = 0;
+    for (uint64_t n = decode_varint(p); n > 0; n--) {
+      uint64_t start = end + decode_varint(p);
+      uint64_t len = decode_varint(p);
+      if (len == 0)
+	throw ceph::buffer::malformed_input("empty prealloc_inos interval");
+      prealloc_inos.insert(inodeno_t(start), inodeno_t(len));
+      end = start + len;
     }
   } else {
-    decode(completed_requests, p);
-  }
-  decode(prealloc_inos, p);
-  {
-    interval_set<inodeno_t> used_inos;
-    decode(used_inos, p);
-    prealloc_inos.insert(used_inos);
+    if (struct_v <= 2) {
+      set<ceph_tid_t> s;
+      decode(s, p);
+      while (!s.empty()) {
+	completed_requests[*s.begin()] = inodeno_t();
+	s.erase(s.begin());
+      }
+    } else {
+      decode(completed_requests, p);
+    }
+    decode(prealloc_inos, p);
+    {
+      interval_set<inodeno_t> used_inos;
+      decode(used_inos, p);
+      prealloc_inos.insert(used_inos);
+    }
   }
   if (struct_v >= 4 && struct_v < 7) {
     decode(client_metadata.kv_map, p);
@@ -1335,7 +1335,10 @@ struct session_info_t {
     client_metadata.clear();
   }
 
-  void encode(ceph::buffer::list& bl, uint64_t features) const;
+  /// compact: pack completed_requests and prealloc_inos (v8), which
+  /// only daemons with MDS_FEATURE_INCOMPAT_COMPACT_SESSIONS can read
+  void encode(ceph::buffer::list& bl, uint64_t features,
+	      bool compact=false) const;
   void decode(ceph::buffer::list::const_iterator& p);
   void dump(ceph::Formatter *f) const;
   static void generate_test_instances(std::list<session_info_t*>& ls);
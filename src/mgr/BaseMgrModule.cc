@@ -1095,6 +1095,9 @@ ceph_add_mds_perf_query(BaseMgrModule *self, PyObject *args)
     {"opened_files", MDSPerformanceCounterType::OPENED_FILES_METRIC},
     {"pinned_icaps", MDSPerformanceCounterType::PINNED_ICAPS_METRIC},
     {"opened_inodes", MDSPerformanceCounterType::OPENED_INODES_METRIC},
+    {"read_latency_tail", MDSPerformanceCounterType::READ_LATENCY_TAIL_METRIC},
+    {"write_latency_tail", MDSPerformanceCounterType::WRITE_LATENCY_TAIL_METRIC},
+    {"metadata_latency_tail", MDSPerformanceCounterType::METADATA_LATENCY_TAIL_METRIC},
   };
 
   PyObject *py_query = nullptr;
@@ -33,6 +33,9 @@ void MDSPerformanceCounterDescriptor::pack_counter(
   case MDSPerformanceCounterType::OPENED_FILES_METRIC:
   case MDSPerformanceCounterType::PINNED_ICAPS_METRIC:
   case MDSPerformanceCounterType::OPENED_INODES_METRIC:
+  case MDSPerformanceCounterType::READ_LATENCY_TAIL_METRIC:
+  case MDSPerformanceCounterType::WRITE_LATENCY_TAIL_METRIC:
+  case MDSPerformanceCounterType::METADATA_LATENCY_TAIL_METRIC:
     break;
   default:
     ceph_abort_msg("unknown counter type");
@@ -53,6 +56,9 @@ void MDSPerformanceCounterDescriptor::unpack_counter(
   case MDSPerformanceCounterType::OPENED_FILES_METRIC:
   case MDSPerformanceCounterType::PINNED_ICAPS_METRIC:
   case MDSPerformanceCounterType::OPENED_INODES_METRIC:
+  case MDSPerformanceCounterType::READ_LATENCY_TAIL_METRIC:
+  case MDSPerformanceCounterType::WRITE_LATENCY_TAIL_METRIC:
+  case MDSPerformanceCounterType::METADATA_LATENCY_TAIL_METRIC:
     break;
   default:
     ceph_abort_msg("unknown counter type");
@@ -85,6 +91,15 @@ std::ostream& operator<<(std::ostream &os, const MDSPerformanceCounterDescriptor
    case MDSPerformanceCounterType::OPENED_INODES_METRIC:
      os << "opened_inodes_metric";
      break;
+   case MDSPerformanceCounterType::READ_LATENCY_TAIL_METRIC:
+     os << "read_latency_tail_metric";
+     break;
+   case MDSPerformanceCounterType::WRITE_LATENCY_TAIL_METRIC:
+     os << "write_latency_tail_metric";
+     break;
+   case MDSPerformanceCounterType::METADATA_LATENCY_TAIL_METRIC:
+     os << "metadata_latency_tail_metric";
+     break;
    }
 
    return os;
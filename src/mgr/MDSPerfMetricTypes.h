@@ -124,6 +124,10 @@ enum class MDSPerformanceCounterType : uint8_t {
   OPENED_FILES_METRIC = 5,
   PINNED_ICAPS_METRIC = 6,
   OPENED_INODES_METRIC = 7,
+  // p99 and p999 from the latency histograms, in microseconds
+  READ_LATENCY_TAIL_METRIC = 8,
+  WRITE_LATENCY_TAIL_METRIC = 9,
+  METADATA_LATENCY_TAIL_METRIC = 10,
 };
 
 struct MDSPerformanceCounterDescriptor {
@@ -139,6 +143,9 @@ struct MDSPerformanceCounterDescriptor {
     case MDSPerformanceCounterType::OPENED_FILES_METRIC:
     case MDSPerformanceCounterType::PINNED_ICAPS_METRIC:
     case MDSPerformanceCounterType::OPENED_INODES_METRIC:
+    case MDSPerformanceCounterType::READ_LATENCY_TAIL_METRIC:
+    case MDSPerformanceCounterType::WRITE_LATENCY_TAIL_METRIC:
+    case MDSPerformanceCounterType::METADATA_LATENCY_TAIL_METRIC:
       return true;
     default:
       return false;
@@ -30,6 +30,9 @@
 
 using std::string;
 
+thread_local ObjectStore::access_class_t ObjectStore::current_access_class =
+  ObjectStore::access_class_t::CLIENT;
+
 std::unique_ptr<ObjectStore> ObjectStore::create(
   CephContext *cct,
   const string& type,
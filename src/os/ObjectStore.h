@@ -120,6 +120,46 @@ public:
    */
   virtual const PerfCounters* get_perf_counters() const = 0;
 
+  /**
+   * What the calling thread's accesses are on behalf of.
+   *
+   * Callers set it around a unit of work with an AccessClassScope.  A store
+   * may use it to account for or to shield its caches, never to change what
+   * an operation does.  Threads that never set it count as CLIENT.
+   */
+  enum class access_class_t : uint8_t {
+    CLIENT = 0,
+    SCRUB,
+    RECOVERY,   ///< recovery and backfill
+    OTHER,      ///< other background work, e.g. snap trimming or pg removal
+    MAX
+  };
+  static const char *get_access_class_name(access_class_t c) {
+    switch (c) {
+    case access_class_t::CLIENT: return "client";
+    case access_class_t::SCRUB: return "scrub";
+    case access_class_t::RECOVERY: return "recovery";
+    case access_class_t::OTHER: return "other";
+    default: return "???";
+    }
+  }
+  static access_class_t get_access_class() {
+    return current_access_class;
+  }
+  class AccessClassScope {
+    access_class_t prev;
+  public:
+    explicit AccessClassScope(access_class_t c) : prev(current_access_class) {
+      current_access_class = c;
+    }
+    ~AccessClassScope() {
+      current_access_class = prev;
+    }
+  };
+private:
+  static thread_local access_class_t current_access_class;
+public:
+
   /**
    * a collection also orders transactions
    *
@@ -1143,6 +1143,156 @@ struct LruOnodeCacheShard : public BlueStore::OnodeCacheShard {
   }
 };
 
+// TwoQOnodeCacheShard
+//
+// Onodes first land in warm_in and only move to hot if they are looked up
+// again after being evicted from there, so a scrub or backfill pass over
+// many objects churns warm_in and leaves hot alone.  Evicted onodes are
+// gone, so the "A1out" list only remembers their oids (hashed).
+struct TwoQOnodeCacheShard : public BlueStore::OnodeCacheShard {
+  typedef boost::intrusive::list<
+    BlueStore::Onode,
+    boost::intrusive::member_hook<
+      BlueStore::Onode,
+      boost::intrusive::list_member_hook<>,
+      &BlueStore::Onode::lru_item> > list_t;
+  list_t hot;      ///< "Am" hot onodes
+  list_t warm_in;  ///< "A1in" newly warm onodes
+
+  /// "A1out" oid hashes of onodes evicted from warm_in, oldest first
+  mempool::bluestore_cache_other::list<size_t> warm_out;
+  mempool::bluestore_cache_other::unordered_map<
+    size_t,
+    mempool::bluestore_cache_other::list<size_t>::iterator> warm_out_index;
+
+  enum {
+    ONODE_NEW = 0,
+    ONODE_WARM_IN,   ///< in warm_in
+    ONODE_HOT,       ///< in hot
+  };
+
+  explicit TwoQOnodeCacheShard(CephContext *cct) : BlueStore::OnodeCacheShard(cct) {}
+
+  list_t& _list_of(BlueStore::Onode* o) {
+    ceph_assert(o->cache_private != ONODE_NEW);
+    return o->cache_private == ONODE_HOT ? hot : warm_in;
+  }
+
+  void _add(BlueStore::Onode* o, int level) override
+  {
+    if (o->cache_private == ONODE_NEW) {
+      auto p = warm_out_index.find(std::hash<ghobject_t>()(o->oid));
+      if (p != warm_out_index.end()) {
+	// evicted while still warm, and wanted again
+	warm_out.erase(p->second);
+	warm_out_index.erase(p);
+	o->cache_private = ONODE_HOT;
+	logger->inc(l_bluestore_onode_ghost_hits);
+      } else {
+	o->cache_private = ONODE_WARM_IN;
+      }
+    }
+    if (o->put_cache()) {
+      auto& l = _list_of(o);
+      (level > 0) ? l.push_front(*o) : l.push_back(*o);
+    } else {
+      ++num_pinned;
+    }
+    ++num; // we count both pinned and unpinned entries
+    dout(20) << __func__ << " " << this << " " << o->oid << " added to "
+	     << (o->cache_private == ONODE_HOT ? "hot" : "warm_in")
+	     << ", num=" << num << dendl;
+  }
+  void _rm(BlueStore::Onode* o) override
+  {
+    if (o->pop_cache()) {
+      auto& l = _list_of(o);
+      l.erase(l.iterator_to(*o));
+    } else {
+      ceph_assert(num_pinned);
+      --num_pinned;
+    }
+    ceph_assert(num);
+    --num;
+    dout(20) << __func__ << " " << this << " " << o->oid << " removed, num=" << num << dendl;
+  }
+  void _pin(BlueStore::Onode* o) override
+  {
+    auto& l = _list_of(o);
+    l.erase(l.iterator_to(*o));
+    ++num_pinned;
+    dout(20) << __func__ << " " << this << " " << o->oid << " pinned" << dendl;
+  }
+  void _unpin(BlueStore::Onode* o) override
+  {
+    // a warm onode stays warm however often it is used; only coming back
+    // after eviction makes it hot
+    _list_of(o).push_front(*o);
+    ceph_assert(num_pinned);
+    --num_pinned;
+    dout(20) << __func__ << " " << this << " " << o->oid << " unpinned" << dendl;
+  }
+  void _unpin_and_rm(BlueStore::Onode* o) override
+  {
+    o->pop_cache();
+    ceph_assert(num_pinned);
+    --num_pinned;
+    ceph_assert(num);
+    --num;
+  }
+  void _trim_to(uint64_t new_size) override
+  {
+    uint64_t kin = new_size * cct->_conf->bluestore_2q_cache_kin_ratio;
+    uint64_t kout = new_size * cct->_conf->bluestore_2q_cache_kout_ratio;
+    while (warm_in.size() + hot.size() > new_size) {
+      BlueStore::Onode *o;
+      bool warm = warm_in.size() > kin || hot.empty();
+      if (warm) {
+	o = &warm_in.back();
+	warm_in.pop_back();
+	size_t h = std::hash<ghobject_t>()(o->oid);
+	if (warm_out_index.count(h) == 0) {
+	  warm_out.push_back(h);
+	  warm_out_index[h] = std::prev(warm_out.end());
+	}
+      } else {
+	o = &hot.back();
+	hot.pop_back();
+      }
+      dout(20) << __func__ << "  rm " << (warm ? "warm_in " : "hot ") << o->oid
+	       << " " << o->nref << " " << o->cached << " " << o->pinned << dendl;
+      ceph_assert(num);
+      --num;
+      auto pinned = !o->pop_cache();
+      ceph_assert(!pinned);
+      o->c->onode_map._remove(o->oid);
+    }
+    while (warm_out.size() > kout) {
+      warm_out_index.erase(warm_out.front());
+      warm_out.pop_front();
+    }
+  }
+  void move_pinned(OnodeCacheShard *to, BlueStore::Onode *o) override
+  {
+    if (to == this) {
+      return;
+    }
+    ceph_assert(o->cached);
+    ceph_assert(o->pinned);
+    ceph_assert(num);
+    ceph_assert(num_pinned);
+    --num_pinned;
+    --num;
+    ++to->num_pinned;
+    ++to->num;
+  }
+  void add_stats(uint64_t *onodes, uint64_t *pinned_onodes) override
+  {
+    *onodes += num;
+    *pinned_onodes += num_pinned;
+  }
+};
+
 // OnodeCacheShard
 BlueStore::OnodeCacheShard *BlueStore::OnodeCacheShard::create(
     CephContext* cct,
@@ -1150,8 +1300,10 @@ BlueStore::OnodeCacheShard *BlueStore::OnodeCacheShard::create(
     PerfCounters *logger)
 {
   BlueStore::OnodeCacheShard *c = nullptr;
-  // Currently we only implement an LRU cache for onodes
-  c = new LruOnodeCacheShard(cct);
+  if (type == "2q")
+    c = new TwoQOnodeCacheShard(cct);
+  else
+    c = new LruOnodeCacheShard(cct);
   c->logger = logger;
   return c;
 }
@@ -1887,10 +2039,17 @@ BlueStore::OnodeRef BlueStore::OnodeSpace::lookup(const ghobject_t& oid)
     }
   }
 
+  // per access class counters come in hits/misses pairs
+  static_assert(l_bluestore_onode_other_misses + 1 - l_bluestore_onode_client_hits ==
+		2 * static_cast<int>(ObjectStore::access_class_t::MAX));
+  int by_class = l_bluestore_onode_client_hits +
+    2 * static_cast<int>(ObjectStore::get_access_class());
   if (hit) {
     cache->logger->inc(l_bluestore_onode_hits);
+    cache->logger->inc(by_class);
   } else {
     cache->logger->inc(l_bluestore_onode_misses);
+    cache->logger->inc(by_class + 1);
   }
   return o;
 }
@@ -3675,10 +3834,11 @@ void BlueStore::Onode::flush()
 {
   if (flushing_count.load()) {
     ldout(c->store->cct, 20) << __func__ << " cnt:" << flushing_count << dendl;
+    auto& stripe = c->store->_get_onode_flush_stripe(this);
     waiting_count++;
-    std::unique_lock l(flush_lock);
+    std::unique_lock l(stripe.lock);
     while (flushing_count.load()) {
-      flush_cond.wait(l);
+      stripe.cond.wait(l);
     }
     waiting_count--;
   }
@@ -4508,8 +4668,6 @@ BlueStore::BlueStore(CephContext *cct,
   : ObjectStore(cct, path),
     throttle(cct),
     finisher(cct, "commit_finisher", "cfin"),
-    kv_sync_thread(this),
-    kv_finalize_thread(this),
 #ifdef HAVE_LIBZBD
     zoned_cleaner_thread(this),
 #endif
@@ -4968,6 +5126,24 @@ void BlueStore::_init_logger()
   b.add_u64_counter(l_bluestore_onode_shard_misses,
 		    "bluestore_onode_shard_misses",
 		    "Sum for onode-shard lookups missed in the cache");
+  b.add_u64_counter(l_bluestore_onode_client_hits, "bluestore_onode_client_hits",
+		    "Client onode-lookups hit in the cache");
+  b.add_u64_counter(l_bluestore_onode_client_misses, "bluestore_onode_client_misses",
+		    "Client onode-lookups missed in the cache");
+  b.add_u64_counter(l_bluestore_onode_scrub_hits, "bluestore_onode_scrub_hits",
+		    "Scrub onode-lookups hit in the cache");
+  b.add_u64_counter(l_bluestore_onode_scrub_misses, "bluestore_onode_scrub_misses",
+		    "Scrub onode-lookups missed in the cache");
+  b.add_u64_counter(l_bluestore_onode_recovery_hits, "bluestore_onode_recovery_hits",
+		    "Recovery and backfill onode-lookups hit in the cache");
+  b.add_u64_counter(l_bluestore_onode_recovery_misses, "bluestore_onode_recovery_misses",
+		    "Recovery and backfill onode-lookups missed in the cache");
+  b.add_u64_counter(l_bluestore_onode_other_hits, "bluestore_onode_other_hits",
+		    "Other background onode-lookups hit in the cache");
+  b.add_u64_counter(l_bluestore_onode_other_misses, "bluestore_onode_other_misses",
+		    "Other background onode-lookups missed in the cache");
+  b.add_u64_counter(l_bluestore_onode_ghost_hits, "bluestore_onode_ghost_hits",
+		    "Onodes loaded again soon after eviction, and made hot (2q only)");
   b.add_u64(l_bluestore_extents, "bluestore_extents",
 	    "Number of extents in cache");
   b.add_u64(l_bluestore_blobs, "bluestore_blobs",
@@ -5024,6 +5200,13 @@ void BlueStore::_init_logger()
                     "Read EIO errors propagated to high level callers");
   b.add_u64_counter(l_bluestore_reads_with_retries, "bluestore_reads_with_retries",
                     "Read operations that required at least one retry due to failed checksum validation");
+  b.add_u64_counter(l_bluestore_read_zero_bytes, "bluestore_read_zero_bytes",
+		    "Bytes of holes in read results served from the shared zero buffer",
+		    NULL, 0, unit_t(UNIT_BYTES));
+  b.add_u64_counter(l_bluestore_read_copied_bytes, "bluestore_read_copied_bytes",
+		    "Bytes of blobs decompressed to build read results; other "
+		    "copies on the read path are not counted",
+		    NULL, 0, unit_t(UNIT_BYTES));
   b.add_u64(l_bluestore_fragmentation, "bluestore_fragmentation_micros",
             "How fragmented bluestore free space is (free extents / max possible number of free extents) * 1000");
   b.add_time_avg(l_bluestore_omap_seek_to_first_lat, "omap_seek_to_first_lat",
@@ -7100,9 +7283,10 @@ void BlueStore::set_cache_shards(unsigned num)
   onode_cache_shards.resize(num);
   buffer_cache_shards.resize(num);
   for (unsigned i = oold; i < num; ++i) {
-    onode_cache_shards[i] = 
-        OnodeCacheShard::create(cct, cct->_conf->bluestore_cache_type,
-                                 logger);
+    onode_cache_shards[i] =
+        OnodeCacheShard::create(
+          cct, cct->_conf.get_val<std::string>("bluestore_onode_cache_type"),
+          logger);
   }
   for (unsigned i = bold; i < num; ++i) {
     buffer_cache_shards[i] = 
@@ -7931,6 +8115,122 @@ public:
   };
 };
 
+// Deep fsck reads every object's data back to verify its checksums.  Done
+// inline, that is one synchronous read at a time, so instead the fsck
+// thread hands each onode, once its metadata is checked, to a few reader
+// threads and goes on with the scan, keeping several reads in flight.
+class DeepFSCKReader
+{
+  BlueStore* store;
+  const size_t max_queued;
+
+  ceph::mutex lock = ceph::make_mutex("DeepFSCKReader::lock");
+  ceph::condition_variable cond;
+  std::deque<std::pair<BlueStore::CollectionRef, BlueStore::OnodeRef>> q;
+  bool stopping = false;
+  std::vector<std::thread> threads;
+
+  void entry() {
+    std::unique_lock l(lock);
+    while (true) {
+      if (q.empty()) {
+        if (stopping) {
+          break;
+        }
+        cond.wait(l);
+        continue;
+      }
+      auto [c, o] = std::move(q.front());
+      q.pop_front();
+      if (first_read == mono_clock::zero()) {
+        first_read = mono_clock::now();
+      }
+      cond.notify_all();
+      l.unlock();
+
+      uint64_t read = 0;
+      errors += store->fsck_deep_read_object(c.get(), o, &read);
+      bytes += read;
+      ++objects;
+      o.reset();
+      c.reset();
+      l.lock();
+      last_done = mono_clock::now();
+    }
+  }
+
+  // from the first read started to the last one done: the rate is the
+  // readers' own, not diluted by the metadata scan before them
+  mono_clock::time_point first_read = mono_clock::zero();
+  mono_clock::time_point last_done = mono_clock::zero();
+
+public:
+  std::atomic<int64_t> errors = {0};
+  std::atomic<uint64_t> objects = {0};
+  std::atomic<uint64_t> bytes = {0};
+
+  DeepFSCKReader(BlueStore* store, size_t thread_count)
+    : store(store), max_queued(thread_count * 16) {
+    for (size_t i = 0; i < thread_count; i++) {
+      threads.push_back(make_named_thread("bstore_fsck_rd",
+                                          &DeepFSCKReader::entry, this));
+    }
+  }
+  ~DeepFSCKReader() {
+    stop();
+  }
+
+  void queue(BlueStore::CollectionRef c, BlueStore::OnodeRef&& o) {
+    std::unique_lock l(lock);
+    cond.wait(l, [this] { return q.size() < max_queued; });
+    q.emplace_back(std::move(c), std::move(o));
+    cond.notify_all();
+  }
+
+  void stop() {
+    {
+      std::lock_guard l(lock);
+      stopping = true;
+      cond.notify_all();
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+    threads.clear();
+  }
+
+  mono_clock::duration busy() {
+    std::lock_guard l(lock);
+    return last_done - first_read;
+  }
+};
+
+int64_t BlueStore::fsck_deep_read_object(
+  Collection* c,
+  OnodeRef& o,
+  uint64_t* bytes)
+{
+  bufferlist bl;
+  uint64_t max_read_block = cct->_conf->bluestore_fsck_read_bytes_cap;
+  uint64_t offset = 0;
+  do {
+    uint64_t l = std::min(uint64_t(o->onode.size - offset), max_read_block);
+    int r = _do_read(c, o, offset, l, bl,
+      CEPH_OSD_OP_FLAG_FADVISE_NOCACHE);
+    if (r < 0) {
+      derr << "fsck error: " << o->oid << std::hex
+        << " error during read: "
+        << " " << offset << "~" << l
+        << " " << cpp_strerror(r) << std::dec
+        << dendl;
+      return 1;
+    }
+    *bytes += r;
+    offset += l;
+  } while (offset < o->onode.size);
+  return 0;
+}
+
 void BlueStore::_fsck_check_object_omap(FSCKDepth depth,
   OnodeRef& o,
   const BlueStore::FSCK_ObjectCtx& ctx)
@@ -8088,9 +8388,18 @@ void BlueStore::_fsck_check_objects(FSCKDepth depth,
 
   size_t processed_myself = 0;
 
+  std::unique_ptr<DeepFSCKReader> deep_reader;
+  uint64_t deep_objects = 0;
+  uint64_t deep_bytes = 0;
+  mono_clock::duration deep_busy = mono_clock::duration::zero();
+
   auto it = db->get_iterator(PREFIX_OBJ, KeyValueDB::ITERATOR_NOCACHE);
   mempool::bluestore_fsck::list<string> expecting_shards;
   if (it) {
+    const size_t deep_threads = cct->_conf->bluestore_fsck_deep_read_threads;
+    if (depth == FSCK_DEEP && deep_threads > 0) {
+      deep_reader = std::make_unique<DeepFSCKReader>(this, deep_threads);
+    }
     const size_t thread_count = cct->_conf->bluestore_fsck_quick_fix_threads;
     typedef ShallowFSCKThreadPool::FSCKWorkQueue<256> WQ;
     std::unique_ptr<WQ> wq(
@@ -8296,24 +8605,14 @@ void BlueStore::_fsck_check_objects(FSCKDepth depth,
           }
         } // if (o->onode.has_omap())
         if (depth == FSCK_DEEP) {
-          bufferlist bl;
-          uint64_t max_read_block = cct->_conf->bluestore_fsck_read_bytes_cap;
-          uint64_t offset = 0;
-          do {
-            uint64_t l = std::min(uint64_t(o->onode.size - offset), max_read_block);
-            int r = _do_read(c.get(), o, offset, l, bl,
-              CEPH_OSD_OP_FLAG_FADVISE_NOCACHE);
-            if (r < 0) {
-              ++errors;
-              derr << "fsck error: " << oid << std::hex
-                << " error during read: "
-                << " " << offset << "~" << l
-                << " " << cpp_strerror(r) << std::dec
-                << dendl;
-              break;
-            }
-            offset += l;
-          } while (offset < o->onode.size);
+          if (deep_reader) {
+            deep_reader->queue(c, std::move(o));
+          } else {
+            auto start = mono_clock::now();
+            errors += fsck_deep_read_object(c.get(), o, &deep_bytes);
+            deep_busy += mono_clock::now() - start;
+            ++deep_objects;
+          }
         } // deep
       } //if (depth != FSCK_SHALLOW)
     } // for (it->lower_bound(string()); it->valid(); it->next())
@@ -8328,6 +8627,21 @@ void BlueStore::_fsck_check_objects(FSCKDepth depth,
                 << dendl;
       }
     }
+    if (deep_reader) {
+      deep_reader->stop();
+      errors += deep_reader->errors;
+      deep_objects = deep_reader->objects;
+      deep_bytes = deep_reader->bytes;
+      deep_busy = deep_reader->busy();
+    }
+    if (depth == FSCK_DEEP) {
+      double secs = ceph::to_seconds<double>(deep_busy);
+      dout(1) << __func__ << " deep read " << deep_objects << " objects, "
+              << byte_u_t(deep_bytes) << " in " << secs << " seconds ("
+              << (secs > 0 ? deep_objects / secs : 0) << " objects/s, "
+              << byte_u_t(secs > 0 ? deep_bytes / secs : 0) << "/s)"
+              << dendl;
+    }
   } // if (it)
 }
 /**
@@ -9628,8 +9942,7 @@ BlueStore::CollectionRef BlueStore::_get_collection(const coll_t& cid)
 void BlueStore::_queue_reap_collection(CollectionRef& c)
 {
   dout(10) << __func__ << " " << c << " " << c->cid << dendl;
-  // _reap_collections and this in the same thread,
-  // so no need a lock.
+  std::lock_guard l(reap_lock);
   removed_collections.push_back(c);
 }
 
@@ -9638,8 +9951,7 @@ void BlueStore::_reap_collections()
 
   list<CollectionRef> removed_colls;
   {
-    // _queue_reap_collection and this in the same thread.
-    // So no need a lock.
+    std::lock_guard l(reap_lock);
     if (!removed_collections.empty())
       removed_colls.swap(removed_collections);
     else
@@ -9669,6 +9981,7 @@ void BlueStore::_reap_collections()
   if (removed_colls.empty()) {
     dout(10) << __func__ << " all reaped" << dendl;
   } else {
+    std::lock_guard l(reap_lock);
     removed_collections.splice(removed_collections.begin(), removed_colls);
   }
 }
@@ -10022,6 +10335,20 @@ int BlueStore::_prepare_read_ioc(
   return 0;
 }
 
+// Holes in read results all point at this one run of zeros instead of each
+// read allocating and clearing its own.  Read results already share their
+// buffers with the device reads and the buffer cache, so callers never
+// write to them in place.
+static const bufferptr& get_read_zeros()
+{
+  static const bufferptr zeros = [] {
+    bufferptr p(buffer::create_page_aligned(64 * 1024));
+    p.zero();
+    return p;
+  }();
+  return zeros;
+}
+
 int BlueStore::_generate_read_result_bl(
   OnodeRef o,
   uint64_t offset,
@@ -10053,6 +10380,7 @@ int BlueStore::_generate_read_result_bl(
       auto r = _decompress(compressed_bl, &raw_bl);
       if (r < 0)
         return r;
+      logger->inc(l_bluestore_read_copied_bytes, raw_bl.length());
       if (buffered) {
         bptr->shared_blob->bc.did_read(bptr->shared_blob->get_cache(), 0,
                                        raw_bl);
@@ -10105,8 +10433,14 @@ int BlueStore::_generate_read_result_bl(
       dout(30) << __func__ << " assemble 0x" << std::hex << pos
                << ": zeros for 0x" << (pos + offset) << "~" << l
                << std::dec << dendl;
-      bl.append_zero(l);
-      pos += l;
+      logger->inc(l_bluestore_read_zero_bytes, l);
+      const bufferptr& zeros = get_read_zeros();
+      while (l > 0) {
+        unsigned n = std::min<uint64_t>(l, zeros.length());
+        bl.append(zeros, 0, n);
+        pos += n;
+        l -= n;
+      }
     }
   }
   ceph_assert(bl.length() == length);
@@ -11616,19 +11950,20 @@ void BlueStore::_txc_state_proc(TransContext *txc)
 	}
       }
       {
-	std::lock_guard l(kv_lock);
-	kv_queue.push_back(txc);
-	if (!kv_sync_in_progress) {
-	  kv_sync_in_progress = true;
-	  kv_cond.notify_one();
+	KVShard *shard = _get_kv_shard(txc->osr.get());
+	std::lock_guard l(shard->kv_lock);
+	shard->kv_queue.push_back(txc);
+	if (!shard->kv_sync_in_progress) {
+	  shard->kv_sync_in_progress = true;
+	  shard->kv_cond.notify_one();
 	}
 	if (txc->get_state() != TransContext::STATE_KV_SUBMITTED) {
-	  kv_queue_unsubmitted.push_back(txc);
+	  shard->kv_queue_unsubmitted.push_back(txc);
 	  ++txc->osr->kv_committing_serially;
 	}
 	if (txc->had_ios)
-	  kv_ios++;
-	kv_throttle_costs += txc->cost;
+	  shard->kv_ios++;
+	shard->kv_throttle_costs += txc->cost;
       }
       return;
     case TransContext::STATE_KV_SUBMITTED:
@@ -11933,8 +12268,9 @@ void BlueStore::_txc_apply_kv(TransContext *txc, bool sync_submit_transaction)
       dout(20) << __func__ << " onode " << o << " had " << o->flushing_count
 	       << dendl;
       if (--o->flushing_count == 0 && o->waiting_count.load()) {
-        std::lock_guard l(o->flush_lock);
-	o->flush_cond.notify_all();
+	auto& stripe = _get_onode_flush_stripe(o.get());
+	std::lock_guard l(stripe.lock);
+	stripe.cond.notify_all();
       }
     }
   }
@@ -12127,14 +12463,8 @@ void BlueStore::_osr_drain_preceding(TransContext *txc)
       osr->deferred_lock.unlock();
     }
   }
-  {
-    // wake up any previously finished deferred events
-    std::lock_guard l(kv_lock);
-    if (!kv_sync_in_progress) {
-      kv_sync_in_progress = true;
-      kv_cond.notify_one();
-    }
-  }
+  // wake up any previously finished deferred events
+  _get_kv_shard(osr)->wake_sync();
   osr->drain_preceding(txc);
   --deferred_aggressive;
   dout(10) << __func__ << " " << osr << " done" << dendl;
@@ -12153,14 +12483,8 @@ void BlueStore::_osr_drain(OpSequencer *osr)
       osr->deferred_lock.unlock();
     }
   }
-  {
-    // wake up any previously finished deferred events
-    std::lock_guard l(kv_lock);
-    if (!kv_sync_in_progress) {
-      kv_sync_in_progress = true;
-      kv_cond.notify_one();
-    }
-  }
+  // wake up any previously finished deferred events
+  _get_kv_shard(osr)->wake_sync();
   osr->drain();
   --deferred_aggressive;
   dout(10) << __func__ << " " << osr << " done" << dendl;
@@ -12192,14 +12516,16 @@ void BlueStore::_osr_drain_all()
     // submit anything pending
     deferred_try_submit();
   }
-  {
-    // wake up any previously finished deferred events
-    std::lock_guard l(kv_lock);
-    kv_cond.notify_one();
-  }
-  {
-    std::lock_guard l(kv_finalize_lock);
-    kv_finalize_cond.notify_one();
+  // wake up any previously finished deferred events
+  for (auto& shard : kv_shards) {
+    {
+      std::lock_guard l(shard->kv_lock);
+      shard->kv_cond.notify_one();
+    }
+    {
+      std::lock_guard l(shard->kv_finalize_lock);
+      shard->kv_finalize_cond.notify_one();
+    }
   }
   for (auto osr : s) {
     dout(20) << __func__ << " drain " << osr << dendl;
@@ -12230,56 +12556,95 @@ void BlueStore::_osr_drain_all()
 
 void BlueStore::_kv_start()
 {
-  dout(10) << __func__ << dendl;
+  unsigned num_shards = cct->_conf.get_val<uint64_t>("bluestore_kv_sync_shards");
+  dout(10) << __func__ << " " << num_shards << " shards" << dendl;
 
   finisher.start();
-  kv_sync_thread.create("bstore_kv_sync");
-  kv_finalize_thread.create("bstore_kv_final");
+  ceph_assert(kv_shards.empty());
+  for (unsigned i = 0; i < num_shards; i++) {
+    auto shard = std::make_unique<KVShard>(this, i);
+
+    PerfCountersBuilder b(cct, "bluestore-kv-shard-" + stringify(i),
+			  l_bluestore_kv_shard_first, l_bluestore_kv_shard_last);
+    b.add_time_avg(l_bluestore_kv_shard_queued_lat, "kv_queued_lat",
+		   "Average time txcs wait for this shard's kv_sync thread");
+    b.add_time_avg(l_bluestore_kv_shard_flush_lat, "kv_flush_lat",
+		   "Average kv_sync thread flush latency");
+    b.add_time_avg(l_bluestore_kv_shard_commit_lat, "kv_commit_lat",
+		   "Average kv_sync thread commit latency");
+    b.add_time_avg(l_bluestore_kv_shard_sync_lat, "kv_sync_lat",
+		   "Average kv_sync thread latency");
+    b.add_time_avg(l_bluestore_kv_shard_final_lat, "kv_final_lat",
+		   "Average kv_finalize thread latency");
+    b.add_u64_counter(l_bluestore_kv_shard_committed, "kv_committed",
+		      "Transactions committed");
+    b.add_u64_avg(l_bluestore_kv_shard_batch, "kv_batch",
+		  "Average transactions per kv commit");
+    shard->logger = b.create_perf_counters();
+    cct->get_perfcounters_collection()->add(shard->logger);
+
+    // keep the names of the first pair, tools look for them
+    if (i == 0) {
+      shard->kv_sync_thread.create("bstore_kv_sync");
+      shard->kv_finalize_thread.create("bstore_kv_final");
+    } else {
+      shard->kv_sync_thread.create(("bstore_kvsync" + stringify(i)).c_str());
+      shard->kv_finalize_thread.create(("bstore_kvfin" + stringify(i)).c_str());
+    }
+    kv_shards.push_back(std::move(shard));
+  }
 }
 
 void BlueStore::_kv_stop()
 {
   dout(10) << __func__ << dendl;
-  {
-    std::unique_lock l{kv_lock};
-    while (!kv_sync_started) {
-      kv_cond.wait(l);
+  for (auto& shard : kv_shards) {
+    {
+      std::unique_lock l{shard->kv_lock};
+      while (!shard->kv_sync_started) {
+	shard->kv_cond.wait(l);
+      }
+      shard->kv_stop = true;
+      shard->kv_cond.notify_all();
     }
-    kv_stop = true;
-    kv_cond.notify_all();
-  }
-  {
-    std::unique_lock l{kv_finalize_lock};
-    while (!kv_finalize_started) {
-      kv_finalize_cond.wait(l);
+    {
+      std::unique_lock l{shard->kv_finalize_lock};
+      while (!shard->kv_finalize_started) {
+	shard->kv_finalize_cond.wait(l);
+      }
+      shard->kv_finalize_stop = true;
+      shard->kv_finalize_cond.notify_all();
     }
-    kv_finalize_stop = true;
-    kv_finalize_cond.notify_all();
   }
-  kv_sync_thread.join();
-  kv_finalize_thread.join();
-  ceph_assert(removed_collections.empty());
-  {
-    std::lock_guard l(kv_lock);
-    kv_stop = false;
+  for (auto& shard : kv_shards) {
+    shard->kv_sync_thread.join();
+    shard->kv_finalize_thread.join();
   }
-  {
-    std::lock_guard l(kv_finalize_lock);
-    kv_finalize_stop = false;
+  ceph_assert(removed_collections.empty());
+  for (auto& shard : kv_shards) {
+    cct->get_perfcounters_collection()->remove(shard->logger);
+    delete shard->logger;
   }
+  kv_shards.clear();
   dout(10) << __func__ << " stopping finishers" << dendl;
   finisher.wait_for_empty();
   finisher.stop();
   dout(10) << __func__ << " stopped" << dendl;
 }
 
-void BlueStore::_kv_sync_thread()
+void BlueStore::_kv_sync_thread(KVShard *shard)
 {
-  dout(10) << __func__ << " start" << dendl;
+  dout(10) << __func__ << " shard " << shard->id << " start" << dendl;
   deque<DeferredBatch*> deferred_stable_queue; ///< deferred ios done + stable
+  auto& kv_lock = shard->kv_lock;
+  auto& kv_cond = shard->kv_cond;
+  auto& kv_queue = shard->kv_queue;
+  auto& kv_queue_unsubmitted = shard->kv_queue_unsubmitted;
+  auto& kv_committing = shard->kv_committing;
+  auto& deferred_done_queue = shard->deferred_done_queue;
   std::unique_lock l{kv_lock};
-  ceph_assert(!kv_sync_started);
-  kv_sync_started = true;
+  ceph_assert(!shard->kv_sync_started);
+  shard->kv_sync_started = true;
   kv_cond.notify_all();
 
   auto t0 = mono_clock::now();
@@ -12292,7 +12657,7 @@ void BlueStore::_kv_sync_thread()
       ceph::make_timespan(period);
     auto elapsed = mono_clock::now() - t0;
     if (period && elapsed >= observation_period) {
-      dout(5) << __func__ << " utilization: idle "
+      dout(5) << __func__ << " shard " << shard->id << " utilization: idle "
 	      << twait << " of " << elapsed
 	      << ", submitted: " << kv_submitted
 	      <<dendl;
@@ -12304,11 +12669,11 @@ void BlueStore::_kv_sync_thread()
     if (kv_queue.empty() &&
 	((deferred_done_queue.empty() && deferred_stable_queue.empty()) ||
 	 !deferred_aggressive)) {
-      if (kv_stop)
+      if (shard->kv_stop)
 	break;
       dout(20) << __func__ << " sleep" << dendl;
       auto t = mono_clock::now();
-      kv_sync_in_progress = false;
+      shard->kv_sync_in_progress = false;
       kv_cond.wait(l);
       twait += mono_clock::now() - t;
 
@@ -12327,10 +12692,10 @@ void BlueStore::_kv_sync_thread()
       kv_submitting.swap(kv_queue_unsubmitted);
       deferred_done.swap(deferred_done_queue);
       deferred_stable.swap(deferred_stable_queue);
-      aios = kv_ios;
-      costs = kv_throttle_costs;
-      kv_ios = 0;
-      kv_throttle_costs = 0;
+      aios = shard->kv_ios;
+      costs = shard->kv_throttle_costs;
+      shard->kv_ios = 0;
+      shard->kv_throttle_costs = 0;
       l.unlock();
 
       dout(30) << __func__ << " committing " << kv_committing << dendl;
@@ -12381,9 +12746,16 @@ void BlueStore::_kv_sync_thread()
       // increase {nid,blobid}_max?  note that this covers both the
       // case where we are approaching the max and the case we passed
       // it.  in either case, we increase the max in the earlier txn
-      // we submit.
+      // we submit.  another shard may be doing the same; wait for it,
+      // then look again.
       uint64_t new_nid_max = 0, new_blobid_max = 0;
-      if (nid_last + cct->_conf->bluestore_nid_prealloc/2 > nid_max) {
+      std::unique_lock max_l{kv_max_lock, std::defer_lock};
+      if (nid_last + cct->_conf->bluestore_nid_prealloc/2 > nid_max ||
+	  blobid_last + cct->_conf->bluestore_blobid_prealloc/2 > blobid_max) {
+	max_l.lock();
+      }
+      if (max_l.owns_lock() &&
+	  nid_last + cct->_conf->bluestore_nid_prealloc/2 > nid_max) {
 	KeyValueDB::Transaction t =
 	  kv_submitting.empty() ? synct : kv_submitting.front()->t;
 	new_nid_max = nid_last + cct->_conf->bluestore_nid_prealloc;
@@ -12392,7 +12764,8 @@ void BlueStore::_kv_sync_thread()
 	t->set(PREFIX_SUPER, "nid_max", bl);
 	dout(10) << __func__ << " new_nid_max " << new_nid_max << dendl;
       }
-      if (blobid_last + cct->_conf->bluestore_blobid_prealloc/2 > blobid_max) {
+      if (max_l.owns_lock() &&
+	  blobid_last + cct->_conf->bluestore_blobid_prealloc/2 > blobid_max) {
 	KeyValueDB::Transaction t =
 	  kv_submitting.empty() ? synct : kv_submitting.front()->t;
 	new_blobid_max = blobid_last + cct->_conf->bluestore_blobid_prealloc;
@@ -12403,7 +12776,9 @@ void BlueStore::_kv_sync_thread()
       }
 
       for (auto txc : kv_committing) {
-	throttle.log_state_latency(*txc, logger, l_bluestore_state_kv_queued_lat);
+	shard->logger->tinc(
+	  l_bluestore_kv_shard_queued_lat,
+	  throttle.log_state_latency(*txc, logger, l_bluestore_state_kv_queued_lat));
 	if (txc->get_state() == TransContext::STATE_KV_QUEUED) {
 	  ++kv_submitted;
 	  _txc_apply_kv(txc, false);
@@ -12472,7 +12847,9 @@ void BlueStore::_kv_sync_thread()
 #endif
 
       {
-	std::unique_lock m{kv_finalize_lock};
+	std::unique_lock m{shard->kv_finalize_lock};
+	auto& kv_committing_to_finalize = shard->kv_committing_to_finalize;
+	auto& deferred_stable_to_finalize = shard->deferred_stable_to_finalize;
 	if (kv_committing_to_finalize.empty()) {
 	  kv_committing_to_finalize.swap(kv_committing);
 	} else {
@@ -12491,9 +12868,9 @@ void BlueStore::_kv_sync_thread()
 	      deferred_stable.end());
 	  deferred_stable.clear();
 	}
-	if (!kv_finalize_in_progress) {
-	  kv_finalize_in_progress = true;
-	  kv_finalize_cond.notify_one();
+	if (!shard->kv_finalize_in_progress) {
+	  shard->kv_finalize_in_progress = true;
+	  shard->kv_finalize_cond.notify_one();
 	}
       }
 
@@ -12505,6 +12882,9 @@ void BlueStore::_kv_sync_thread()
 	blobid_max = new_blobid_max;
 	dout(10) << __func__ << " blobid_max now " << blobid_max << dendl;
       }
+      if (max_l.owns_lock()) {
+	max_l.unlock();
+      }
 
       {
 	auto finish = mono_clock::now();
@@ -12528,6 +12908,11 @@ void BlueStore::_kv_sync_thread()
 	  l_bluestore_kv_sync_lat,
 	  dur,
 	  cct->_conf->bluestore_log_op_age);
+	shard->logger->tinc(l_bluestore_kv_shard_flush_lat, dur_flush);
+	shard->logger->tinc(l_bluestore_kv_shard_commit_lat, dur_kv);
+	shard->logger->tinc(l_bluestore_kv_shard_sync_lat, dur);
+	shard->logger->inc(l_bluestore_kv_shard_committed, committing_size);
+	shard->logger->inc(l_bluestore_kv_shard_batch, committing_size);
       }
 
       l.lock();
@@ -12536,28 +12921,31 @@ void BlueStore::_kv_sync_thread()
       deferred_stable_queue.swap(deferred_done);
     }
   }
-  dout(10) << __func__ << " finish" << dendl;
-  kv_sync_started = false;
+  dout(10) << __func__ << " shard " << shard->id << " finish" << dendl;
+  shard->kv_sync_started = false;
 }
 
-void BlueStore::_kv_finalize_thread()
+void BlueStore::_kv_finalize_thread(KVShard *shard)
 {
   deque<TransContext*> kv_committed;
   deque<DeferredBatch*> deferred_stable;
-  dout(10) << __func__ << " start" << dendl;
-  std::unique_lock l(kv_finalize_lock);
-  ceph_assert(!kv_finalize_started);
-  kv_finalize_started = true;
+  auto& kv_finalize_cond = shard->kv_finalize_cond;
+  auto& kv_committing_to_finalize = shard->kv_committing_to_finalize;
+  auto& deferred_stable_to_finalize = shard->deferred_stable_to_finalize;
+  dout(10) << __func__ << " shard " << shard->id << " start" << dendl;
+  std::unique_lock l(shard->kv_finalize_lock);
+  ceph_assert(!shard->kv_finalize_started);
+  shard->kv_finalize_started = true;
   kv_finalize_cond.notify_all();
   while (true) {
     ceph_assert(kv_committed.empty());
     ceph_assert(deferred_stable.empty());
     if (kv_committing_to_finalize.empty() &&
 	deferred_stable_to_finalize.empty()) {
-      if (kv_finalize_stop)
+      if (shard->kv_finalize_stop)
 	break;
       dout(20) << __func__ << " sleep" << dendl;
-      kv_finalize_in_progress = false;
+      shard->kv_finalize_in_progress = false;
       kv_finalize_cond.wait(l);
       dout(20) << __func__ << " wake" << dendl;
     } else {
@@ -12600,16 +12988,18 @@ void BlueStore::_kv_finalize_thread()
       logger->set(l_bluestore_fragmentation,
 	  (uint64_t)(shared_alloc.a->get_fragmentation() * 1000));
 
+      auto dur = mono_clock::now() - start;
       log_latency("kv_final",
 	l_bluestore_kv_final_lat,
-	mono_clock::now() - start,
+	dur,
 	cct->_conf->bluestore_log_op_age);
+      shard->logger->tinc(l_bluestore_kv_shard_final_lat, dur);
 
       l.lock();
     }
   }
-  dout(10) << __func__ << " finish" << dendl;
-  kv_finalize_started = false;
+  dout(10) << __func__ << " shard " << shard->id << " finish" << dendl;
+  shard->kv_finalize_started = false;
 }
 
 #ifdef HAVE_LIBZBD
@@ -12894,14 +13284,15 @@ void BlueStore::_deferred_aio_finish(OpSequencer *osr)
   }
 
   {
-    std::lock_guard l(kv_lock);
-    deferred_done_queue.emplace_back(b);
+    KVShard *shard = _get_kv_shard(osr);
+    std::lock_guard l(shard->kv_lock);
+    shard->deferred_done_queue.emplace_back(b);
 
     // in the normal case, do not bother waking up the kv thread; it will
     // catch us on the next commit anyway.
-    if (deferred_aggressive && !kv_sync_in_progress) {
-	kv_sync_in_progress = true;
-	kv_cond.notify_one();
+    if (deferred_aggressive && !shard->kv_sync_in_progress) {
+	shard->kv_sync_in_progress = true;
+	shard->kv_cond.notify_one();
     }
   }
 }
@@ -13025,13 +13416,10 @@ int BlueStore::queue_transactions(
 	     << dendl;
     ++deferred_aggressive;
     deferred_try_submit();
-    {
-      // wake up any previously finished deferred events
-      std::lock_guard l(kv_lock);
-      if (!kv_sync_in_progress) {
-	kv_sync_in_progress = true;
-	kv_cond.notify_one();
-      }
+    // wake up any previously finished deferred events; whichever
+    // sequencer they came from, they hold the throttle we wait for
+    for (auto& shard : kv_shards) {
+      shard->wake_sync();
     }
     throttle.finish_start_transaction(*db, *txc, tstart);
     --deferred_aggressive;
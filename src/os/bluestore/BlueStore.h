@@ -19,6 +19,7 @@
 
 #include <unistd.h>
 
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <ratio>
@@ -111,6 +112,16 @@ enum {
   l_bluestore_onode_misses,
   l_bluestore_onode_shard_hits,
   l_bluestore_onode_shard_misses,
+  // onode lookups by ObjectStore::access_class_t, a hits/misses pair each
+  l_bluestore_onode_client_hits,
+  l_bluestore_onode_client_misses,
+  l_bluestore_onode_scrub_hits,
+  l_bluestore_onode_scrub_misses,
+  l_bluestore_onode_recovery_hits,
+  l_bluestore_onode_recovery_misses,
+  l_bluestore_onode_other_hits,
+  l_bluestore_onode_other_misses,
+  l_bluestore_onode_ghost_hits,
   l_bluestore_extents,
   l_bluestore_blobs,
   l_bluestore_buffers,
@@ -135,6 +146,8 @@ enum {
   l_bluestore_gc_merged,
   l_bluestore_read_eio,
   l_bluestore_reads_with_retries,
+  l_bluestore_read_zero_bytes,
+  l_bluestore_read_copied_bytes,
   l_bluestore_fragmentation,
   l_bluestore_omap_seek_to_first_lat,
   l_bluestore_omap_upper_bound_lat,
@@ -148,6 +161,19 @@ enum {
   l_bluestore_last
 };
 
+// per kv commit shard
+enum {
+  l_bluestore_kv_shard_first = 732560,
+  l_bluestore_kv_shard_queued_lat,
+  l_bluestore_kv_shard_flush_lat,
+  l_bluestore_kv_shard_commit_lat,
+  l_bluestore_kv_shard_sync_lat,
+  l_bluestore_kv_shard_final_lat,
+  l_bluestore_kv_shard_committed,
+  l_bluestore_kv_shard_batch,
+  l_bluestore_kv_shard_last
+};
+
 #define META_POOL_ID ((uint64_t)-1ull)
 
 class BlueStore : public ObjectStore,
@@ -1074,6 +1100,7 @@ public:
     mempool::bluestore_cache_meta::string key;
 
     boost::intrusive::list_member_hook<> lru_item;
+    uint8_t cache_private = 0;  ///< opaque to us; cache policy's own state
 
     bluestore_onode_t onode;  ///< metadata stored as value in kv store
     bool exists;              ///< true if object logically exists
@@ -1087,10 +1114,7 @@ public:
     // track txc's that have not been committed to kv store (and whose
     // effects cannot be read via the kvdb read methods)
     std::atomic<int> flushing_count = {0};
-    std::atomic<int> waiting_count = {0};
-    /// protect flush_txns
-    ceph::mutex flush_lock = ceph::make_mutex("BlueStore::Onode::flush_lock");
-    ceph::condition_variable flush_cond;   ///< wait here for uncommitted txns
+    std::atomic<int> waiting_count = {0};  ///< waiting on a flush stripe
 
     Onode(Collection *c, const ghobject_t& o,
 	  const mempool::bluestore_cache_meta::string& k)
@@ -1317,6 +1341,7 @@ public:
     friend struct Collection; // for split_cache()
     friend struct Onode; // for put()
     friend struct LruOnodeCacheShard;
+    friend struct TwoQOnodeCacheShard;
     void _remove(const ghobject_t& oid);
   public:
     OnodeSpace(OnodeCacheShard *c) : cache(c) {}
@@ -1999,23 +2024,70 @@ public:
       boost::intrusive::list_member_hook<>,
       &OpSequencer::deferred_osr_queue_item> > deferred_osr_queue_t;
 
+  struct KVShard;
   struct KVSyncThread : public Thread {
     BlueStore *store;
-    explicit KVSyncThread(BlueStore *s) : store(s) {}
+    KVShard *shard;
+    KVSyncThread(BlueStore *s, KVShard *sh) : store(s), shard(sh) {}
     void *entry() override {
-      store->_kv_sync_thread();
+      store->_kv_sync_thread(shard);
       return NULL;
     }
   };
   struct KVFinalizeThread : public Thread {
     BlueStore *store;
-    explicit KVFinalizeThread(BlueStore *s) : store(s) {}
+    KVShard *shard;
+    KVFinalizeThread(BlueStore *s, KVShard *sh) : store(s), shard(sh) {}
     void *entry() override {
-      store->_kv_finalize_thread();
+      store->_kv_finalize_thread(shard);
       return NULL;
     }
   };
 
+  /// one kv commit pipeline: a sync thread batching ready txcs into a
+  /// kv commit, and a finalize thread completing them.  all txcs of an
+  /// OpSequencer go through the same shard, which keeps them in order.
+  struct KVShard {
+    const unsigned id;
+    PerfCounters *logger = nullptr;
+
+    KVSyncThread kv_sync_thread;
+    ceph::mutex kv_lock = ceph::make_mutex("BlueStore::KVShard::kv_lock");
+    ceph::condition_variable kv_cond;
+    bool kv_sync_started = false;
+    bool kv_stop = false;
+    std::deque<TransContext*> kv_queue;             ///< ready, already submitted
+    std::deque<TransContext*> kv_queue_unsubmitted; ///< ready, need submit by kv thread
+    std::deque<TransContext*> kv_committing;        ///< currently syncing
+    std::deque<DeferredBatch*> deferred_done_queue;   ///< deferred ios done
+    bool kv_sync_in_progress = false;
+    uint64_t kv_ios = 0;
+    uint64_t kv_throttle_costs = 0;
+
+    KVFinalizeThread kv_finalize_thread;
+    ceph::mutex kv_finalize_lock = ceph::make_mutex("BlueStore::KVShard::kv_finalize_lock");
+    ceph::condition_variable kv_finalize_cond;
+    bool kv_finalize_started = false;
+    bool kv_finalize_stop = false;
+    std::deque<TransContext*> kv_committing_to_finalize;   ///< pending finalization
+    std::deque<DeferredBatch*> deferred_stable_to_finalize; ///< pending finalization
+    bool kv_finalize_in_progress = false;
+
+    KVShard(BlueStore *store, unsigned i)
+      : id(i),
+	kv_sync_thread(store, this),
+	kv_finalize_thread(store, this) {}
+
+    /// wake the sync thread unless it is already at work
+    void wake_sync() {
+      std::lock_guard l(kv_lock);
+      if (!kv_sync_in_progress) {
+	kv_sync_in_progress = true;
+	kv_cond.notify_one();
+      }
+    }
+  };
+
 #ifdef HAVE_LIBZBD
   struct ZonedCleanerThread : public Thread {
     BlueStore *store;
@@ -2077,6 +2149,20 @@ private:
   std::vector<OnodeCacheShard*> onode_cache_shards;
   std::vector<BufferCacheShard*> buffer_cache_shards;
 
+  /// Onode::flush() waits for uncommitted txns here rather than on a
+  /// mutex and condvar of its own; the onodes sharing a stripe just
+  /// recheck their flushing_count on a spurious wakeup.
+  struct OnodeFlushStripe {
+    ceph::mutex lock = ceph::make_mutex("BlueStore::onode_flush_lock");
+    ceph::condition_variable cond;
+  };
+  static constexpr size_t ONODE_FLUSH_STRIPES = 64;
+  std::array<OnodeFlushStripe, ONODE_FLUSH_STRIPES> onode_flush_stripes;
+  OnodeFlushStripe& _get_onode_flush_stripe(const Onode *o) {
+    return onode_flush_stripes[
+      (reinterpret_cast<uintptr_t>(o) / alignof(Onode)) % ONODE_FLUSH_STRIPES];
+  }
+
   /// protect zombie_osr_set
   ceph::mutex zombie_osr_lock = ceph::make_mutex("BlueStore::zombie_osr_lock");
   uint32_t next_sequencer_id = 0;
@@ -2097,26 +2183,12 @@ private:
   Finisher  finisher;
   utime_t  deferred_last_submitted = utime_t();
 
-  KVSyncThread kv_sync_thread;
-  ceph::mutex kv_lock = ceph::make_mutex("BlueStore::kv_lock");
-  ceph::condition_variable kv_cond;
   bool _kv_only = false;
-  bool kv_sync_started = false;
-  bool kv_stop = false;
-  bool kv_finalize_started = false;
-  bool kv_finalize_stop = false;
-  std::deque<TransContext*> kv_queue;             ///< ready, already submitted
-  std::deque<TransContext*> kv_queue_unsubmitted; ///< ready, need submit by kv thread
-  std::deque<TransContext*> kv_committing;        ///< currently syncing
-  std::deque<DeferredBatch*> deferred_done_queue;   ///< deferred ios done
-  bool kv_sync_in_progress = false;
-
-  KVFinalizeThread kv_finalize_thread;
-  ceph::mutex kv_finalize_lock = ceph::make_mutex("BlueStore::kv_finalize_lock");
-  ceph::condition_variable kv_finalize_cond;
-  std::deque<TransContext*> kv_committing_to_finalize;   ///< pending finalization
-  std::deque<DeferredBatch*> deferred_stable_to_finalize; ///< pending finalization
-  bool kv_finalize_in_progress = false;
+  std::vector<std::unique_ptr<KVShard>> kv_shards; ///< set up by _kv_start
+  /// held by a kv shard from deciding to raise {nid,blobid}_max until the
+  /// commit carrying the new value is stable, so the shards take turns
+  /// and the persisted maxima never go backwards
+  ceph::mutex kv_max_lock = ceph::make_mutex("BlueStore::kv_max_lock");
 
 #ifdef HAVE_LIBZBD
   ZonedCleanerThread zoned_cleaner_thread;
@@ -2129,6 +2201,8 @@ private:
 
   PerfCounters *logger = nullptr;
 
+  /// protect removed_collections, queued and reaped by every kv shard
+  ceph::mutex reap_lock = ceph::make_mutex("BlueStore::reap_lock");
   std::list<CollectionRef> removed_collections;
 
   ceph::shared_mutex debug_read_error_lock =
@@ -2176,9 +2250,6 @@ private:
 
   std::atomic<uint64_t> max_blob_size = {0};  ///< maximum blob size
 
-  uint64_t kv_ios = 0;
-  uint64_t kv_throttle_costs = 0;
-
   // cache trim control
   uint64_t cache_size = 0;       ///< total cache size
   double cache_meta_ratio = 0;   ///< cache ratio dedicated to metadata
@@ -2490,8 +2561,11 @@ private:
 
   void _kv_start();
   void _kv_stop();
-  void _kv_sync_thread();
-  void _kv_finalize_thread();
+  void _kv_sync_thread(KVShard *shard);
+  void _kv_finalize_thread(KVShard *shard);
+  KVShard *_get_kv_shard(const OpSequencer *osr) {
+    return kv_shards[osr->get_sequencer_id() % kv_shards.size()].get();
+  }
 
 #ifdef HAVE_LIBZBD
   void _zoned_cleaner_start();
@@ -3469,6 +3543,9 @@ public:
     mempool::bluestore_fsck::list<std::string>* expecting_shards,
     std::map<BlobRef, bluestore_blob_t::unused_t>* referenced,
     const BlueStore::FSCK_ObjectCtx& ctx);
+  /// read (and so verify the checksums of) all of an object's data for
+  /// deep fsck; returns the errors found and adds the bytes read to *bytes
+  int64_t fsck_deep_read_object(Collection* c, OnodeRef& o, uint64_t* bytes);
 #ifdef CEPH_BLUESTORE_TOOL_RESTORE_ALLOCATION
   int  push_allocation_to_rocksdb();
   int  read_allocation_from_drive_for_bluestore_tool(bool test_store_and_restore);
@@ -10915,6 +10915,38 @@ void OSD::ShardedOpWQ::_add_slot_waiter(
   }
 }
 
+/// what the store sees an item's accesses as, for its cache accounting
+static ObjectStore::access_class_t get_access_class(const OpSchedulerItem& qi)
+{
+  using access_class_t = ObjectStore::access_class_t;
+  switch (qi.get_op_type()) {
+  case OpSchedulerItem::op_type_t::client_op:
+    // replicas serve recovery and scrub as ops from the primary
+    if (std::optional<OpRequestRef> op = qi.maybe_get_op()) {
+      switch ((*op)->get_req()->get_type()) {
+      case MSG_OSD_PG_PUSH:
+      case MSG_OSD_PG_PULL:
+      case MSG_OSD_PG_PUSH_REPLY:
+      case MSG_OSD_PG_SCAN:
+      case MSG_OSD_PG_BACKFILL:
+      case MSG_OSD_PG_BACKFILL_REMOVE:
+      case MSG_OSD_PG_RECOVERY_DELETE:
+	return access_class_t::RECOVERY;
+      case MSG_OSD_REP_SCRUB:
+      case MSG_OSD_REP_SCRUBMAP:
+	return access_class_t::SCRUB;
+      }
+    }
+    return access_class_t::CLIENT;
+  case OpSchedulerItem::op_type_t::bg_recovery:
+    return access_class_t::RECOVERY;
+  case OpSchedulerItem::op_type_t::bg_scrub:
+    return access_class_t::SCRUB;
+  default:
+    return access_class_t::OTHER;
+  }
+}
+
 #undef dout_prefix
 #define dout_prefix *_dout << "osd." << osd->whoami << " op_wq(" << shard_index << ") "
 
@@ -11235,7 +11267,10 @@ void OSD::ShardedOpWQ::_process(uint32_t thread_index, heartbeat_handle_d *hb)
   delete f;
   *_dout << dendl;
 
-  qi.run(osd, sdata, pg, tp_handle);
+  {
+    ObjectStore::AccessClassScope access_class(get_access_class(qi));
+    qi.run(osd, sdata, pg, tp_handle);
+  }
 
   {
 #ifdef WITH_LTTNG
@@ -465,6 +465,10 @@ public:
   // Synchronous setters
   // ===================
   void set_layout(file_layout_t const *l);
+  void set_prefetch_periods(uint64_t periods) {
+    lock_guard l(lock);
+    fetch_len = layout.get_period() * periods;
+  }
   void set_readonly();
   void set_writeable();
   void set_write_pos(uint64_t p) {
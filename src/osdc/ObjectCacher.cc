@@ -1082,7 +1082,7 @@ void ObjectCacher::bh_write_scattered(list<BufferHead*>& blist)
   ob->get();
 
   ceph::real_time last_write;
-  SnapContext snapc;
+  const SnapContext *snapc = &blist.front()->get_snapc();
   vector<pair<loff_t, uint64_t> > ranges;
   vector<pair<uint64_t, bufferlist> > io_vec;
 
@@ -1103,8 +1103,8 @@ void ObjectCacher::bh_write_scattered(list<BufferHead*>& blist)
     io_vec[n].second = bh->bl;
 
     total_len += bh->length();
-    if (bh->snapc.seq > snapc.seq)
-      snapc = bh->snapc;
+    if (bh->get_snapc().seq > snapc->seq)
+      snapc = &bh->get_snapc();
     if (bh->last_write > last_write)
       last_write = bh->last_write;
   }
@@ -1112,7 +1112,7 @@ void ObjectCacher::bh_write_scattered(list<BufferHead*>& blist)
   C_WriteCommit *oncommit = new C_WriteCommit(this, ob->oloc.pool, ob->get_soid(), ranges);
 
   ceph_tid_t tid = writeback_handler.write(ob->get_oid(), ob->get_oloc(),
-					   io_vec, snapc, last_write,
+					   io_vec, *snapc, last_write,
 					   ob->truncate_size, ob->truncate_seq,
 					   oncommit);
   oncommit->tid = tid;
@@ -1149,7 +1149,7 @@ void ObjectCacher::bh_write(BufferHead *bh, const ZTracer::Trace &parent_trace)
   ceph_tid_t tid = writeback_handler.write(bh->ob->get_oid(),
 					   bh->ob->get_oloc(),
 					   bh->start(), bh->length(),
-					   bh->snapc, bh->bl, bh->last_write,
+					   bh->get_snapc(), bh->bl, bh->last_write,
 					   bh->ob->truncate_size,
 					   bh->ob->truncate_seq,
 					   bh->journal_tid, trace, oncommit);
@@ -1736,6 +1736,17 @@ int ObjectCacher::writex(OSDWrite *wr, ObjectSet *oset, Context *onfreespace,
     trace.event("start");
   }
 
+  // successive writes almost always carry the same snap context; let
+  // their bhs share one copy of it
+  if (wr->snapc != last_snapc) {
+    if (last_snapc && wr->snapc &&
+	last_snapc->seq == wr->snapc->seq &&
+	last_snapc->snaps == wr->snapc->snaps)
+      wr->snapc = last_snapc;
+    else
+      last_snapc = wr->snapc;
+  }
+
   list<Context*> wait_for_reads;
   for (vector<ObjectExtent>::iterator ex_it = wr->extents.begin();
        ex_it != wr->extents.end();
@@ -76,12 +76,12 @@ class ObjectCacher {
   // write scatter/gather
   struct OSDWrite {
     std::vector<ObjectExtent> extents;
-    SnapContext snapc;
+    SnapContextRef snapc;
     ceph::buffer::list bl;
     ceph::real_time mtime;
     int fadvise_flags;
     ceph_tid_t journal_tid;
-    OSDWrite(const SnapContext& sc, const ceph::buffer::list& b, ceph::real_time mt,
+    OSDWrite(const SnapContextRef& sc, const ceph::buffer::list& b, ceph::real_time mt,
 	     int f, ceph_tid_t _journal_tid)
       : snapc(sc), bl(b), mtime(mt), fadvise_flags(f),
 	journal_tid(_journal_tid) {}
@@ -92,6 +92,14 @@ class ObjectCacher {
 			  ceph::real_time mt,
 			  int f,
 			  ceph_tid_t journal_tid) const {
+    return new OSDWrite(std::make_shared<const SnapContext>(sc), b, mt, f,
+			journal_tid);
+  }
+  OSDWrite *prepare_write(const SnapContextRef& sc,
+			  const ceph::buffer::list &b,
+			  ceph::real_time mt,
+			  int f,
+			  ceph_tid_t journal_tid) const {
     return new OSDWrite(sc, b, mt, f, journal_tid);
   }
 
@@ -125,7 +133,7 @@ class ObjectCacher {
     ceph_tid_t last_write_tid;  // version of bh (if non-zero)
     ceph_tid_t last_read_tid;   // tid of last read op (if any)
     ceph::real_time last_write;
-    SnapContext snapc;
+    SnapContextRef snapc;	// shared with other bhs written under it
     ceph_tid_t journal_tid;
     int error; // holds return value for failed reads
 
@@ -145,6 +153,11 @@ class ObjectCacher {
       ex.start = ex.length = 0;
     }
 
+    const SnapContext& get_snapc() const {
+      static const SnapContext none;
+      return snapc ? *snapc : none;
+    }
+
     // extent
     loff_t start() const { return ex.start; }
     void set_start(loff_t s) { ex.start = s; }
@@ -401,6 +414,8 @@ class ObjectCacher {
   std::string name;
   ceph::mutex& lock;
 
+  SnapContextRef last_snapc;  // most recent write's, for sharing
+
   uint64_t max_dirty, target_dirty, max_size, max_objects;
   ceph::timespan max_dirty_age;
   bool block_writes_upfront;
@@ -694,6 +709,12 @@ public:
   int file_write(ObjectSet *oset, file_layout_t *layout,
 		 const SnapContext& snapc, loff_t offset, uint64_t len,
 		 ceph::buffer::list& bl, ceph::real_time mtime, int flags) {
+    return file_write(oset, layout, std::make_shared<const SnapContext>(snapc),
+		      offset, len, bl, mtime, flags);
+  }
+  int file_write(ObjectSet *oset, file_layout_t *layout,
+		 const SnapContextRef& snapc, loff_t offset, uint64_t len,
+		 ceph::buffer::list& bl, ceph::real_time mtime, int flags) {
     OSDWrite *wr = prepare_write(snapc, bl, mtime, flags, 0);
     Striper::file_to_extents(cct, oset->ino, layout, offset, len,
 			     oset->truncate_size, wr->extents);
@@ -0,0 +1,117 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#include "client/ReadPattern.h"
+
+#include "gtest/gtest.h"
+
+static const uint64_t MB = 1 << 20;
+
+static ReadPattern make()
+{
+  ReadPattern rp;
+  rp.set_min_bytes(128 << 10);
+  rp.set_max_bytes(4 * MB);
+  rp.set_alignment(4 * MB);
+  return rp;
+}
+
+TEST(ClientReadPattern, Sequential)
+{
+  auto rp = make();
+  ASSERT_TRUE(rp.update(0, 64 << 10, 100 * MB).empty());
+  auto ra = rp.update(64 << 10, 64 << 10, 100 * MB);
+  ASSERT_EQ(1u, ra.size());
+  ASSERT_EQ(128u << 10, ra[0].first);
+  // the window is rounded to the next object boundary
+  ASSERT_EQ(4 * MB, ra[0].first + ra[0].second);
+  // nothing new until the stream gets near the end of the window
+  ASSERT_TRUE(rp.update(128 << 10, 64 << 10, 100 * MB).empty());
+  ASSERT_EQ(64u << 10, rp.consume(128 << 10, 64 << 10));
+}
+
+TEST(ClientReadPattern, Strided)
+{
+  auto rp = make();
+  const uint64_t rec = 4096, stride = 1 * MB;
+  ASSERT_TRUE(rp.update(0, rec, 100 * MB).empty());
+  ASSERT_TRUE(rp.update(stride, rec, 100 * MB).empty());
+  auto ra = rp.update(2 * stride, rec, 100 * MB);
+  ASSERT_FALSE(ra.empty());
+  for (size_t i = 0; i < ra.size(); i++) {
+    ASSERT_EQ((3 + i) * stride, ra[i].first);
+    ASSERT_EQ(rec, ra[i].second);
+  }
+  // the next read was prefetched, and only the records after the
+  // prefetched ones are requested
+  ASSERT_EQ(rec, rp.consume(3 * stride, rec));
+  auto ra2 = rp.update(3 * stride, rec, 100 * MB);
+  ASSERT_GT(ra2.size(), ra.size());
+  ASSERT_EQ(ra.back().first + stride, ra2[0].first);
+}
+
+TEST(ClientReadPattern, StrideChange)
+{
+  auto rp = make();
+  const uint64_t rec = 4096;
+  ASSERT_TRUE(rp.update(0, rec, 100 * MB).empty());
+  ASSERT_TRUE(rp.update(1 * MB, rec, 100 * MB).empty());
+  ASSERT_FALSE(rp.update(2 * MB, rec, 100 * MB).empty());
+
+  // the stride goes from 1M to 3M: the stream learns the new one as a
+  // new stream would, and prefetches on the new stride only
+  ASSERT_TRUE(rp.update(5 * MB, rec, 100 * MB).empty());
+  auto ra = rp.update(8 * MB, rec, 100 * MB);
+  ASSERT_FALSE(ra.empty());
+  for (size_t i = 0; i < ra.size(); i++) {
+    ASSERT_EQ((11 + 3 * i) * MB, ra[i].first);
+    ASSERT_EQ(rec, ra[i].second);
+  }
+}
+
+TEST(ClientReadPattern, Interleaved)
+{
+  auto rp = make();
+  const uint64_t len = 64 << 10;
+  const uint64_t a = 0, b = 50 * MB;
+  std::vector<ReadPattern::extent_t> ra_a, ra_b;
+  for (int i = 0; i < 3; i++) {
+    auto r1 = rp.update(a + i * len, len, 100 * MB);
+    ra_a.insert(ra_a.end(), r1.begin(), r1.end());
+    auto r2 = rp.update(b + i * len, len, 100 * MB);
+    ra_b.insert(ra_b.end(), r2.begin(), r2.end());
+  }
+  ASSERT_FALSE(ra_a.empty());
+  ASSERT_FALSE(ra_b.empty());
+  ASSERT_LT(ra_a[0].first, b);
+  ASSERT_GE(ra_b[0].first, b);
+}
+
+TEST(ClientReadPattern, Limit)
+{
+  auto rp = make();
+  rp.update(0, 4096, 10000);
+  auto ra = rp.update(4096, 4096, 10000);
+  ASSERT_EQ(1u, ra.size());
+  ASSERT_EQ(10000u, ra[0].first + ra[0].second);
+}
+
+TEST(ClientReadPattern, Waste)
+{
+  auto rp = make();
+  rp.update(0, 4096, 100 * MB);
+  auto ra = rp.update(4096, 4096, 100 * MB);
+  ASSERT_EQ(1u, ra.size());
+  ASSERT_EQ(4096u, rp.consume(8192, 4096));
+  ASSERT_EQ(ra[0].second - 4096, rp.reset());
+  ASSERT_EQ(0u, rp.reset());
+}
@@ -0,0 +1,149 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+/*
+ * Measures what the client's snap contexts cost against the number of
+ * snapshots over a file:
+ *
+ *  - per write: every buffered write used to copy the realm's SnapContext
+ *    into its OSDWrite and again into each BufferHead; now they share the
+ *    realm's immutable one;
+ *  - per rebuild: after a snap create or remove every realm under the one
+ *    that changed rebuilds its context, `depth` realms deep.
+ */
+
+#include <iostream>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "client/ClientSnapRealm.h"
+#include "common/ceph_argparse.h"
+#include "common/Clock.h"
+#include "global/global_context.h"
+#include "global/global_init.h"
+
+using namespace std;
+
+struct copied_bh_t {
+  SnapContext snapc;
+};
+struct shared_bh_t {
+  SnapContextRef snapc;
+};
+
+// the rebuild as it was: everything through a std::set
+static SnapContext set_build(const SnapRealm& r, const SnapContext *psnapc)
+{
+  set<snapid_t> snaps(r.prior_parent_snaps.begin(), r.prior_parent_snaps.end());
+  snapid_t seq = r.seq;
+  if (psnapc) {
+    for (auto s : psnapc->snaps)
+      if (s >= r.parent_since)
+	snaps.insert(s);
+    seq = max(seq, psnapc->seq);
+  }
+  snaps.insert(r.my_snaps.begin(), r.my_snaps.end());
+  SnapContext snapc;
+  snapc.seq = seq;
+  snapc.snaps.assign(snaps.rbegin(), snaps.rend());
+  return snapc;
+}
+
+void usage(const char *name) {
+  cout << name << " <snaps> [writes] [depth]\n"
+       << "\t snaps: the largest number of snapshots to try.\n"
+       << "\t writes: buffered writes per round, 100000 by default.\n"
+       << "\t depth: nested snap realms, 8 by default.\n";
+}
+
+int main(int argc, const char **argv)
+{
+  if (argc < 2) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  int num = atoi(argv[1]);
+  int writes = argc > 2 ? atoi(argv[2]) : 100000;
+  int depth = argc > 3 ? atoi(argv[3]) : 8;
+  if (num < 1 || writes < 1 || depth < 1) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  auto args = argv_to_vec(argc, argv);
+  auto cct = global_init(NULL, args, CEPH_ENTITY_TYPE_CLIENT,
+			 CODE_ENVIRONMENT_UTILITY,
+			 CINIT_FLAG_NO_DEFAULT_CONFIG_FILE);
+  common_init_finish(g_ceph_context);
+
+  for (int n = 1; ; n = min(n * 4, num)) {
+    // a chain of realms with the snaps spread over them, newest deepest
+    vector<unique_ptr<SnapRealm>> realms;
+    for (int d = 0; d < depth; d++) {
+      realms.push_back(make_unique<SnapRealm>(inodeno_t(0x1000 + d)));
+      SnapRealm *r = realms.back().get();
+      if (d) {
+	r->parent = realms[d - 1]->ino;
+	r->pparent = realms[d - 1].get();
+	r->pparent->pchildren.insert(r);
+      }
+      for (int s = d; s < n; s += depth)
+	r->my_snaps.push_back(snapid_t(s + 2));
+      r->seq = r->my_snaps.empty() ? snapid_t(1) : r->my_snaps.back();
+    }
+    SnapRealm *leaf = realms.back().get();
+
+    const int rounds = 100;
+    utime_t start = ceph_clock_now();
+    for (int i = 0; i < rounds; i++) {
+      SnapContext psnapc;
+      for (auto& r : realms)
+	psnapc = set_build(*r, r->pparent ? &psnapc : nullptr);
+    }
+    double set_us = (double)(ceph_clock_now() - start) * 1000000 / rounds;
+
+    start = ceph_clock_now();
+    for (int i = 0; i < rounds; i++) {
+      for (auto& r : realms)
+	r->invalidate_cache();
+      leaf->get_snap_context_ref();
+    }
+    double merge_us = (double)(ceph_clock_now() - start) * 1000000 / rounds;
+
+    const SnapContextRef& ref = leaf->get_snap_context_ref();
+    vector<copied_bh_t> copied(writes);
+    start = ceph_clock_now();
+    for (int i = 0; i < writes; i++) {
+      SnapContext wr = *ref;
+      copied[i].snapc = wr;
+    }
+    double copy_ns = (double)(ceph_clock_now() - start) * 1000000000 / writes;
+
+    vector<shared_bh_t> shared(writes);
+    start = ceph_clock_now();
+    for (int i = 0; i < writes; i++) {
+      SnapContextRef wr = ref;
+      shared[i].snapc = wr;
+    }
+    double share_ns = (double)(ceph_clock_now() - start) * 1000000000 / writes;
+
+    cout << n << " snaps: write " << copy_ns << " ns copied, "
+	 << share_ns << " ns shared; rebuild " << set_us << " us set, "
+	 << merge_us << " us merge" << std::endl;
+    if (n == num)
+      break;
+  }
+
+  return 0;
+}
@@ -0,0 +1,153 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+/*
+ * Measures buffered write throughput through a single libcephfs mount
+ * against the number of writer threads, each on its own file.
+ *
+ * A write copies the caller's buffer before it takes client_lock, so the
+ * copies of different threads overlap and large writes gain from more
+ * threads.  The rest of the write path still runs under client_lock, so
+ * small writes are not expected to scale: this shows how much the copy
+ * was costing, not per-file concurrency in the client.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "include/cephfs/libcephfs.h"
+
+using namespace std;
+
+static void usage(const char *name)
+{
+  cout << name << " <threads> <seconds> <io size> [file size]\n"
+       << "\t threads: the maximum number of threads to try, doubling from 1.\n"
+       << "\t seconds: how long to run at each thread count.\n"
+       << "\t io size: bytes per write call.\n"
+       << "\t file size: bytes per file, 4 MiB by default.\n";
+}
+
+static uint64_t run(struct ceph_mount_info *cmount, int nthreads,
+		    int seconds, size_t io_size, size_t file_size)
+{
+  atomic<bool> stop = false;
+  atomic<uint64_t> ops = 0;
+
+  // every thread creates its file before the clock starts
+  mutex lock;
+  condition_variable cond;
+  int ready = 0;
+  bool go = false;
+  auto wait_for_start = [&]() {
+    unique_lock l(lock);
+    if (++ready == nthreads)
+      cond.notify_all();
+    cond.wait(l, [&] { return go; });
+  };
+
+  vector<thread> workers;
+  for (int t = 0; t < nthreads; t++) {
+    workers.emplace_back([&, t]() {
+      string name = "bench_write_copy." + to_string(getpid()) + "." +
+	to_string(t);
+      int fd = ceph_open(cmount, name.c_str(), O_CREAT|O_RDWR, 0644);
+      if (fd < 0) {
+	cerr << "open " << name << ": " << strerror(-fd) << std::endl;
+	wait_for_start();
+	return;
+      }
+      vector<char> buf(io_size, 'a' + t % 26);
+      // allocate the whole file once
+      for (size_t off = 0; off < file_size; off += io_size)
+	ceph_write(cmount, fd, buf.data(), io_size, off);
+      wait_for_start();
+      uint64_t n = 0;
+      size_t off = 0;
+      while (!stop) {
+	int r = ceph_write(cmount, fd, buf.data(), io_size, off);
+	if (r < 0) {
+	  cerr << name << ": " << strerror(-r) << std::endl;
+	  break;
+	}
+	off += io_size;
+	if (off + io_size > file_size)
+	  off = 0;
+	n++;
+      }
+      ops += n;
+      ceph_close(cmount, fd);
+      ceph_unlink(cmount, name.c_str());
+    });
+  }
+  {
+    unique_lock l(lock);
+    cond.wait(l, [&] { return ready == nthreads; });
+    go = true;
+  }
+  cond.notify_all();
+  this_thread::sleep_for(chrono::seconds(seconds));
+  stop = true;
+  for (auto& w : workers)
+    w.join();
+  return ops;
+}
+
+int main(int argc, const char **argv)
+{
+  if (argc < 4) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  int threads = atoi(argv[1]);
+  int seconds = atoi(argv[2]);
+  size_t io_size = strtoull(argv[3], nullptr, 10);
+  size_t file_size = argc > 4 ? strtoull(argv[4], nullptr, 10) : (4 << 20);
+  if (threads < 1 || seconds < 1 || io_size == 0 || io_size > file_size) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  struct ceph_mount_info *cmount;
+  int r = ceph_create(&cmount, NULL);
+  if (r == 0)
+    r = ceph_conf_read_file(cmount, NULL);
+  if (r == 0)
+    r = ceph_conf_parse_env(cmount, NULL);
+  if (r == 0)
+    r = ceph_mount(cmount, "/");
+  if (r < 0) {
+    cerr << "mount failed: " << strerror(-r) << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  for (int t = 1; t <= threads; t *= 2) {
+    uint64_t ops = run(cmount, t, seconds, io_size, file_size);
+    double rate = (double)ops / seconds;
+    cout << t << " threads: " << rate << " ops/sec, "
+	 << rate * io_size / (1 << 20) << " MiB/sec" << std::endl;
+  }
+
+  ceph_shutdown(cmount);
+  return 0;
+}
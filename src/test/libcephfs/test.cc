@@ -36,6 +36,7 @@
 
 #include <fmt/format.h>
 #include <map>
+#include <set>
 #include <vector>
 #include <thread>
 #include <regex>
@@ -485,8 +486,6 @@ TEST(LibCephFS, DirLs) {
   }
   ASSERT_EQ(found, entries);
 
-  ASSERT_EQ(ceph_closedir(cmount, ls_dir), 0);
-
   // cleanup
   for(i = 0; i < r; ++i) {
     sprintf(bazstr, "dir_ls%d/dirf%d", mypid, i);
@@ -497,6 +496,136 @@ TEST(LibCephFS, DirLs) {
   ceph_shutdown(cmount);
 }
 
+TEST(LibCephFS, ReaddirplusMany) {
+  pid_t mypid = getpid();
+
+  struct ceph_mount_info *cmount;
+  ASSERT_EQ(ceph_create(&cmount, NULL), 0);
+  ASSERT_EQ(ceph_conf_read_file(cmount, NULL), 0);
+  ASSERT_EQ(0, ceph_conf_parse_env(cmount, NULL));
+  ASSERT_EQ(ceph_mount(cmount, "/"), 0);
+
+  char dir[256];
+  sprintf(dir, "readdirplus_many%d", mypid);
+  ASSERT_EQ(ceph_mkdir(cmount, dir, 0777), 0);
+
+  const int num = 100;
+  char path[256];
+  std::set<std::string> entries;
+  for (int i = 0; i < num; ++i) {
+    sprintf(path, "%s/dirf%d", dir, i);
+    int fd = ceph_open(cmount, path, O_CREAT|O_RDONLY, 0666);
+    ASSERT_GT(fd, 0);
+    ASSERT_EQ(ceph_close(cmount, fd), 0);
+    ASSERT_EQ(0, ceph_truncate(cmount, path, i));
+    entries.insert(path + strlen(dir) + 1);
+  }
+
+  struct ceph_dir_result *ls_dir = NULL;
+  ASSERT_EQ(ceph_opendir(cmount, dir, &ls_dir), 0);
+
+  // batches smaller than the directory, so that one call ends mid-frag
+  std::set<std::string> found;
+  struct dirent rdents[7];
+  struct ceph_statx stxs[7];
+  while (true) {
+    int n = ceph_readdirplus_many(cmount, ls_dir, rdents, stxs, 7,
+				  CEPH_STATX_SIZE, AT_NO_ATTR_SYNC);
+    if (n == 0)
+      break;
+    ASSERT_GT(n, 0);
+    ASSERT_LE(n, 7);
+    for (int j = 0; j < n; ++j) {
+      const char *name = rdents[j].d_name;
+      if (!strcmp(name, ".") || !strcmp(name, ".."))
+	continue;
+      ASSERT_TRUE(found.insert(name).second);
+      int size;
+      sscanf(name, "dirf%d", &size);
+      ASSERT_TRUE(stxs[j].stx_mask & CEPH_STATX_SIZE);
+      ASSERT_EQ(stxs[j].stx_size, (size_t)size);
+      ASSERT_EQ(stxs[j].stx_ino, rdents[j].d_ino);
+    }
+  }
+  ASSERT_EQ(found, entries);
+
+  ASSERT_EQ(ceph_closedir(cmount, ls_dir), 0);
+
+  for (int i = 0; i < num; ++i) {
+    sprintf(path, "%s/dirf%d", dir, i);
+    ASSERT_EQ(0, ceph_unlink(cmount, path));
+  }
+  ASSERT_EQ(0, ceph_rmdir(cmount, dir));
+  ceph_shutdown(cmount);
+}
+
+TEST(LibCephFS, StatxMany) {
+  pid_t mypid = getpid();
+
+  struct ceph_mount_info *cmount;
+  ASSERT_EQ(ceph_create(&cmount, NULL), 0);
+  ASSERT_EQ(ceph_conf_read_file(cmount, NULL), 0);
+  ASSERT_EQ(0, ceph_conf_parse_env(cmount, NULL));
+  ASSERT_EQ(ceph_mount(cmount, "/"), 0);
+
+  char dir[256];
+  sprintf(dir, "statx_many%d", mypid);
+  ASSERT_EQ(ceph_mkdir(cmount, dir, 0777), 0);
+
+  const int num = 100;
+  char path[256];
+  std::vector<std::string> names;
+  for (int i = 0; i < num; ++i) {
+    sprintf(path, "%s/dirf%d", dir, i);
+    int fd = ceph_open(cmount, path, O_CREAT|O_RDONLY, 0666);
+    ASSERT_GT(fd, 0);
+    ASSERT_EQ(ceph_close(cmount, fd), 0);
+    ASSERT_EQ(0, ceph_truncate(cmount, path, i));
+    names.push_back(path + strlen(dir) + 1);
+  }
+  names.push_back("nonexistent");
+  std::vector<const char *> cnames;
+  for (auto& n : names)
+    cnames.push_back(n.c_str());
+
+  // from a fresh mount, so nothing is cached and the directory is read
+  struct ceph_mount_info *cmount2;
+  ASSERT_EQ(ceph_create(&cmount2, NULL), 0);
+  ASSERT_EQ(ceph_conf_read_file(cmount2, NULL), 0);
+  ASSERT_EQ(0, ceph_conf_parse_env(cmount2, NULL));
+  ASSERT_EQ(ceph_mount(cmount2, "/"), 0);
+
+  // the second pass is answered from the cache the first one filled,
+  // including the name that does not exist
+  for (int pass = 0; pass < 2; ++pass) {
+    std::vector<struct ceph_statx> stxs(names.size());
+    std::vector<int> rets(names.size());
+    ASSERT_EQ(0, ceph_statx_many(cmount2, dir, cnames.data(), cnames.size(),
+				 stxs.data(), rets.data(), CEPH_STATX_SIZE, 0));
+    for (int i = 0; i < num; ++i) {
+      ASSERT_EQ(0, rets[i]);
+      ASSERT_EQ(stxs[i].stx_size, (size_t)i);
+    }
+    ASSERT_EQ(-ENOENT, rets.back());
+  }
+
+  {
+    std::vector<struct ceph_statx> stxs(1);
+    std::vector<int> rets(1);
+    std::string file = std::string(dir) + "/" + names[0];
+    ASSERT_EQ(-ENOTDIR, ceph_statx_many(cmount2, file.c_str(), cnames.data(), 1,
+					stxs.data(), rets.data(), CEPH_STATX_SIZE, 0));
+  }
+  ceph_shutdown(cmount2);
+
+  for (int i = 0; i < num; ++i) {
+    sprintf(path, "%s/dirf%d", dir, i);
+    ASSERT_EQ(0, ceph_unlink(cmount, path));
+  }
+  ASSERT_EQ(0, ceph_rmdir(cmount, dir));
+  ceph_shutdown(cmount);
+}
+
 TEST(LibCephFS, ManyNestedDirs) {
   struct ceph_mount_info *cmount;
   ASSERT_EQ(ceph_create(&cmount, NULL), 0);
@@ -3571,3 +3700,47 @@ TEST(LibCephFS, SetMountTimeout) {
 
   ceph_shutdown(cmount);
 }
+
+TEST(LibCephFS, AsyncCreate) {
+  struct ceph_mount_info *cmount;
+  ASSERT_EQ(ceph_create(&cmount, NULL), 0);
+  ASSERT_EQ(ceph_conf_read_file(cmount, NULL), 0);
+  ASSERT_EQ(0, ceph_conf_parse_env(cmount, NULL));
+  ASSERT_EQ(ceph_conf_set(cmount, "client_async_create", "true"), 0);
+  ASSERT_EQ(ceph_mount(cmount, NULL), 0);
+
+  char dir[256];
+  sprintf(dir, "/async_create_%d", getpid());
+  ASSERT_EQ(ceph_mkdir(cmount, dir, 0755), 0);
+
+  // the first creates are synchronous, the rest may not be
+  const int num = 100;
+  char path[300];
+  for (int i = 0; i < num; i++) {
+    sprintf(path, "%s/file%d", dir, i);
+    int fd = ceph_open(cmount, path, O_CREAT|O_EXCL|O_WRONLY, 0644);
+    ASSERT_LE(0, fd);
+    ASSERT_EQ(4, ceph_write(cmount, fd, "data", 4, 0));
+    if (i % 10 == 0)
+      ASSERT_EQ(0, ceph_fchmod(cmount, fd, 0600));
+    ASSERT_EQ(0, ceph_close(cmount, fd));
+  }
+  ceph_shutdown(cmount);
+
+  // everything reached the mds
+  ASSERT_EQ(ceph_create(&cmount, NULL), 0);
+  ASSERT_EQ(ceph_conf_read_file(cmount, NULL), 0);
+  ASSERT_EQ(0, ceph_conf_parse_env(cmount, NULL));
+  ASSERT_EQ(ceph_mount(cmount, NULL), 0);
+  for (int i = 0; i < num; i++) {
+    struct ceph_statx stx;
+    sprintf(path, "%s/file%d", dir, i);
+    ASSERT_EQ(0, ceph_statx(cmount, path, &stx,
+			    CEPH_STATX_SIZE|CEPH_STATX_MODE, 0));
+    ASSERT_EQ(4u, stx.stx_size);
+    ASSERT_EQ(i % 10 == 0 ? 0600u : 0644u, stx.stx_mode & 0777);
+    ASSERT_EQ(0, ceph_unlink(cmount, path));
+  }
+  ASSERT_EQ(0, ceph_rmdir(cmount, dir));
+  ceph_shutdown(cmount);
+}
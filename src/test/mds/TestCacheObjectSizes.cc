@@ -0,0 +1,37 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#include "mds/CDentry.h"
+#include "mds/CInode.h"
+
+#include "gtest/gtest.h"
+
+// Every cached inode and dentry pays for these, so growing them shrinks
+// what fits in mds_cache_memory_limit.  The bounds are the sizes on
+// x86_64 with libstdc++; raise them deliberately, not by accident.
+TEST(MDSCacheObjectSizes, InodeAndDentry)
+{
+#if defined(__x86_64__) && defined(__GLIBCXX__) && !defined(_GLIBCXX_DEBUG)
+  EXPECT_LE(sizeof(CInode), 1136u);
+  EXPECT_LE(sizeof(CDentry), 440u);
+#else
+  GTEST_SKIP() << "sizes are only tracked for x86_64 with libstdc++";
+#endif
+}
+
+TEST(MDSCacheObjectSizes, EmptyCompactContainers)
+{
+  // rarely populated per-inode/dentry containers cost a pointer while empty
+  EXPECT_EQ(sizeof(void*), sizeof(mempool::mds_co::compact_set<client_t>));
+  EXPECT_EQ(sizeof(void*),
+	    (sizeof(mempool::mds_co::compact_map<int32_t, int32_t>)));
+}
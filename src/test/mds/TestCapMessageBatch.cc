@@ -0,0 +1,72 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#include "mds/CapMessageBatch.h"
+
+#include "gtest/gtest.h"
+
+static ref_t<MClientCaps> cap_msg(int op, uint64_t cap_id, ceph_seq_t seq,
+				  int caps)
+{
+  return make_message<MClientCaps>(op, inodeno_t(0x10000000000 + cap_id),
+				   inodeno_t(1), cap_id, seq, caps, 0, 0, 0, 0);
+}
+
+TEST(MDSCapMessageBatch, IssueRevokeSameCap)
+{
+  CapMessageBatch batch;
+  ASSERT_FALSE(batch.add(cap_msg(CEPH_CAP_OP_GRANT, 1, 1, CEPH_CAP_FILE_RD)));
+  ASSERT_TRUE(batch.add(cap_msg(CEPH_CAP_OP_REVOKE, 1, 2, 0)));
+  ASSERT_TRUE(batch.add(cap_msg(CEPH_CAP_OP_GRANT, 1, 3, CEPH_CAP_FILE_RD)));
+  ASSERT_TRUE(batch.add(cap_msg(CEPH_CAP_OP_REVOKE, 1, 4, CEPH_CAP_FILE_SHARED)));
+  ASSERT_TRUE(batch.add(cap_msg(CEPH_CAP_OP_GRANT, 1, 5,
+				CEPH_CAP_FILE_SHARED | CEPH_CAP_FILE_RD)));
+
+  // one message with the final seq and caps, still a revoke so the
+  // client acks it, and its ack confirms every earlier revoke
+  auto msgs = batch.take();
+  ASSERT_EQ(1u, msgs.size());
+  EXPECT_EQ(CEPH_CAP_OP_REVOKE, msgs[0]->get_op());
+  EXPECT_EQ(5u, msgs[0]->get_seq());
+  EXPECT_EQ(CEPH_CAP_FILE_SHARED | CEPH_CAP_FILE_RD, msgs[0]->get_caps());
+
+  ASSERT_TRUE(batch.take().empty());
+}
+
+TEST(MDSCapMessageBatch, GrantsStayGrants)
+{
+  CapMessageBatch batch;
+  batch.add(cap_msg(CEPH_CAP_OP_GRANT, 1, 1, CEPH_CAP_FILE_RD));
+  batch.add(cap_msg(CEPH_CAP_OP_GRANT, 1, 2, CEPH_CAP_FILE_SHARED));
+  auto msgs = batch.take();
+  ASSERT_EQ(1u, msgs.size());
+  EXPECT_EQ(CEPH_CAP_OP_GRANT, msgs[0]->get_op());
+  EXPECT_EQ(2u, msgs[0]->get_seq());
+}
+
+TEST(MDSCapMessageBatch, SendOrder)
+{
+  CapMessageBatch batch;
+  batch.add(cap_msg(CEPH_CAP_OP_GRANT, 1, 1, CEPH_CAP_FILE_RD));
+  batch.add(cap_msg(CEPH_CAP_OP_REVOKE, 2, 1, 0));
+  batch.add(cap_msg(CEPH_CAP_OP_GRANT, 3, 1, CEPH_CAP_FILE_RD));
+  batch.add(cap_msg(CEPH_CAP_OP_GRANT, 1, 2, CEPH_CAP_FILE_SHARED));
+
+  // a cap issued again moves behind the messages queued in between
+  auto msgs = batch.take();
+  ASSERT_EQ(3u, msgs.size());
+  EXPECT_EQ(2u, msgs[0]->get_cap_id());
+  EXPECT_EQ(CEPH_CAP_OP_REVOKE, msgs[0]->get_op());
+  EXPECT_EQ(3u, msgs[1]->get_cap_id());
+  EXPECT_EQ(1u, msgs[2]->get_cap_id());
+  EXPECT_EQ(2u, msgs[2]->get_seq());
+}
@@ -0,0 +1,105 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#include "mds/ExportThrottle.h"
+
+#include "gtest/gtest.h"
+
+static export_cost_t cost(uint64_t size, uint64_t inodes)
+{
+  export_cost_t c;
+  c.size = size;
+  c.inodes = inodes;
+  return c;
+}
+
+// an export that is still taking locks holds back the queue on its estimate
+TEST(MDSExportThrottle, LockingExportIsCharged)
+{
+  ExportThrottle t;
+  t.set_max_size(1000);
+  t.set_max_inodes(100);
+  ASSERT_TRUE(t.may_start());
+
+  export_cost_t locking;
+  t.charge(locking, cost(10, 150));
+  ASSERT_EQ(150u, t.get_inodes());
+  ASSERT_FALSE(t.may_start());
+
+  t.release(locking);
+  ASSERT_EQ(0u, t.get_inodes());
+  ASSERT_EQ(0u, t.get_size());
+  ASSERT_TRUE(t.may_start());
+}
+
+TEST(MDSExportThrottle, Size)
+{
+  ExportThrottle t;
+  t.set_max_size(1000);
+
+  export_cost_t a, b;
+  t.charge(a, cost(600, 1));
+  ASSERT_TRUE(t.may_start());
+  t.charge(b, cost(401, 1));
+  ASSERT_FALSE(t.may_start());
+  t.release(a);
+  ASSERT_TRUE(t.may_start());
+
+  // no inode limit by default
+  t.charge(a, cost(0, 1000000));
+  ASSERT_TRUE(t.may_start());
+}
+
+// the estimate taken at start is replaced, not added to, once the export
+// is sized again before freezing
+TEST(MDSExportThrottle, Recharge)
+{
+  ExportThrottle t;
+  t.set_max_size(1000);
+  t.set_max_inodes(100);
+
+  export_cost_t held;
+  t.charge(held, cost(500, 80));
+  t.charge(held, cost(200, 30));
+  ASSERT_EQ(200u, t.get_size());
+  ASSERT_EQ(30u, t.get_inodes());
+  ASSERT_EQ(30u, held.inodes);
+
+  t.charge(held, cost(300, 120));
+  ASSERT_EQ(120u, t.get_inodes());
+  ASSERT_FALSE(t.may_start());
+}
+
+// a subtree split into smaller exports: the parts are charged as they
+// start, then the original export is cancelled
+TEST(MDSExportThrottle, Split)
+{
+  ExportThrottle t;
+  t.set_max_size(1000);
+  t.set_max_inodes(100);
+
+  export_cost_t whole, part1, part2;
+  t.charge(whole, cost(1500, 90));
+  ASSERT_FALSE(t.may_start());
+  t.charge(part1, cost(700, 40));
+  t.charge(part2, cost(700, 45));
+  t.release(whole);
+  ASSERT_EQ(1400u, t.get_size());
+  ASSERT_EQ(85u, t.get_inodes());
+  ASSERT_FALSE(t.may_start());
+
+  t.release(part1);
+  ASSERT_TRUE(t.may_start());
+  t.release(part2);
+  ASSERT_EQ(0u, t.get_size());
+  ASSERT_EQ(0u, t.get_inodes());
+}
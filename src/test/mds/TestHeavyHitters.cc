@@ -0,0 +1,96 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#include <random>
+
+#include "mds/HeavyHitters.h"
+
+#include "gtest/gtest.h"
+
+TEST(MDSHeavyHitters, Exact)
+{
+  SpaceSaving<int> ss(4);
+  for (int i = 0; i < 4; i++)
+    for (int j = 0; j <= i; j++)
+      ss.hit(i);
+  auto top = ss.top(10);
+  ASSERT_EQ(4u, top.size());
+  for (int i = 0; i < 4; i++) {
+    ASSERT_EQ(3 - i, top[i].first);
+    ASSERT_DOUBLE_EQ(4 - i, top[i].second.count);
+    ASSERT_DOUBLE_EQ(0.0, top[i].second.error);
+  }
+}
+
+TEST(MDSHeavyHitters, Evict)
+{
+  SpaceSaving<int> ss(2);
+  ss.hit(1, 10);
+  ss.hit(2, 3);
+  ss.hit(3);
+  SpaceSaving<int>::entry_t e;
+  ASSERT_FALSE(ss.get(2, &e));
+  ASSERT_TRUE(ss.get(3, &e));
+  ASSERT_DOUBLE_EQ(4.0, e.count);
+  ASSERT_DOUBLE_EQ(3.0, e.error);
+  ASSERT_TRUE(ss.get(1, &e));
+  ASSERT_DOUBLE_EQ(10.0, e.count);
+  ASSERT_EQ(2u, ss.size());
+}
+
+TEST(MDSHeavyHitters, Skewed)
+{
+  // 8 heavy keys take half the traffic, the rest is spread over 10000
+  SpaceSaving<int> ss(32);
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> cold(100, 10099);
+  std::uniform_int_distribution<int> heavy(0, 7);
+  for (int i = 0; i < 200000; i++)
+    ss.hit(i % 2 ? heavy(rng) : cold(rng));
+  auto top = ss.top(8);
+  ASSERT_EQ(8u, top.size());
+  for (auto& [k, e] : top) {
+    ASSERT_LT(k, 8);
+    ASSERT_LE(e.count - e.error, 100000.0 / 8 * 1.1);
+  }
+}
+
+TEST(MDSHeavyHitters, Decay)
+{
+  SpaceSaving<int> ss(2);
+  ss.hit(1, 8);
+  ss.hit(2, 4);
+  ss.decay(0.5);
+  SpaceSaving<int>::entry_t e;
+  ASSERT_TRUE(ss.get(1, &e));
+  ASSERT_DOUBLE_EQ(4.0, e.count);
+  // old weight fades, so a new burst takes over the top spot
+  ss.hit(2, 3);
+  ASSERT_EQ(2, ss.top(1)[0].first);
+  ss.hit(3);
+  ASSERT_FALSE(ss.get(1, &e));
+  ASSERT_TRUE(ss.get(3, &e));
+  ASSERT_DOUBLE_EQ(4.0, e.error);
+}
+
+TEST(MDSHeavyHitters, Shrink)
+{
+  SpaceSaving<int> ss(8);
+  for (int i = 0; i < 8; i++)
+    ss.hit(i, i + 1);
+  ss.set_capacity(3);
+  ASSERT_EQ(3u, ss.size());
+  auto top = ss.top(8);
+  ASSERT_EQ(3u, top.size());
+  ASSERT_EQ(7, top[0].first);
+  ASSERT_EQ(5, top[2].first);
+}
@@ -0,0 +1,82 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#include "include/cephfs/metrics/LatencyHistogram.h"
+
+#include "gtest/gtest.h"
+
+TEST(LatencyHistogram, Buckets)
+{
+  // buckets are contiguous, and each one holds what it claims to
+  for (unsigned b = 0; b + 1 < LatencyHistogram::MAX_BUCKETS; b++) {
+    ASSERT_EQ(LatencyHistogram::bucket_upper(b), LatencyHistogram::bucket_lower(b + 1));
+    ASSERT_EQ(b, LatencyHistogram::bucket_of(LatencyHistogram::bucket_lower(b)));
+    ASSERT_EQ(b, LatencyHistogram::bucket_of(LatencyHistogram::bucket_upper(b) - 1));
+  }
+  ASSERT_EQ(LatencyHistogram::MAX_BUCKETS - 1, LatencyHistogram::bucket_of(~0ull));
+}
+
+TEST(LatencyHistogram, Quantile)
+{
+  LatencyHistogram h;
+  ASSERT_EQ(0u, h.quantile(0.99));
+  for (uint64_t us = 1; us <= 1000; us++)
+    h.add(us);
+  ASSERT_EQ(1000u, h.count());
+  ASSERT_EQ(500u, h.mean());
+
+  // within a bucket width (a quarter) of the truth, and never below it
+  for (double q : {0.5, 0.9, 0.99, 0.999}) {
+    uint64_t truth = q * 1000;
+    uint64_t got = h.quantile(q);
+    ASSERT_GE(got, truth);
+    ASSERT_LE(got, truth + truth / 4 + 1);
+  }
+}
+
+TEST(LatencyHistogram, MergeAndDecay)
+{
+  LatencyHistogram a, b;
+  for (int i = 0; i < 990; i++)
+    a.add(100);
+  for (int i = 0; i < 10; i++)
+    b.add(100000);
+  a.merge(b);
+  ASSERT_EQ(1000u, a.count());
+  ASSERT_LE(a.quantile(0.9), 128u);
+  ASSERT_GE(a.quantile(0.999), 100000u);
+
+  a.decay();
+  ASSERT_EQ(500u, a.count());
+  for (int i = 0; i < 10; i++)
+    a.decay();
+  ASSERT_TRUE(a.empty());
+}
+
+TEST(LatencyHistogram, Encode)
+{
+  LatencyHistograms h;
+  h.read.add(3);
+  h.read.add(5000);
+  h.metadata.add(utime_t(1, 500000000));
+
+  bufferlist bl;
+  encode(h, bl);
+  auto p = bl.cbegin();
+  LatencyHistograms d;
+  decode(d, p);
+  ASSERT_EQ(2u, d.read.count());
+  ASSERT_EQ(h.read.quantile(0.5), d.read.quantile(0.5));
+  ASSERT_EQ(h.read.quantile(1.0), d.read.quantile(1.0));
+  ASSERT_TRUE(d.write.empty());
+  ASSERT_EQ(1500000u, d.metadata.mean());
+}
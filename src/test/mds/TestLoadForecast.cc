@@ -0,0 +1,69 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#include "mds/LoadForecast.h"
+
+#include "gtest/gtest.h"
+
+TEST(MDSLoadForecast, Constant)
+{
+  LoadForecast fc;
+  for (int e = 1; e <= 10; e++)
+    fc.sample(e, 100.0, 0.5, 0.3, 4);
+  ASSERT_DOUBLE_EQ(100.0, fc.get_level());
+  ASSERT_DOUBLE_EQ(0.0, fc.get_trend());
+  ASSERT_DOUBLE_EQ(100.0, fc.predict(5));
+  ASSERT_EQ(10u, fc.get_num_samples());
+  ASSERT_EQ(10, fc.get_last_epoch());
+}
+
+TEST(MDSLoadForecast, Trend)
+{
+  LoadForecast rising, fading;
+  for (int e = 1; e <= 10; e++) {
+    rising.sample(e, 10.0 * e, 0.5, 0.3, 4);
+    fading.sample(e, 200.0 - 10.0 * e, 0.5, 0.3, 4);
+  }
+  ASSERT_GT(rising.get_trend(), 0.0);
+  ASSERT_GT(rising.predict(2), rising.get_level());
+  ASSERT_LT(fading.get_trend(), 0.0);
+  ASSERT_LT(fading.predict(2), fading.get_level());
+  // forecasts never go negative
+  ASSERT_EQ(0.0, fading.predict(1000));
+}
+
+TEST(MDSLoadForecast, SameEpoch)
+{
+  LoadForecast fc;
+  fc.sample(1, 10.0, 1.0, 1.0, 4);
+  fc.sample(2, 20.0, 1.0, 1.0, 4);
+  double trend = fc.get_trend();
+  // resampling an epoch must not compound the trend
+  fc.sample(2, 20.0, 1.0, 1.0, 4);
+  ASSERT_DOUBLE_EQ(trend, fc.get_trend());
+  ASSERT_DOUBLE_EQ(20.0, fc.get_last_sample());
+}
+
+TEST(MDSLoadForecast, SameEpochReplaces)
+{
+  LoadForecast once, twice;
+  for (int e = 1; e <= 3; e++) {
+    once.sample(e, 10.0 * e, 0.5, 0.5, 4);
+    twice.sample(e, 10.0 * e, 0.5, 0.5, 4);
+  }
+  // the epoch's earlier observation is replaced, not blended in again
+  twice.sample(4, 100.0, 0.5, 0.5, 4);
+  twice.sample(4, 40.0, 0.5, 0.5, 4);
+  once.sample(4, 40.0, 0.5, 0.5, 4);
+  ASSERT_DOUBLE_EQ(once.get_level(), twice.get_level());
+  ASSERT_DOUBLE_EQ(once.get_trend(), twice.get_trend());
+}
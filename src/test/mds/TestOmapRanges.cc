@@ -0,0 +1,221 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#include <map>
+#include <random>
+#include <string>
+
+#include "mds/OmapRanges.h"
+
+#include "gtest/gtest.h"
+
+using keys_t = std::map<std::string, int>;
+
+// omap_get_vals(start_after, max)
+static keys_t read_after(const keys_t& omap, const std::string& start_after,
+			 size_t max, bool *more)
+{
+  keys_t r;
+  auto p = omap.upper_bound(start_after);
+  for (; p != omap.end() && r.size() < max; ++p)
+    r.insert(*p);
+  *more = (p != omap.end());
+  return r;
+}
+
+struct fetch_result_t {
+  std::vector<size_t> first_ranges; ///< keys read by the initial ranges
+  std::map<std::string, int> times; ///< how often each key was read
+  unsigned rounds = 0;              ///< parallel round trips
+};
+
+// read omap the way CDir::_omap_fetch_more() does, one round of
+// concurrent reads at a time, the open-ended range splitting again
+// whenever it finds reads idle
+static fetch_result_t fetch(const keys_t& omap, size_t per_op, unsigned max_ranges)
+{
+  struct range_t {
+    std::string start_after, end;
+    size_t initial;
+  };
+  fetch_result_t res;
+  bool more;
+  keys_t batch = read_after(omap, "", per_op, &more);
+  res.rounds++;
+  for (auto& p : batch)
+    res.times[p.first]++;
+  if (!more)
+    return res;
+
+  size_t got = batch.size();
+  std::vector<range_t> active;
+  auto split_tail = [&](const keys_t& b, unsigned ranges, size_t initial) {
+    uint64_t remaining = omap.size() > got ? omap.size() - got : 0;
+    auto splits = omap_split_points(b, remaining, ranges);
+    std::string start_after = b.rbegin()->first;
+    for (auto& s : splits) {
+      active.push_back({start_after, s, initial});
+      start_after = s;
+    }
+    active.push_back({start_after, "", initial});
+  };
+  split_tail(batch, max_ranges, 0);
+  res.first_ranges.resize(active.size());
+  for (size_t i = 0; i < active.size(); i++)
+    active[i].initial = i;
+
+  while (!active.empty()) {
+    res.rounds++;
+    auto round = std::move(active);
+    active.clear();
+    for (auto& r : round) {
+      keys_t b = read_after(omap, r.start_after, per_op, &more);
+      bool done;
+      auto stop = omap_range_clip(b, more, r.end, &done);
+      for (auto p = b.begin(); p != stop; ++p) {
+	res.times[p->first]++;
+	res.first_ranges[r.initial]++;
+	got++;
+      }
+      if (done)
+	continue;
+      if (r.end.empty()) {
+	unsigned busy = active.size() + (&round.back() - &r);
+	split_tail(b, max_ranges > busy ? max_ranges - busy : 1, r.initial);
+      } else {
+	active.push_back({std::prev(stop)->first, r.end, r.initial});
+      }
+    }
+  }
+  return res;
+}
+
+static void check_each_key_read_once(const keys_t& omap, const fetch_result_t& res)
+{
+  ASSERT_EQ(omap.size(), res.times.size());
+  for (auto& p : omap) {
+    auto q = res.times.find(p.first);
+    ASSERT_NE(q, res.times.end()) << p.first << " was not read";
+    ASSERT_EQ(1, q->second) << p.first;
+  }
+}
+
+// the initial ranges share the keys out evenly enough to be worth it
+static void check_fan_out(const keys_t& omap, size_t per_op,
+			  const fetch_result_t& res, unsigned ranges)
+{
+  ASSERT_EQ(ranges, res.first_ranges.size());
+  size_t remaining = omap.size() - per_op;
+  for (size_t n : res.first_ranges) {
+    ASSERT_GE(n, remaining / ranges / 3);
+    ASSERT_LE(n, remaining / 2);
+  }
+  size_t sequential = (omap.size() + per_op - 1) / per_op;
+  ASSERT_LT(res.rounds, sequential / 2);
+}
+
+TEST(MDSOmapRanges, CommonPrefix)
+{
+  keys_t omap;
+  char buf[64];
+  for (int i = 0; i < 100000; i++) {
+    snprintf(buf, sizeof(buf), "file%07d_head", i);
+    omap[buf] = 0;
+  }
+  auto res = fetch(omap, 1000, 4);
+  check_each_key_read_once(omap, res);
+  check_fan_out(omap, 1000, res, 4);
+}
+
+TEST(MDSOmapRanges, NonAscii)
+{
+  keys_t omap;
+  char buf[64];
+  for (int i = 0; i < 100000; i++) {
+    snprintf(buf, sizeof(buf), "\xc3\xa9t\xc3\xa9_%06d_head", i);
+    omap[buf] = 0;
+  }
+  auto res = fetch(omap, 1000, 8);
+  check_each_key_read_once(omap, res);
+  check_fan_out(omap, 1000, res, 8);
+}
+
+TEST(MDSOmapRanges, Random)
+{
+  keys_t omap;
+  std::mt19937 rng(42);
+  while (omap.size() < 100000) {
+    std::string name;
+    for (int j = 0; j < 12; j++)
+      name.push_back('a' + rng() % 26);
+    omap[name + "_head"] = 0;
+  }
+  auto res = fetch(omap, 1000, 4);
+  check_each_key_read_once(omap, res);
+  check_fan_out(omap, 1000, res, 4);
+}
+
+TEST(MDSOmapRanges, SplitOnKey)
+{
+  keys_t omap;
+  char buf[64];
+  for (int i = 0; i < 20000; i++) {
+    snprintf(buf, sizeof(buf), "f%05d_head", i);
+    omap[buf] = 0;
+  }
+  bool more;
+  keys_t batch = read_after(omap, "", 100, &more);
+  auto splits = omap_split_points(batch, omap.size() - batch.size(), 4);
+  ASSERT_EQ(3u, splits.size());
+  ASSERT_GT(splits[0], batch.rbegin()->first);
+
+  // keys right on, just before and just after every split point
+  for (auto& s : splits) {
+    omap[s] = 0;
+    omap[s + '\0'] = 0;
+    std::string before = s;
+    before.back()--;
+    omap[before] = 0;
+  }
+  std::string start_after = batch.rbegin()->first;
+  std::map<std::string, int> times;
+  for (auto& p : batch)
+    times[p.first]++;
+  for (size_t i = 0; i <= splits.size(); i++) {
+    std::string end = i < splits.size() ? splits[i] : "";
+    while (true) {
+      keys_t b = read_after(omap, start_after, 100, &more);
+      bool done;
+      auto stop = omap_range_clip(b, more, end, &done);
+      for (auto p = b.begin(); p != stop; ++p)
+	times[p->first]++;
+      if (done)
+	break;
+      start_after = std::prev(stop)->first;
+    }
+    start_after = end;
+  }
+  ASSERT_EQ(omap.size(), times.size());
+  for (auto& p : times)
+    ASSERT_EQ(1, p.second) << p.first;
+}
+
+TEST(MDSOmapRanges, NothingLeft)
+{
+  keys_t batch;
+  batch["a_head"] = 0;
+  batch["b_head"] = 0;
+  ASSERT_TRUE(omap_split_points(batch, 0, 4).empty());
+  ASSERT_TRUE(omap_split_points(batch, 1000, 1).empty());
+  batch.erase("b_head");
+  ASSERT_TRUE(omap_split_points(batch, 1000, 4).empty());
+}
@@ -0,0 +1,154 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#include <map>
+#include <vector>
+
+#include "mds/PurgeLanes.h"
+
+#include "gtest/gtest.h"
+
+using namespace std::chrono_literals;
+
+static const int64_t SLOW = 1, FAST = 2;
+
+// pool SLOW is saturated: its share is used up and nothing completes
+TEST(MDSPurgeLanes, SaturatedPoolDoesNotBlockOthers)
+{
+  PurgeLanes lanes;
+  lanes.set_op_limit(100);
+  lanes.set_pool_limit(SLOW, 4);
+  lanes.set_pool_limit(FAST, 4);
+
+  uint64_t key = 0;
+  std::map<uint64_t, uint64_t> ops;
+  for (int i = 0; i < 2; i++) {
+    ASSERT_TRUE(lanes.may_start(SLOW, 2, false));
+    lanes.started(SLOW, 2);
+    ++key;
+  }
+  ASSERT_EQ(4u, lanes.get_ops_in_flight(SLOW));
+
+  // more items for the slow pool wait, up to the total cap...
+  const uint64_t max_files = 8;
+  while (lanes.may_defer(max_files)) {
+    ASSERT_FALSE(lanes.may_start(SLOW, 1, false));
+    lanes.defer(SLOW, ++key);
+    ops[key] = 1;
+  }
+  ASSERT_EQ(max_files * 2, lanes.get_deferred());
+
+  // ...while the other pool keeps going
+  for (int i = 0; i < 10; i++) {
+    ASSERT_TRUE(lanes.may_start(FAST, 4, false));
+    lanes.started(FAST, 4);
+    lanes.finished(FAST, 4);
+  }
+  ASSERT_EQ(0u, lanes.get_ops_in_flight(FAST));
+
+  // nothing fits until the slow pool completes something
+  std::vector<uint64_t> started;
+  auto get_ops = [&](uint64_t k) { return ops.at(k); };
+  auto start = [&](int64_t pool, uint64_t k) {
+    ASSERT_EQ(SLOW, pool);
+    started.push_back(k);
+    lanes.started(pool, ops.at(k));
+  };
+  lanes.start_deferred(false, get_ops, start);
+  ASSERT_TRUE(started.empty());
+
+  // completing one item lets two waiting items go, in order
+  lanes.finished(SLOW, 2);
+  lanes.start_deferred(false, get_ops, start);
+  ASSERT_EQ((std::vector<uint64_t>{3, 4}), started);
+  ASSERT_EQ(max_files * 2 - 2, lanes.get_deferred());
+  ASSERT_EQ(4u, lanes.get_ops_in_flight(SLOW));
+  ASSERT_TRUE(lanes.may_defer(max_files));
+
+  // a new item for the pool queues behind those still waiting even if
+  // the pool had room
+  lanes.finished(SLOW, 1);
+  ASSERT_FALSE(lanes.may_start(SLOW, 1, false));
+}
+
+TEST(MDSPurgeLanes, OneItemAlwaysRuns)
+{
+  PurgeLanes lanes;
+  lanes.set_op_limit(100);
+  lanes.set_pool_limit(SLOW, 2);
+  // larger than the pool's share, but the pool is idle
+  ASSERT_TRUE(lanes.may_start(SLOW, 10, false));
+  lanes.started(SLOW, 10);
+  ASSERT_FALSE(lanes.may_start(SLOW, 1, false));
+  // draining ignores the shares
+  ASSERT_TRUE(lanes.may_start(SLOW, 1, true));
+  // a pool without a share is only held by the global limit
+  ASSERT_TRUE(lanes.may_start(FAST, 50, false));
+}
+
+TEST(MDSPurgeLanes, DeferredRespectsGlobalLimit)
+{
+  PurgeLanes lanes;
+  lanes.set_op_limit(4);
+  lanes.set_pool_limit(SLOW, 4);
+  lanes.set_pool_limit(FAST, 4);
+  lanes.started(FAST, 4);
+  lanes.started(SLOW, 4);
+  lanes.defer(SLOW, 1);
+  lanes.finished(SLOW, 4);
+
+  int n = 0;
+  auto get_ops = [](uint64_t) { return 2; };
+  auto start = [&](int64_t pool, uint64_t) { n++; lanes.started(pool, 2); };
+  lanes.start_deferred(false, get_ops, start);
+  ASSERT_EQ(0, n);
+  lanes.finished(FAST, 4);
+  lanes.start_deferred(false, get_ops, start);
+  ASSERT_EQ(1, n);
+  ASSERT_EQ(0u, lanes.get_deferred());
+}
+
+TEST(MDSPurgeLanes, LatencyFeedback)
+{
+  PurgeLanes lanes;
+  lanes.set_op_limit(64);
+  auto now = ceph::coarse_mono_clock::now();
+
+  // above target: the limit comes down, at most once a second
+  ASSERT_TRUE(lanes.update_latency(2.0, 0.5, now));
+  ASSERT_EQ(48u, lanes.get_op_limit(false));
+  ASSERT_FALSE(lanes.update_latency(2.0, 0.5, now + 100ms));
+  ASSERT_EQ(48u, lanes.get_op_limit(false));
+  for (int i = 1; i < 20; i++)
+    lanes.update_latency(2.0, 0.5, now + i * 1s);
+  ASSERT_EQ(8u, lanes.get_op_limit(false));  // floor at an eighth
+  ASSERT_EQ(64u, lanes.get_op_limit(true));  // draining goes full speed
+
+  // below target: it recovers step by step
+  now += 20s;
+  double scale = lanes.get_scale();
+  for (int i = 0; i < 60; i++) {
+    lanes.update_latency(0.01, 0.5, now + i * 1s);
+    ASSERT_GE(lanes.get_scale(), scale);
+    scale = lanes.get_scale();
+  }
+  ASSERT_EQ(1.0, lanes.get_scale());
+  ASSERT_EQ(64u, lanes.get_op_limit(false));
+
+  // no target: no feedback
+  now += 100s;
+  for (int i = 0; i < 20; i++)
+    lanes.update_latency(2.0, 0.5, now + i * 1s);
+  ASSERT_LT(lanes.get_scale(), 1.0);
+  ASSERT_TRUE(lanes.update_latency(2.0, 0, now + 30s));
+  ASSERT_EQ(1.0, lanes.get_scale());
+}
@@ -0,0 +1,125 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#include "mds/ScrubHeader.h"
+#include "mds/ScrubThrottle.h"
+
+#include "gtest/gtest.h"
+
+using namespace std::chrono_literals;
+
+TEST(MDSScrubThrottle, Unlimited)
+{
+  ScrubThrottle t;
+  auto now = ceph::coarse_mono_clock::now();
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_EQ(0, t.wait(0, now));
+    t.take();
+  }
+}
+
+TEST(MDSScrubThrottle, Burst)
+{
+  ScrubThrottle t;
+  auto now = ceph::coarse_mono_clock::now();
+  // a full second's worth goes at once, then one inode per 1/rate
+  for (int i = 0; i < 10; i++) {
+    ASSERT_EQ(0, t.wait(10, now));
+    t.take();
+  }
+  ASSERT_DOUBLE_EQ(0.1, t.wait(10, now));
+  ASSERT_EQ(0, t.wait(10, now + 100ms));
+  t.take();
+  ASSERT_GT(t.wait(10, now + 100ms), 0);
+
+  // idle time refills the bucket, but only up to the burst
+  now += 1h;
+  for (int i = 0; i < 10; i++) {
+    ASSERT_EQ(0, t.wait(10, now));
+    t.take();
+  }
+  ASSERT_GT(t.wait(10, now), 0);
+}
+
+TEST(MDSScrubThrottle, SlowRate)
+{
+  ScrubThrottle t;
+  auto now = ceph::coarse_mono_clock::now();
+  // below one per second the burst is still one inode
+  ASSERT_EQ(0, t.wait(0.5, now));
+  t.take();
+  ASSERT_DOUBLE_EQ(2.0, t.wait(0.5, now));
+  ASSERT_EQ(0, t.wait(0.5, now + 2s));
+}
+
+TEST(MDSScrubThrottle, LimitChanges)
+{
+  ScrubThrottle t;
+  auto now = ceph::coarse_mono_clock::now();
+  ASSERT_EQ(0, t.wait(1, now));
+  t.take();
+  ASSERT_GT(t.wait(1, now), 0);
+  // lifting the limit lets everything through, and setting one again
+  // starts with a full bucket
+  ASSERT_EQ(0, t.wait(0, now));
+  t.take();
+  t.take();
+  ASSERT_EQ(0, t.wait(5, now));
+}
+
+TEST(MDSScrubProgress, Fields)
+{
+  ScrubHeader h("tag", false, false, true, false);
+  h.set_num_estimated(1000);
+  auto start = h.get_start_time();
+
+  auto p = h.get_progress(start);
+  ASSERT_EQ(0u, p.done);
+  ASSERT_EQ(1000u, p.estimated);
+  ASSERT_EQ(0, p.percent);
+  ASSERT_EQ(0, p.rate);
+  ASSERT_LT(p.eta, 0);  // unknown until something is done
+
+  for (int i = 0; i < 100; i++)
+    h.inc_num_scrubbed();
+  p = h.get_progress(start + 10s);
+  ASSERT_EQ(100u, p.done);
+  ASSERT_DOUBLE_EQ(10.0, p.percent);
+  ASSERT_DOUBLE_EQ(10.0, p.rate);
+  ASSERT_DOUBLE_EQ(90.0, p.eta);
+}
+
+TEST(MDSScrubProgress, SkippedSubtrees)
+{
+  ScrubHeader h("tag", false, false, true, false);
+  h.set_num_estimated(1000);
+  auto start = h.get_start_time();
+
+  // an unchanged subtree of 500 inodes counts as done, and the time
+  // left follows from the whole of what was done
+  for (int i = 0; i < 100; i++)
+    h.inc_num_scrubbed();
+  h.add_num_skipped(500);
+  auto p = h.get_progress(start + 10s);
+  ASSERT_EQ(600u, p.done);
+  ASSERT_DOUBLE_EQ(60.0, p.percent);
+  ASSERT_DOUBLE_EQ(10.0, p.rate);
+  ASSERT_NEAR(400.0 * 10 / 600, p.eta, 1e-9);
+
+  // the tree grew since the estimate: never past 100%
+  h.add_num_skipped(1000);
+  p = h.get_progress(start + 20s);
+  ASSERT_EQ(1600u, p.done);
+  ASSERT_EQ(1600u, p.estimated);
+  ASSERT_DOUBLE_EQ(100.0, p.percent);
+  ASSERT_EQ(0, p.eta);
+}
@@ -0,0 +1,87 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#include "mds/mdstypes.h"
+
+#include "gtest/gtest.h"
+
+static session_info_t make_session()
+{
+  session_info_t info;
+  info.inst.name = entity_name_t::CLIENT(4242);
+  info.auth_name.set_id("admin");
+  info.client_metadata["hostname"] = "client.example.com";
+  for (ceph_tid_t tid = 100; tid < 400; tid++)
+    info.completed_requests[tid] = (tid % 7 == 0) ?
+      inodeno_t(0x10000000000 + tid) : inodeno_t();
+  info.completed_requests[1ull << 40] = inodeno_t(0x10000000123);
+  info.prealloc_inos.insert(inodeno_t(0x10000000000), inodeno_t(1000));
+  info.prealloc_inos.insert(inodeno_t(0x10000002000), inodeno_t(1));
+  info.prealloc_inos.insert(inodeno_t(0x20000000000), inodeno_t(500));
+  info.completed_flushes.insert(12);
+  info.completed_flushes.insert(13);
+  return info;
+}
+
+static void check_same(const session_info_t& a, const session_info_t& b)
+{
+  ASSERT_EQ(a.inst, b.inst);
+  ASSERT_EQ(a.auth_name, b.auth_name);
+  ASSERT_EQ(a.client_metadata.kv_map, b.client_metadata.kv_map);
+  ASSERT_EQ(a.completed_requests, b.completed_requests);
+  ASSERT_EQ(a.prealloc_inos, b.prealloc_inos);
+  ASSERT_EQ(a.completed_flushes, b.completed_flushes);
+}
+
+TEST(MDSSessionInfo, Legacy)
+{
+  session_info_t info = make_session();
+  bufferlist bl;
+  info.encode(bl, CEPH_FEATURES_SUPPORTED_DEFAULT);
+  ASSERT_EQ(7, bl[0]);
+
+  session_info_t out;
+  auto p = bl.cbegin();
+  out.decode(p);
+  ASSERT_TRUE(p.end());
+  check_same(info, out);
+}
+
+TEST(MDSSessionInfo, Compact)
+{
+  session_info_t info = make_session();
+  bufferlist legacy, compact;
+  info.encode(legacy, CEPH_FEATURES_SUPPORTED_DEFAULT);
+  info.encode(compact, CEPH_FEATURES_SUPPORTED_DEFAULT, true);
+  ASSERT_EQ(8, compact[0]);
+  ASSERT_EQ(8, compact[1]);
+  ASSERT_LT(compact.length() * 3, legacy.length());
+
+  session_info_t out = make_session(); // decode replaces, not merges
+  out.completed_requests[5] = inodeno_t(5);
+  out.prealloc_inos.insert(inodeno_t(0x30000000000), inodeno_t(1));
+  auto p = compact.cbegin();
+  out.decode(p);
+  ASSERT_TRUE(p.end());
+  check_same(info, out);
+}
+
+TEST(MDSSessionInfo, CompactEmpty)
+{
+  session_info_t info;
+  bufferlist bl;
+  info.encode(bl, CEPH_FEATURES_SUPPORTED_DEFAULT, true);
+  session_info_t out;
+  auto p = bl.cbegin();
+  out.decode(p);
+  check_same(info, out);
+}
@@ -0,0 +1,152 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+/*
+ * Measures how fast journal events can be decoded for replay, in
+ * batches the way MDLog::_replay_decode() does it: handed to a decode
+ * pool that lives for the whole replay, against starting threads afresh
+ * for every batch.
+ *
+ * The events are synthetic EUpdates shaped like a small-file create
+ * workload: one dirlump per event carrying a number of primary dentries.
+ */
+
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "common/ceph_argparse.h"
+#include "common/Clock.h"
+#include "common/Thread.h"
+#include "global/global_init.h"
+#include "mds/ReplayDecodePool.h"
+#include "mds/CDir.h"
+#include "mds/CInode.h"
+#include "mds/LogEvent.h"
+#include "mds/events/EUpdate.h"
+
+using namespace std;
+
+static bufferlist make_event(uint64_t seq, int dentries)
+{
+  EUpdate le(nullptr, "openc");
+  dirfrag_t df(inodeno_t(0x10000000000 + seq / 1024), frag_t());
+  auto pf = CDir::allocate_fnode();
+  pf->version = seq;
+  auto& lump = le.metablob.add_dir(df, pf, true);
+  for (int i = 0; i < dentries; i++) {
+    auto pi = CInode::allocate_inode();
+    pi->ino = inodeno_t(0x20000000000 + seq * dentries + i);
+    pi->mode = S_IFREG | 0644;
+    pi->version = seq;
+    pi->ctime = pi->mtime = ceph_clock_now();
+    lump.add_dfull("file." + to_string(seq) + "." + to_string(i), "",
+		   snapid_t(2), CEPH_NOSNAP, seq, pi, fragtree_t(),
+		   CInode::xattr_map_const_ptr(), "", snapid_t(0),
+		   bufferlist(), EMetaBlob::fullbit::STATE_DIRTY,
+		   CInode::old_inode_map_const_ptr());
+  }
+  bufferlist bl;
+  le.encode_with_header(bl, CEPH_FEATURES_SUPPORTED_DEFAULT);
+  return bl;
+}
+
+static void decode_one(const bufferlist& bl)
+{
+  auto le = LogEvent::decode_event(bl.cbegin());
+  ceph_assert(le);
+  le->get_metablob()->decode_bits();
+}
+
+static double run_pooled(const vector<bufferlist>& events, size_t nthreads,
+			 size_t batch)
+{
+  utime_t start = ceph_clock_now();
+  ReplayDecodePool pool(nthreads);
+  for (size_t b = 0; b < events.size(); b += batch) {
+    size_t n = min(batch, events.size() - b);
+    pool.run(n, [&events, b](size_t i) { decode_one(events[b + i]); });
+  }
+  utime_t elapsed = ceph_clock_now() - start;
+  return events.size() / (double)elapsed;
+}
+
+static double run_spawned(const vector<bufferlist>& events, size_t nthreads,
+			  size_t batch)
+{
+  utime_t start = ceph_clock_now();
+  for (size_t b = 0; b < events.size(); b += batch) {
+    size_t end = min(b + batch, events.size());
+    vector<std::thread> workers;
+    for (size_t t = 1; t < nthreads; t++)
+      workers.push_back(make_named_thread("bench_decode",
+	[&events, b, end, t, nthreads]() {
+	  for (size_t i = b + t; i < end; i += nthreads)
+	    decode_one(events[i]);
+	}));
+    for (size_t i = b; i < end; i += nthreads)
+      decode_one(events[i]);
+    for (auto& w : workers)
+      w.join();
+  }
+  utime_t elapsed = ceph_clock_now() - start;
+  return events.size() / (double)elapsed;
+}
+
+void usage(const char *name) {
+  cout << name << " <events> <dentries> <threads> [batch]\n"
+       << "\t events: the number of journal events to decode.\n"
+       << "\t dentries: the number of dentries in each event.\n"
+       << "\t threads: the maximum number of decode threads to try.\n"
+       << "\t batch: events decoded together, 32 by default.\n";
+}
+
+int main(int argc, const char **argv)
+{
+  if (argc < 4) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  int num = atoi(argv[1]);
+  int dentries = atoi(argv[2]);
+  int threads = atoi(argv[3]);
+  int batch = argc > 4 ? atoi(argv[4]) : 32;
+  if (num < 1 || dentries < 0 || threads < 1 || batch < 1) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  auto args = argv_to_vec(argc, argv);
+  auto cct = global_init(NULL, args, CEPH_ENTITY_TYPE_MDS,
+			 CODE_ENVIRONMENT_UTILITY,
+			 CINIT_FLAG_NO_DEFAULT_CONFIG_FILE);
+  common_init_finish(g_ceph_context);
+
+  vector<bufferlist> events;
+  events.reserve(num);
+  uint64_t bytes = 0;
+  for (int i = 0; i < num; i++) {
+    events.push_back(make_event(i, dentries));
+    bytes += events.back().length();
+  }
+  cout << num << " events, " << dentries << " dentries per event, "
+       << bytes << " bytes" << std::endl;
+
+  for (int t = 1; t <= threads; t *= 2)
+    cout << t << " threads: " << run_pooled(events, t, batch)
+	 << " events/sec pooled, " << run_spawned(events, t, batch)
+	 << " events/sec with threads started per batch" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,175 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+/*
+ * Measures what SessionMap::save() costs against the number of dirty
+ * sessions: the mds_lock time spent encoding every dirty session into the
+ * one op that also carries the header, the size of that op in the legacy
+ * and the compact session encoding, and, given a pool, how long the OSD
+ * takes to apply it.
+ *
+ * The sessions are shaped like busy kernel clients: a full set of client
+ * metadata, a preallocated inode range and a number of completed
+ * requests, a tenth of which created an inode.
+ */
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "common/ceph_argparse.h"
+#include "common/Clock.h"
+#include "common/StackStringStream.h"
+#include "common/errno.h"
+#include "global/global_init.h"
+#include "include/rados/librados.hpp"
+#include "mds/mdstypes.h"
+
+using namespace std;
+
+static session_info_t make_session(int i, int completed)
+{
+  session_info_t info;
+  info.inst.name = entity_name_t::CLIENT(4100 + i);
+  info.auth_name.set_id("user" + to_string(i % 16));
+  info.client_metadata["hostname"] = "client" + to_string(i) + ".example.com";
+  info.client_metadata["kernel_version"] = "5.14.0-284.el9.x86_64";
+  info.client_metadata["entity_id"] = info.auth_name.get_id();
+  info.client_metadata["root"] = "/volumes/group/vol" + to_string(i % 64);
+  for (int t = 0; t < completed; t++) {
+    inodeno_t created = (t % 10 == 0) ? inodeno_t(0x10000000000 + i * 1000 + t)
+				      : inodeno_t();
+    info.completed_requests[1000 + t] = created;
+  }
+  info.prealloc_inos.insert(inodeno_t(0x20000000000 + i * 1000), 1000);
+  return info;
+}
+
+// returns bytes encoded
+static uint64_t build_save(const vector<session_info_t>& sessions, size_t count,
+			   uint64_t features, bool compact,
+			   map<string, bufferlist> *to_set)
+{
+  uint64_t bytes = 0;
+  to_set->clear();
+  for (size_t i = 0; i < count; i++) {
+    CachedStackStringStream css;
+    *css << sessions[i].inst.name;
+    bufferlist bl;
+    sessions[i].encode(bl, features, compact);
+    bytes += bl.length();
+    (*to_set)[std::string(css->strv())] = std::move(bl);
+  }
+  return bytes;
+}
+
+void usage(const char *name) {
+  cout << name << " [--pool <pool>] <sessions> <completed requests>\n"
+       << "\t sessions: the largest number of dirty sessions to try.\n"
+       << "\t completed requests: completed requests held by each session.\n"
+       << "\t --pool: also write each save to an object in this pool.\n";
+}
+
+int main(int argc, const char **argv)
+{
+  auto args = argv_to_vec(argc, argv);
+  auto cct = global_init(NULL, args, CEPH_ENTITY_TYPE_CLIENT,
+			 CODE_ENVIRONMENT_UTILITY,
+			 CINIT_FLAG_NO_DEFAULT_CONFIG_FILE);
+  common_init_finish(g_ceph_context);
+
+  string pool_name;
+  vector<const char*> pos;
+  string val;
+  for (auto i = args.begin(); i != args.end(); ) {
+    if (ceph_argparse_double_dash(args, i)) {
+      break;
+    } else if (ceph_argparse_witharg(args, i, &val, "--pool", "-p", (char*)NULL)) {
+      pool_name = val;
+    } else {
+      pos.push_back(*i);
+      ++i;
+    }
+  }
+  if (pos.size() != 2) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  int num = atoi(pos[0]);
+  int completed = atoi(pos[1]);
+  if (num < 1 || completed < 0) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  librados::Rados rados;
+  librados::IoCtx io;
+  const string oid = "bench_sessionmap";
+  if (!pool_name.empty()) {
+    if (rados.init_with_context(g_ceph_context) < 0 ||
+	rados.conf_read_file(NULL) < 0 ||
+	rados.connect() < 0) {
+      cerr << "couldn't connect to cluster!" << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (rados.ioctx_create(pool_name.c_str(), io) < 0) {
+      cerr << "couldn't open pool " << pool_name << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  vector<session_info_t> sessions;
+  sessions.reserve(num);
+  for (int i = 0; i < num; i++)
+    sessions.push_back(make_session(i, completed));
+
+  map<string, bufferlist> to_set;
+  bufferlist header;
+  encode((version_t)1, header);
+  for (int n = 1000 < num ? 1000 : num; ; n = min(n * 2, num)) {
+    const int rounds = 5;
+    const uint64_t legacy = build_save(sessions, n, CEPH_FEATURES_SUPPORTED_DEFAULT,
+				       false, &to_set);
+    uint64_t bytes = 0;
+    utime_t start = ceph_clock_now();
+    for (int r = 0; r < rounds; r++)
+      bytes = build_save(sessions, n, CEPH_FEATURES_SUPPORTED_DEFAULT, true,
+			 &to_set);
+    double ms = (double)(ceph_clock_now() - start) * 1000 / rounds;
+    cout << n << " sessions: encode " << ms << " ms, " << bytes << " bytes ("
+	 << legacy << " legacy)";
+
+    if (io.is_valid()) {
+      start = ceph_clock_now();
+      for (int r = 0; r < rounds; r++) {
+	librados::ObjectWriteOperation op;
+	op.omap_set_header(header);
+	op.omap_set(to_set);
+	int ret = io.operate(oid, &op);
+	if (ret < 0) {
+	  cerr << std::endl << "write failed: " << cpp_strerror(ret) << std::endl;
+	  return EXIT_FAILURE;
+	}
+      }
+      cout << ", write " << (double)(ceph_clock_now() - start) * 1000 / rounds
+	   << " ms";
+    }
+    cout << std::endl;
+    if (n == num)
+      break;
+  }
+
+  if (io.is_valid())
+    io.remove(oid);
+  return 0;
+}
@@ -17,6 +17,7 @@
 #include <string.h>
 #include <iostream>
 #include <memory>
+#include <thread>
 #include <time.h>
 #include <sys/mount.h>
 #include <boost/random/mersenne_twister.hpp>
@@ -6698,6 +6699,119 @@ TEST_P(StoreTestSpecificAUSize, TooManyBlobsTest) {
   doMany4KWritesTest(store.get(), 1, 1000, max_object, 4*1024, 0);
 }
 
+TEST_P(StoreTestSpecificAUSize, KVSyncShardsTest) {
+  if (string(GetParam()) != "bluestore")
+    return;
+  SetVal(g_conf(), "bluestore_kv_sync_shards", "4");
+  StartDeferred(0x10000);
+
+  // Collections get sequencers on different kv pipelines.  Each one's
+  // transactions must still commit in the order they were queued, and
+  // everything must be there after a remount.
+  const unsigned num_colls = 8, num_txns = 200, num_objs = 4, num_blocks = 16;
+  const unsigned block = 4096;
+  struct coll_state_t {
+    coll_t cid;
+    ObjectStore::CollectionHandle ch;
+    std::map<std::pair<unsigned, unsigned>, bufferlist> data;
+    std::atomic<unsigned> committed = {0};
+    std::atomic<bool> in_order = {true};
+  };
+  std::vector<coll_state_t> colls(num_colls);
+  auto obj = [](unsigned o) {
+    return ghobject_t(hobject_t(sobject_t("Object " + stringify(o),
+					  CEPH_NOSNAP)));
+  };
+
+  for (unsigned c = 0; c < num_colls; c++) {
+    colls[c].cid = coll_t(spg_t(pg_t(c, 1), shard_id_t::NO_SHARD));
+    colls[c].ch = store->create_new_collection(colls[c].cid);
+    ObjectStore::Transaction t;
+    t.create_collection(colls[c].cid, 0);
+    int r = queue_transaction(store, colls[c].ch, std::move(t));
+    ASSERT_EQ(r, 0);
+  }
+
+  ceph::mutex lock = ceph::make_mutex("KVSyncShardsTest::lock");
+  ceph::condition_variable cond;
+  unsigned done = 0;
+  std::vector<std::thread> writers;
+  for (unsigned c = 0; c < num_colls; c++) {
+    writers.emplace_back([&, c]() {
+      auto& cs = colls[c];
+      for (unsigned i = 0; i < num_txns; i++) {
+	unsigned o = i % num_objs, b = (i * 7) % num_blocks;
+	bufferlist bl;
+	bl.append(std::string(block, 'a' + (c + i) % 26));
+	bufferlist v;
+	v.append(stringify(i));
+	std::map<std::string, bufferlist> kv;
+	kv["last"] = v;
+	ObjectStore::Transaction t;
+	t.write(cs.cid, obj(o), b * block, block, bl);
+	t.omap_setkeys(cs.cid, obj(o), kv);
+	t.register_on_commit(new LambdaContext([&, i](int) {
+	  unsigned expected = i;
+	  if (!cs.committed.compare_exchange_strong(expected, i + 1))
+	    cs.in_order = false;
+	  std::lock_guard l(lock);
+	  ++done;
+	  cond.notify_all();
+	}));
+	cs.data[{o, b}] = bl;
+	store->queue_transaction(cs.ch, std::move(t));
+      }
+    });
+  }
+  for (auto& w : writers)
+    w.join();
+  {
+    std::unique_lock l(lock);
+    cond.wait(l, [&] { return done == num_colls * num_txns; });
+  }
+
+  auto verify = [&]() {
+    for (unsigned c = 0; c < num_colls; c++) {
+      auto& cs = colls[c];
+      ASSERT_TRUE(cs.in_order) << "collection " << c;
+      for (auto& [ob, expected] : cs.data) {
+	bufferlist in;
+	int r = store->read(cs.ch, obj(ob.first), ob.second * block, block, in);
+	ASSERT_EQ((int)block, r);
+	ASSERT_TRUE(bl_eq(expected, in));
+      }
+      for (unsigned o = 0; o < num_objs; o++) {
+	std::set<std::string> keys = {"last"};
+	std::map<std::string, bufferlist> got;
+	store->omap_get_values(cs.ch, obj(o), keys, &got);
+	ASSERT_EQ(1u, got.size());
+	// the last transaction on o wins
+	unsigned last = num_txns - 1 - ((num_txns - 1 - o) % num_objs);
+	ASSERT_EQ(stringify(last), got["last"].to_str());
+      }
+    }
+  };
+  verify();
+
+  for (auto& cs : colls)
+    cs.ch.reset();
+  EXPECT_EQ(store->umount(), 0);
+  ASSERT_EQ(store->fsck(false), 0);
+  EXPECT_EQ(store->mount(), 0);
+  for (auto& cs : colls)
+    cs.ch = store->open_collection(cs.cid);
+  verify();
+
+  for (auto& cs : colls) {
+    ObjectStore::Transaction t;
+    for (unsigned o = 0; o < num_objs; o++)
+      t.remove(cs.cid, obj(o));
+    t.remove_collection(cs.cid);
+    int r = queue_transaction(store, cs.ch, std::move(t));
+    ASSERT_EQ(r, 0);
+  }
+}
+
 #if defined(WITH_BLUESTORE)
 void get_mempool_stats(uint64_t* total_bytes, uint64_t* total_items)
 {
@@ -9003,6 +9117,56 @@ TEST_P(StoreTest, SpuriousReadErrorTest) {
   }
 }
 
+TEST_P(StoreTest, DeepFSCKReadErrorTest) {
+  if (string(GetParam()) != "bluestore")
+    return;
+
+  BlueStore* bstore = dynamic_cast<BlueStore*> (store.get());
+  const int num_objects = 8;
+  int r;
+  coll_t cid;
+  auto ch = store->create_new_collection(cid);
+  {
+    ObjectStore::Transaction t;
+    t.create_collection(cid, 0);
+    r = queue_transaction(store, ch, std::move(t));
+    ASSERT_EQ(r, 0);
+  }
+  bufferlist test_data;
+  bufferptr ap(0x2000);
+  memset(ap.c_str(), 'a', 0x2000);
+  test_data.append(ap);
+  for (int i = 0; i < num_objects; ++i) {
+    // each object and its clone share their blob
+    ghobject_t hoid(hobject_t(sobject_t("obj" + stringify(i), CEPH_NOSNAP)));
+    ghobject_t hoid2(hobject_t(sobject_t("obj" + stringify(i) + "_clone",
+					 CEPH_NOSNAP)));
+    ObjectStore::Transaction t;
+    t.write(cid, hoid, 0, 0x2000, test_data);
+    t.clone(cid, hoid, hoid2);
+    r = queue_transaction(store, ch, std::move(t));
+    ASSERT_EQ(r, 0);
+  }
+  ch.reset();
+  store->umount();
+  ASSERT_EQ(bstore->fsck(true), 0);
+
+  // every read the readers do fails its checksum, and each failure must
+  // reach the fsck result, whichever thread found it
+  SetVal(g_conf(), "bluestore_retry_disk_reads", "0");
+  SetVal(g_conf(), "bluestore_debug_inject_csum_err_probability", "1");
+  for (auto threads : {"4", "1", "0"}) {
+    cerr << "deep fsck with " << threads << " reader threads" << std::endl;
+    SetVal(g_conf(), "bluestore_fsck_deep_read_threads", threads);
+    g_ceph_context->_conf.apply_changes(nullptr);
+    ASSERT_EQ(bstore->fsck(true), num_objects * 2);
+  }
+  SetVal(g_conf(), "bluestore_debug_inject_csum_err_probability", "0");
+  g_ceph_context->_conf.apply_changes(nullptr);
+  ASSERT_EQ(bstore->fsck(true), 0);
+  store->mount();
+}
+
 TEST_P(StoreTest, mergeRegionTest) {
   if (string(GetParam()) != "bluestore")
     return;
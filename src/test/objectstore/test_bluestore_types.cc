@@ -1499,6 +1499,193 @@ TEST(GarbageCollector, BasicTest)
   }
 }
 
+// TwoQOnodeCacheShard is private to BlueStore.cc; its state shows in
+// Onode::cache_private
+static const uint8_t TWOQ_WARM_IN = 1;
+static const uint8_t TWOQ_HOT = 2;
+
+struct TwoQOnodeCache : public ::testing::Test {
+  BlueStore store;
+  PerfCounters *logger = nullptr;
+  BlueStore::OnodeCacheShard *oc = nullptr;
+  BlueStore::CollectionRef coll;
+
+  TwoQOnodeCache() : store(g_ceph_context, "", 4096) {}
+
+  void SetUp() override {
+    // the store's own counters, as a mounted store hands its caches
+    logger = const_cast<PerfCounters*>(store.get_perf_counters());
+
+    oc = BlueStore::OnodeCacheShard::create(g_ceph_context, "2q", logger);
+    oc->set_max(1000);
+    auto bc = BlueStore::BufferCacheShard::create(g_ceph_context, "lru", NULL);
+    coll = ceph::make_ref<BlueStore::Collection>(&store, oc, bc, coll_t());
+  }
+  void TearDown() override {
+    coll->onode_map.clear();
+    coll.reset();
+  }
+
+  static ghobject_t oid(const string& name) {
+    return ghobject_t(hobject_t(sobject_t(name, CEPH_NOSNAP)));
+  }
+  // load an onode into the cache, as a lookup miss does
+  BlueStore::OnodeRef load(const string& name) {
+    BlueStore::OnodeRef o(new BlueStore::Onode(coll.get(), oid(name), name));
+    o->exists = true;
+    return coll->onode_map.add(oid(name), o);
+  }
+  // cache_private of a cached onode, 0 if it is not cached
+  uint8_t state(const string& name) {
+    auto o = coll->onode_map.lookup(oid(name));
+    return o ? o->cache_private : 0;
+  }
+  void trim_to(uint64_t n) {
+    oc->set_max(n);
+    oc->trim();
+  }
+};
+
+TEST_F(TwoQOnodeCache, promote_from_ghost)
+{
+  for (auto n : {"a", "b", "c", "d"})
+    load(n);
+  ASSERT_EQ(4u, oc->_get_num());
+  ASSERT_EQ(TWOQ_WARM_IN, state("d"));
+
+  // the oldest warm onode goes first, and is remembered
+  trim_to(3);
+  ASSERT_EQ(3u, oc->_get_num());
+  ASSERT_EQ(0, state("a"));
+  ASSERT_EQ(TWOQ_WARM_IN, state("b"));
+
+  // loaded again after eviction: straight to hot
+  oc->set_max(1000);
+  ASSERT_EQ(TWOQ_HOT, load("a")->cache_private);
+  ASSERT_EQ(1u, logger->get(l_bluestore_onode_ghost_hits));
+  // a brand new onode is only warm
+  ASSERT_EQ(TWOQ_WARM_IN, load("e")->cache_private);
+  ASSERT_EQ(1u, logger->get(l_bluestore_onode_ghost_hits));
+}
+
+TEST_F(TwoQOnodeCache, scan_keeps_hot)
+{
+  for (auto n : {"hot", "x1", "x2"})
+    load(n);
+  trim_to(2);
+  ASSERT_EQ(0, state("hot"));
+  ASSERT_EQ(TWOQ_HOT, load("hot")->cache_private);
+  oc->set_max(3);
+
+  // a pass over many objects only churns warm_in
+  for (int i = 0; i < 20; i++)
+    load("scan" + stringify(i));
+  oc->trim();
+  ASSERT_EQ(3u, oc->_get_num());
+  ASSERT_EQ(TWOQ_HOT, state("hot"));
+  ASSERT_EQ(TWOQ_WARM_IN, state("scan19"));
+  ASSERT_EQ(0, state("scan0"));
+
+  // the ghost list is bounded too, so scan0 was forgotten long ago
+  ASSERT_EQ(TWOQ_WARM_IN, load("scan0")->cache_private);
+}
+
+TEST_F(TwoQOnodeCache, pin_unpin)
+{
+  auto a = load("a");
+  ASSERT_EQ(1u, oc->num_pinned.load());
+  ASSERT_EQ(1u, oc->_get_num());
+
+  // pinned onodes are not trimmed
+  trim_to(0);
+  ASSERT_EQ(1u, oc->_get_num());
+  ASSERT_EQ(TWOQ_WARM_IN, a->cache_private);
+
+  // using a warm onode again does not make it hot
+  a.reset();
+  ASSERT_EQ(0u, oc->num_pinned.load());
+  oc->set_max(1000);
+  for (int i = 0; i < 3; i++)
+    ASSERT_EQ(TWOQ_WARM_IN, state("a"));
+  ASSERT_EQ(1u, oc->_get_num());
+
+  // unpinned, it can be trimmed
+  load("b");
+  load("c");
+  trim_to(2);
+  ASSERT_EQ(2u, oc->_get_num());
+  ASSERT_EQ(0, state("a"));
+
+  // a hot onode stays hot across pin and unpin
+  oc->set_max(1000);
+  auto h = load("a");
+  ASSERT_EQ(TWOQ_HOT, h->cache_private);
+  ASSERT_EQ(1u, oc->num_pinned.load());
+  h.reset();
+  ASSERT_EQ(0u, oc->num_pinned.load());
+  ASSERT_EQ(TWOQ_HOT, state("a"));
+}
+
+TEST_F(TwoQOnodeCache, trim_warm_before_hot)
+{
+  for (auto n : {"h1", "h2", "w1", "w2", "w3", "w4"})
+    load(n);
+  trim_to(4);
+  ASSERT_EQ(0, state("h1"));
+  ASSERT_EQ(0, state("h2"));
+  oc->set_max(1000);
+  load("h1");
+  load("h2");
+  ASSERT_EQ(2u, logger->get(l_bluestore_onode_ghost_hits));
+  ASSERT_EQ(6u, oc->_get_num());
+
+  // kin is half of the target: warm_in is cut to 2 before hot is touched
+  trim_to(4);
+  ASSERT_EQ(4u, oc->_get_num());
+  ASSERT_EQ(TWOQ_HOT, state("h1"));
+  ASSERT_EQ(TWOQ_HOT, state("h2"));
+  ASSERT_EQ(0, state("w1"));
+  ASSERT_EQ(TWOQ_WARM_IN, state("w4"));
+
+  // then the least recently used hot onode goes
+  trim_to(1);
+  ASSERT_EQ(1u, oc->_get_num());
+  ASSERT_EQ(0, state("h1"));
+  ASSERT_EQ(TWOQ_HOT, state("h2"));
+
+  trim_to(0);
+  ASSERT_EQ(0u, oc->_get_num());
+}
+
+TEST_F(TwoQOnodeCache, hits_by_access_class)
+{
+  load("a");
+  ASSERT_EQ(TWOQ_WARM_IN, state("a"));
+  ASSERT_EQ(0, state("nope"));
+  ASSERT_EQ(1u, logger->get(l_bluestore_onode_client_hits));
+  ASSERT_EQ(1u, logger->get(l_bluestore_onode_client_misses));
+  {
+    ObjectStore::AccessClassScope scope(ObjectStore::access_class_t::SCRUB);
+    state("a");
+    state("nope");
+    state("nope");
+    {
+      ObjectStore::AccessClassScope inner(ObjectStore::access_class_t::RECOVERY);
+      state("a");
+    }
+  }
+  state("a");
+  ASSERT_EQ(2u, logger->get(l_bluestore_onode_client_hits));
+  ASSERT_EQ(1u, logger->get(l_bluestore_onode_client_misses));
+  ASSERT_EQ(1u, logger->get(l_bluestore_onode_scrub_hits));
+  ASSERT_EQ(2u, logger->get(l_bluestore_onode_scrub_misses));
+  ASSERT_EQ(1u, logger->get(l_bluestore_onode_recovery_hits));
+  ASSERT_EQ(0u, logger->get(l_bluestore_onode_recovery_misses));
+  ASSERT_EQ(0u, logger->get(l_bluestore_onode_other_hits));
+  ASSERT_EQ(4u, logger->get(l_bluestore_onode_hits));
+  ASSERT_EQ(3u, logger->get(l_bluestore_onode_misses));
+}
+
 TEST(BlueStoreRepairer, StoreSpaceTracker)
 {
   BlueStoreRepairer::StoreSpaceTracker bmap0;
@@ -14,6 +14,8 @@
 
 #include "common/strtol.h"
 #include "common/ceph_argparse.h"
+#include "common/ceph_json.h"
+#include "common/perf_counters.h"
 
 #define dout_context g_ceph_context
 #define dout_subsys ceph_subsys_filestore
@@ -32,7 +34,10 @@ static void usage()
       "	 --threads\n"
       "	       number of threads to carry out this workload\n"
       "	 --multi-object\n"
-    "	       have each thread write to a separate object\n" << std::endl;
+      "	       have each thread write to a separate object\n"
+      "	 --read\n"
+      "	       read the data back in the same blocks after writing it,\n"
+      "	       from a freshly mounted store\n" << std::endl;
   generic_server_usage();
 }
 
@@ -76,10 +81,11 @@ struct Config {
   int repeats;
   int threads;
   bool multi_object;
+  bool read;
   Config()
     : size(1048576), block_size(4096),
       repeats(1), threads(1),
-      multi_object(false) {}
+      multi_object(false), read(false) {}
 };
 
 class C_NotifyCond : public Context {
@@ -147,6 +153,52 @@ void osbench_worker(ObjectStore *os, const Config &cfg,
   }
 }
 
+void osbench_read_worker(ObjectStore *os, const Config &cfg,
+                         const coll_t cid, const ghobject_t oid,
+                         uint64_t starting_offset)
+{
+  ObjectStore::CollectionHandle ch = os->open_collection(cid);
+  ceph_assert(ch);
+
+  for (int i = 0; i < cfg.repeats; ++i) {
+    uint64_t offset = starting_offset;
+    size_t len = cfg.size;
+
+    std::cout << "Read cycle " << i << std::endl;
+    while (len) {
+      size_t count = len < cfg.block_size ? len : (size_t)cfg.block_size;
+
+      bufferlist bl;
+      int r = os->read(ch, oid, offset, count, bl);
+      ceph_assert(r == (int)count);
+
+      offset += count;
+      if (offset > cfg.size)
+        offset -= cfg.size;
+      len -= count;
+    }
+  }
+}
+
+// a counter of the store's own perf counters by name, 0 if it has no such
+// counter
+static uint64_t get_store_counter(ObjectStore *os, const std::string &name)
+{
+  const PerfCounters *logger = os->get_perf_counters();
+  if (!logger)
+    return 0;
+  JSONFormatter f;
+  logger->dump_formatted(&f, false, name);
+  std::stringstream ss;
+  f.flush(ss);
+  JSONParser p;
+  if (!p.parse(ss.str().c_str(), ss.str().length()))
+    return 0;
+  JSONObj *section = p.find_obj(logger->get_name());
+  JSONObj *counter = section ? section->find_obj(name) : nullptr;
+  return counter ? strtoull(counter->get_data().c_str(), nullptr, 10) : 0;
+}
+
 int main(int argc, const char *argv[])
 {
   // command-line arguments
@@ -190,6 +242,8 @@ int main(int argc, const char *argv[])
       cfg.threads = atoi(val.c_str());
     } else if (ceph_argparse_flag(args, i, "--multi-object", (char*)nullptr)) {
       cfg.multi_object = true;
+    } else if (ceph_argparse_flag(args, i, "--read", (char*)nullptr)) {
+      cfg.read = true;
     } else {
       derr << "Error: can't understand argument: " << *i << "\n" << dendl;
       exit(1);
@@ -206,6 +260,7 @@ int main(int argc, const char *argv[])
   dout(0) << "block-size " << cfg.block_size << dendl;
   dout(0) << "repeats " << cfg.repeats << dendl;
   dout(0) << "threads " << cfg.threads << dendl;
+  dout(0) << "read " << cfg.read << dendl;
 
   auto os =
       ObjectStore::create(g_ceph_context,
@@ -318,6 +373,47 @@ int main(int argc, const char *argv[])
       << duration.count() << "us, at a rate of " << rate << "/s and "
       << iops << " iops" << dendl;
 
+  if (cfg.read) {
+    // remount, so that the reads come from the device and not from what
+    // the writes left in the cache
+    ch.reset();
+    os->umount();
+    if (os->mount() < 0) {
+      derr << "remount failed" << dendl;
+      return 1;
+    }
+    ch = os->open_collection(cid);
+    ceph_assert(ch);
+
+    // what each read cost besides the device: bytes of decompressed blobs
+    // (the only copies the store counts), and bytes of holes served
+    // without allocating
+    uint64_t copied = get_store_counter(os.get(), "bluestore_read_copied_bytes");
+    uint64_t zeros = get_store_counter(os.get(), "bluestore_read_zero_bytes");
+
+    t1 = high_resolution_clock::now();
+    for (int i = 0; i < cfg.threads; i++) {
+      const auto &oid = cfg.multi_object ? oids[i] : oids[0];
+      workers.emplace_back(osbench_read_worker, os.get(), std::ref(cfg),
+                           cid, oid, i * cfg.size / cfg.threads);
+    }
+    for (auto &worker : workers)
+      worker.join();
+    t2 = high_resolution_clock::now();
+    workers.clear();
+
+    duration = duration_cast<microseconds>(t2 - t1);
+    rate = (1000000LL * total) / duration.count();
+    iops = (1000000LL * total / cfg.block_size) / duration.count();
+    size_t reads = (total + cfg.block_size - 1) / cfg.block_size;
+    copied = get_store_counter(os.get(), "bluestore_read_copied_bytes") - copied;
+    zeros = get_store_counter(os.get(), "bluestore_read_zero_bytes") - zeros;
+    dout(0) << "Read " << total << " in "
+        << duration.count() << "us, at a rate of " << rate << "/s and "
+        << iops << " iops; " << copied / reads << " bytes copied and "
+        << zeros / reads << " bytes of shared zeros per read" << dendl;
+  }
+
   // remove the objects
   ObjectStore::Transaction t;
   for (const auto &oid : oids)
@@ -221,6 +221,15 @@ TEST(mempool, vector)
   }
 }
 
+TEST(mempool, container_size)
+{
+  // the allocator is stateless, so accounting costs no per-container space
+  static_assert(std::is_empty_v<mempool::osd::pool_allocator<int>>);
+  EXPECT_EQ(sizeof(mempool::osd::vector<int>), sizeof(std::vector<int>));
+  EXPECT_EQ(sizeof(mempool::osd::map<int,int>), sizeof(std::map<int,int>));
+  EXPECT_EQ(sizeof(mempool::osd::string), sizeof(std::string));
+}
+
 TEST(mempool, set)
 {
   mempool::osd::set<int> set_int;
@@ -404,6 +413,77 @@ TEST(mempool, btree_map_test)
   ASSERT_EQ(0, mempool::osd::allocated_bytes());
 }
 
+struct toggled_t {
+  int a = 0;
+};
+
+struct toggled_obj {
+  MEMPOOL_CLASS_HELPERS();
+  int a = 0;
+};
+MEMPOOL_DEFINE_OBJECT_FACTORY(toggled_obj, toggled_obj, unittest_2);
+
+static ssize_t by_type_items(mempool::pool_index_t ix, const char *type)
+{
+  mempool::stats_t total;
+  map<std::string,mempool::stats_t> by_type;
+  mempool::get_pool(ix).get_stats(&total, &by_type);
+  for (auto& [name, s] : by_type) {
+    if (name.find(type) != std::string::npos) {
+      return s.items;
+    }
+  }
+  return 0;
+}
+
+TEST(mempool, debug_mode_toggle)
+{
+  // std::list allocates one node per element
+  auto items = [] {
+    return by_type_items(mempool::unittest_1::id, "toggled_t");
+  };
+
+  mempool::set_debug_mode(false);
+  auto old = std::make_unique<mempool::unittest_1::list<toggled_t>>(10);
+  std::vector<toggled_obj*> objs;
+  for (int i = 0; i < 5; ++i) {
+    objs.push_back(new toggled_obj);
+  }
+
+  // what was allocated before debug mode was switched on is counted too
+  mempool::set_debug_mode(true);
+  EXPECT_EQ(10, items());
+  auto cur = std::make_unique<mempool::unittest_1::list<toggled_t>>(3);
+  EXPECT_EQ(13, items());
+
+  // and so is what changes while it is off
+  mempool::set_debug_mode(false);
+  cur.reset();
+  old->resize(4);
+  mempool::set_debug_mode(true);
+  EXPECT_EQ(4, items());
+  cur = std::make_unique<mempool::unittest_1::list<toggled_t>>(2);
+  EXPECT_EQ(6, items());
+
+  old.reset();
+  EXPECT_EQ(2, items());
+  cur.reset();
+  EXPECT_EQ(0, items());
+  EXPECT_EQ(0u, mempool::unittest_1::allocated_items());
+
+  EXPECT_EQ(5, by_type_items(mempool::unittest_2::id, "toggled_obj"));
+  mempool::set_debug_mode(false);
+  delete objs.back();
+  objs.pop_back();
+  mempool::set_debug_mode(true);
+  EXPECT_EQ(4, by_type_items(mempool::unittest_2::id, "toggled_obj"));
+  for (auto o : objs) {
+    delete o;
+  }
+  EXPECT_EQ(0, by_type_items(mempool::unittest_2::id, "toggled_obj"));
+  EXPECT_EQ(0u, mempool::unittest_2::allocated_items());
+}
+
 TEST(mempool, check_shard_select)
 {
   const size_t samples = mempool::num_shards * 100;